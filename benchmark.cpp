@@ -0,0 +1,891 @@
+// Benchmarks de rendimiento (no forman parte de las pruebas de main.cpp).
+// Compilar: g++ -std=c++17 -O2 -march=native benchmark.cpp -o benchmark
+// Los fallos de cache se pueden medir con: perf stat -e cache-misses ./benchmark
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <fstream>
+#include <mutex>
+#include <new>
+#include <random>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "bplus_tree.h"
+#include "btree.h"
+#include "btree_map.h"
+#include "concurrent_btree.h"
+#include "durable_btree.h"
+#include "cow_btree.h"
+#include "fixed_btree.h"
+#include "paged_btree.h"
+#include "sharded_btree.h"
+
+using namespace std;
+
+// contador global de reservas de memoria
+static atomic<size_t> TotalAllocs{0};
+
+void* operator new(size_t sz) {
+  TotalAllocs++;
+  if (void* p = std::malloc(sz ? sz : 1)) return p;
+  throw std::bad_alloc();
+}
+void* operator new(size_t sz, std::align_val_t al) {
+  TotalAllocs++;
+  size_t a = static_cast<size_t>(al);
+  if (void* p = std::aligned_alloc(a, (sz + a - 1) / a * a)) return p;
+  throw std::bad_alloc();
+}
+// todos los delete reemplazados liberan por aca: fuera de linea, para que
+// GCC no empareje el free con los new de arriba (-Wmismatched-new-delete)
+__attribute__((noinline)) static void release_block(void* p) noexcept { std::free(p); }
+
+void operator delete(void* p) noexcept { release_block(p); }
+void operator delete(void* p, size_t) noexcept { release_block(p); }
+void operator delete(void* p, std::align_val_t) noexcept { release_block(p); }
+void operator delete(void* p, size_t, std::align_val_t) noexcept { release_block(p); }
+
+using Clock = chrono::steady_clock;
+
+static double elapsed_ms(Clock::time_point t0) {
+  return chrono::duration<double, milli>(Clock::now() - t0).count();
+}
+
+static vector<int> random_keys(size_t n, unsigned seed) {
+  vector<int> keys(n);
+  mt19937 rng(seed);
+  for (auto& k : keys) k = static_cast<int>(rng() & 0x7fffffff);
+  return keys;
+}
+
+// BTree<TK> (M en tiempo de ejecucion) vs FixedBTree<TK, M>
+template <int M>
+void bench_fixed_order(const vector<int>& keys, const vector<int>& probes) {
+  size_t a0 = TotalAllocs;
+  BTree<int>* dyn = new BTree<int>(M);
+  for (int k : keys) dyn->insert(k);
+  size_t dyn_allocs = TotalAllocs - a0;
+
+  a0 = TotalAllocs;
+  FixedBTree<int, M>* fix = new FixedBTree<int, M>();
+  for (int k : keys) fix->insert(k);
+  size_t fix_allocs = TotalAllocs - a0;
+
+  size_t hits = 0;
+  auto t0 = Clock::now();
+  for (int k : probes) hits += dyn->search(k);
+  double dyn_ms = elapsed_ms(t0);
+
+  t0 = Clock::now();
+  for (int k : probes) hits += fix->search(k);
+  double fix_ms = elapsed_ms(t0);
+
+  printf("M=%-4d allocs BTree=%zu FixedBTree=%zu | lookup ns BTree=%.1f FixedBTree=%.1f (hits=%zu)\n", M,
+         dyn_allocs, fix_allocs, dyn_ms * 1e6 / probes.size(), fix_ms * 1e6 / probes.size(), hits);
+  delete dyn;
+  delete fix;
+}
+
+// huella de memoria con hojas sin arreglo de hijos vs un bloque uniforme
+// (keys + M + 1 hijos) para todos los nodos
+void bench_leaf_layout(long long N, int M) {
+  vector<long long> keys(N);
+  for (long long i = 0; i < N; ++i) keys[i] = 2 * i;
+  BTree<long long>* tree = BTree<long long>::build_from_ordered_vector(keys, M);
+  keys.clear();
+  keys.shrink_to_fit();
+
+  size_t nodes = tree->node_count();
+  double split_mb = tree->memory_used() / 1048576.0;
+  double uniform_mb = nodes * tree->internal_node_bytes() / 1048576.0;
+  printf("N=%lld M=%d hojas=%zu internos=%zu | bytes/nodo hoja=%zu interno=%zu\n", N, M, tree->leaf_count(),
+         tree->internal_count(), tree->leaf_node_bytes(), tree->internal_node_bytes());
+  printf("  memoria: uniforme=%.1f MB separada=%.1f MB (%.1f%% menos)\n", uniform_mb, split_mb,
+         100.0 * (uniform_mb - split_mb) / uniform_mb);
+  delete tree;
+}
+
+// rangeSearch del arbol B clasico vs el modo B+ con hojas enlazadas
+void bench_range_scan(const vector<int>& keys, int M) {
+  BTree<int> classic(M);
+  BPlusTree<int> plus(M);
+  for (int k : keys) {
+    classic.insert(k);
+    plus.insert(k);
+  }
+  mt19937 rng(7);
+  for (size_t span : {size_t(100), size_t(10000), size_t(1000000)}) {
+    const int reps = span >= 1000000 ? 5 : 200;
+    vector<int> starts(reps);
+    for (int& s : starts) s = static_cast<int>(rng() & 0x7fffffff);
+    // ancho del rango en el espacio de keys para obtener ~span resultados
+    long long width = (long long)0x7fffffff / (long long)keys.size() * (long long)span;
+
+    size_t total = 0;
+    auto t0 = Clock::now();
+    for (int s : starts) total += classic.rangeSearch(s, (int)min<long long>(s + width, 0x7fffffff)).size();
+    double classic_ms = elapsed_ms(t0);
+
+    t0 = Clock::now();
+    for (int s : starts) total += plus.rangeSearch(s, (int)min<long long>(s + width, 0x7fffffff)).size();
+    double plus_ms = elapsed_ms(t0);
+
+    printf("M=%-4d ~%zu keys/rango | ms BTree=%.2f BPlusTree=%.2f (total=%zu)\n", M, span, classic_ms, plus_ms,
+           total);
+  }
+}
+
+// lookups de a 10k: bucle de search vs searchBatch (con y sin ordenar)
+void bench_batch_lookup(size_t N, int M) {
+  BTree<int> tree(M);
+  vector<int> keys = random_keys(N, 3);
+  for (int k : keys) tree.insert(k);
+  vector<int> probes = random_keys(2000000, 4);
+  for (size_t i = 0; i < probes.size(); i += 2) probes[i] = keys[i % keys.size()];
+
+  const size_t kBatch = 10000;
+  static bool found[10000];
+  size_t hits = 0;
+  auto t0 = Clock::now();
+  for (int k : probes) hits += tree.search(k);
+  double loop_ms = elapsed_ms(t0);
+
+  double batch_ms[2];
+  for (int sorted = 0; sorted < 2; ++sorted) {
+    t0 = Clock::now();
+    for (size_t b = 0; b < probes.size(); b += kBatch) {
+      size_t cnt = min(kBatch, probes.size() - b);
+      tree.searchBatch(probes.data() + b, cnt, found, sorted);
+      for (size_t i = 0; i < cnt; ++i) hits += found[i];
+    }
+    batch_ms[sorted] = elapsed_ms(t0);
+  }
+  printf("N=%zu M=%-4d ns/lookup search=%.1f searchBatch=%.1f searchBatch(sorted)=%.1f (hits=%zu)\n", N, M,
+         loop_ms * 1e6 / probes.size(), batch_ms[0] * 1e6 / probes.size(), batch_ms[1] * 1e6 / probes.size(), hits);
+
+  // lotes densos: cada lote cae en una ventana chica del rango de keys, asi
+  // las busquedas ordenadas comparten casi todo el camino
+  vector<int> sorted_keys = keys;
+  sort(sorted_keys.begin(), sorted_keys.end());
+  mt19937 rng(5);
+  for (size_t b = 0; b < probes.size(); b += kBatch) {
+    size_t start = rng() % (sorted_keys.size() - 4 * kBatch);
+    for (size_t i = b; i < min(b + kBatch, probes.size()); ++i) probes[i] = sorted_keys[start + rng() % (4 * kBatch)];
+  }
+  for (int sorted = 0; sorted < 2; ++sorted) {
+    t0 = Clock::now();
+    for (size_t b = 0; b < probes.size(); b += kBatch) {
+      size_t cnt = min(kBatch, probes.size() - b);
+      tree.searchBatch(probes.data() + b, cnt, found, sorted);
+      for (size_t i = 0; i < cnt; ++i) hits += found[i];
+    }
+    batch_ms[sorted] = elapsed_ms(t0);
+  }
+  printf("N=%zu M=%-4d lotes densos: ns/lookup searchBatch=%.1f searchBatch(sorted)=%.1f (hits=%zu)\n", N, M,
+         batch_ms[0] * 1e6 / probes.size(), batch_ms[1] * 1e6 / probes.size(), hits);
+
+  // los mismos lotes ya ordenados por quien llama: sorted no ordena de nuevo
+  for (size_t b = 0; b < probes.size(); b += kBatch) sort(probes.begin() + b, probes.begin() + min(b + kBatch, probes.size()));
+  for (int sorted = 0; sorted < 2; ++sorted) {
+    t0 = Clock::now();
+    for (size_t b = 0; b < probes.size(); b += kBatch) {
+      size_t cnt = min(kBatch, probes.size() - b);
+      tree.searchBatch(probes.data() + b, cnt, found, sorted);
+      for (size_t i = 0; i < cnt; ++i) hits += found[i];
+    }
+    batch_ms[sorted] = elapsed_ms(t0);
+  }
+  printf("N=%zu M=%-4d lotes densos ya ordenados: ns/lookup searchBatch=%.1f searchBatch(sorted)=%.1f (hits=%zu)\n", N,
+         M, batch_ms[0] * 1e6 / probes.size(), batch_ms[1] * 1e6 / probes.size(), hits);
+}
+
+// lote ordenado sobre un arbol existente: insert por key vs insertSorted
+void bench_insert_sorted(size_t base_n, size_t batch_n, bool append, int M) {
+  vector<int> base(base_n), batch(batch_n);
+  for (size_t i = 0; i < base_n; ++i) base[i] = static_cast<int>(2 * i);
+  mt19937 rng(5);
+  for (size_t i = 0; i < batch_n; ++i)
+    batch[i] = append ? static_cast<int>(2 * base_n + i) : static_cast<int>(rng() % (2 * base_n)) | 1;
+  sort(batch.begin(), batch.end());
+
+  BTree<int>* a = BTree<int>::build_from_ordered_vector(base, M);
+  BTree<int>* b = BTree<int>::build_from_ordered_vector(base, M);
+  auto t0 = Clock::now();
+  for (int k : batch) a->insert(k);
+  double loop_ms = elapsed_ms(t0);
+  t0 = Clock::now();
+  b->insertSorted(batch);
+  double bulk_ms = elapsed_ms(t0);
+  printf("base=%zu lote=%zu %s M=%-4d | ms insert=%.1f insertSorted=%.1f (nodos %zu vs %zu)\n", base_n, batch_n,
+         append ? "al final" : "mezclado", M, loop_ms, bulk_ms, a->node_count(), b->node_count());
+  delete a;
+  delete b;
+}
+
+// build_from_ordered_vector con 1..8 hilos
+void bench_parallel_build(long long N, int M) {
+  vector<long long> keys(N);
+  for (long long i = 0; i < N; ++i) keys[i] = 2 * i;
+  for (unsigned threads : {1u, 2u, 4u, 8u}) {
+    auto t0 = Clock::now();
+    BTree<long long>* tree = BTree<long long>::build_from_ordered_vector(keys, M, threads);
+    double ms = elapsed_ms(t0);
+    printf("N=%lld M=%d hilos=%u | build ms=%.1f\n", N, M, threads, ms);
+    delete tree;
+  }
+}
+
+// keys desordenadas y con repetidas: insert por key vs build_from_unsorted
+void bench_build_unsorted(size_t N, int M) {
+  vector<int> keys = random_keys(N, 6);
+  for (size_t i = 0; i < N; i += 10) keys[i] = keys[i / 2];  // ~10% repetidas
+
+  auto t0 = Clock::now();
+  BTree<int> loop(M);
+  for (int k : keys) loop.insert(k);
+  double loop_ms = elapsed_ms(t0);
+
+  for (unsigned threads : {1u, 4u}) {
+    vector<int> copy = keys;
+    t0 = Clock::now();
+    BTree<int>* tree = BTree<int>::build_from_unsorted(std::move(copy), M, threads);
+    double build_ms = elapsed_ms(t0);
+    printf("N=%zu M=%d | ms insert=%.1f build_from_unsorted(hilos=%u)=%.1f (keys %d vs %d)\n", N, M, loop_ms,
+           threads, build_ms, loop.size(), tree->size());
+    delete tree;
+  }
+}
+
+// mezcla 95% search / 5% insert-remove; cada hilo escribe solo keys propias
+// (k % threads == t) para poder verificar el contenido final
+template <typename Tree, typename Search, typename Write>
+static double run_mixed(Tree& tree, unsigned threads, size_t ops_per_thread, int key_space, Search search,
+                        Write write) {
+  atomic<long long> hits{0};
+  vector<thread> workers;
+  auto t0 = Clock::now();
+  for (unsigned t = 0; t < threads; ++t) {
+    workers.emplace_back([&, t] {
+      mt19937 rng(100 + t);
+      long long local = 0;
+      for (size_t i = 0; i < ops_per_thread; ++i) {
+        int k = static_cast<int>(rng() % key_space);
+        if (rng() % 100 < 5) {
+          k = k - k % static_cast<int>(threads) + static_cast<int>(t);
+          write(tree, k, (i & 1) != 0);
+        } else {
+          local += search(tree, k);
+        }
+      }
+      hits += local;
+    });
+  }
+  for (thread& w : workers) w.join();
+  return elapsed_ms(t0);
+}
+
+void bench_concurrent(int M) {
+  const int key_space = 2000000;
+  const size_t total_ops = 4000000;
+
+  for (unsigned threads : {1u, 2u, 4u, 8u, 16u, 32u}) {
+    size_t per_thread = total_ops / threads;
+
+    ConcurrentBTree<int> olc(M);
+    for (int k = 0; k < key_space; k += 2) olc.insert(k);
+    double olc_ms = run_mixed(
+        olc, threads, per_thread, key_space, [](ConcurrentBTree<int>& t, int k) { return t.search(k); },
+        [](ConcurrentBTree<int>& t, int k, bool ins) {
+          if (ins)
+            t.insert(k);
+          else
+            t.remove(k);
+        });
+
+    BTree<int> locked(M);
+    for (int k = 0; k < key_space; k += 2) locked.insert(k);
+    mutex mtx;
+    double mtx_ms = run_mixed(
+        locked, threads, per_thread, key_space,
+        [&mtx](BTree<int>& t, int k) {
+          lock_guard<mutex> lock(mtx);
+          return t.search(k);
+        },
+        [&mtx](BTree<int>& t, int k, bool ins) {
+          lock_guard<mutex> lock(mtx);
+          if (ins)
+            t.insert(k);
+          else
+            t.remove(k);
+        });
+
+    // ambos arboles recibieron las mismas operaciones en el mismo orden por hilo
+    bool same = olc.check_properties() && olc.size() == locked.size() &&
+                olc.rangeSearch(0, key_space) == locked.rangeSearch(0, key_space);
+    printf("hilos=%2u M=%d | Mops/s olc=%.2f mutex global=%.2f | %s\n", threads, M, total_ops / olc_ms / 1000,
+           total_ops / mtx_ms / 1000, same ? "ok" : "ERROR");
+  }
+}
+
+// costo de escribir con snapshots vivos: copia de camino vs BTree sin versiones
+void bench_snapshots(size_t N, size_t writes, int M) {
+  vector<int> keys = random_keys(N, 7);
+  vector<int> ops = random_keys(writes, 8);
+
+  BTree<int> plain(M);
+  CowBTree<int> cow(M);
+  for (int k : keys) {
+    plain.insert(k);
+    cow.insert(k);
+  }
+
+  auto t0 = Clock::now();
+  for (size_t i = 0; i < writes; ++i) (i & 1) ? plain.remove(keys[i]) : (void)plain.insert(ops[i]);
+  double plain_ms = elapsed_ms(t0);
+
+  // un snapshot nuevo cada 1000 escrituras, como un lector de reportes; se
+  // mantienen vivos los ultimos 8 (y el primero, para verificarlo al final)
+  CowBTree<int>::Snapshot first = cow.snapshot();
+  int base_size = cow.size();
+  deque<CowBTree<int>::Snapshot> snaps;
+  size_t taken = 0;
+  size_t a0 = TotalAllocs;
+  t0 = Clock::now();
+  double snap_ms = 0;
+  for (size_t i = 0; i < writes; ++i) {
+    if (i % 1000 == 0) {
+      auto s0 = Clock::now();
+      snaps.push_back(cow.snapshot());
+      snap_ms += elapsed_ms(s0);
+      taken++;
+      if (snaps.size() > 8) snaps.pop_front();
+    }
+    (i & 1) ? (void)cow.remove(keys[i]) : (void)cow.insert(ops[i]);
+  }
+  double cow_ms = elapsed_ms(t0);
+  size_t cow_allocs = TotalAllocs - a0;
+
+  bool same = cow.rangeSearch(0, INT_MAX) == plain.rangeSearch(0, INT_MAX) && first.size() == base_size &&
+              first.rangeSearch(0, INT_MAX).size() == static_cast<size_t>(base_size);
+  printf("N=%zu M=%d escrituras=%zu | ms BTree=%.1f cow=%.1f (%zu snapshots, %.3f ms en snapshot()) | nodos copiados=%zu "
+         "reservas=%zu | %s\n",
+         N, M, writes, plain_ms, cow_ms, taken, snap_ms, cow.copied_nodes(), cow_allocs, same ? "ok" : "ERROR");
+}
+
+// keys con distribucion Zipf(s) sobre [0, universe): las mas frecuentes son
+// las mas chicas, asi la carga se concentra en un rango
+static vector<int> zipf_keys(size_t n, int universe, double s, unsigned seed) {
+  vector<double> cdf(universe);
+  double sum = 0;
+  for (int r = 0; r < universe; ++r) cdf[r] = sum += 1.0 / pow(r + 1.0, s);
+  mt19937 rng(seed);
+  uniform_real_distribution<double> u(0, sum);
+  vector<int> keys(n);
+  for (auto& k : keys) k = static_cast<int>(std::lower_bound(cdf.begin(), cdf.end(), u(rng)) - cdf.begin());
+  return keys;
+}
+
+// inserciones concurrentes: ShardedBTree vs un BTree con un mutex global
+void bench_sharded_insert(const char* name, const vector<int>& keys, unsigned shards, int M) {
+  for (unsigned threads : {1u, 2u, 4u, 8u}) {
+    auto run = [&](auto&& insert) {
+      vector<thread> workers;
+      auto t0 = Clock::now();
+      for (unsigned t = 0; t < threads; ++t)
+        workers.emplace_back([&, t] {
+          for (size_t i = t; i < keys.size(); i += threads) insert(keys[i]);
+        });
+      for (thread& w : workers) w.join();
+      return elapsed_ms(t0);
+    };
+
+    ShardedBTree<int> sharded(M, shards);
+    double sharded_ms = run([&](int k) { sharded.insert(k); });
+
+    BTree<int> locked(M);
+    mutex mtx;
+    double mutex_ms = run([&](int k) {
+      lock_guard<mutex> lock(mtx);
+      locked.insert(k);
+    });
+
+    vector<int> sizes = sharded.shard_sizes();
+    printf("%s hilos=%u | Mops/s sharded=%.2f mutex global=%.2f | shards=%zu rebalanceos=%d max/min shard=%d/%d | %s\n",
+           name, threads, keys.size() / sharded_ms / 1000, keys.size() / mutex_ms / 1000, sizes.size(),
+           sharded.rebalance_count(), *std::max_element(sizes.begin(), sizes.end()),
+           *std::min_element(sizes.begin(), sizes.end()),
+           sharded.size() == locked.size() && sharded.check_properties() ? "ok" : "ERROR");
+  }
+}
+
+// exportar la mitad del arbol: rangeSearch secuencial vs repartido entre hilos
+template <typename Aug>
+void bench_parallel_range(const char* name, long long N, int M) {
+  vector<int> elements(N);
+  for (long long i = 0; i < N; ++i) elements[i] = static_cast<int>(2 * i);
+  BTree<int, Aug>* tree = BTree<int, Aug>::build_from_ordered_vector(elements, M);
+  int a = static_cast<int>(N / 2), b = static_cast<int>(N / 2 + N);  // la mitad central
+
+  auto t0 = Clock::now();
+  size_t expected = tree->rangeSearch(a, b).size();
+  double seq_ms = elapsed_ms(t0);
+  printf("%s N=%lld M=%d | ms secuencial=%.1f", name, N, M, seq_ms);
+  for (unsigned threads : {2u, 4u, 8u}) {
+    t0 = Clock::now();
+    size_t got = tree->rangeSearch(a, b, threads).size();
+    printf(" hilos=%u:%.1f%s", threads, elapsed_ms(t0), got == expected ? "" : "(ERROR)");
+  }
+  printf(" (%zu keys)\n", expected);
+  delete tree;
+}
+
+// reinicio: toString + parseo + reconstruccion vs save/load binario vs mmap
+void bench_persistence(long long N, int M, const string& path) {
+  vector<int> elements(N);
+  for (long long i = 0; i < N; ++i) elements[i] = static_cast<int>(3 * i);
+  BTree<int>* tree = BTree<int>::build_from_ordered_vector(elements, M);
+  vector<int> probes = random_keys(1000000, 11);
+  for (int& k : probes) k %= static_cast<int>(3 * N);
+
+  auto t0 = Clock::now();
+  string text = tree->toString(",");
+  vector<int> parsed;
+  for (const char* p = text.c_str(); *p;) {
+    char* next;
+    parsed.push_back(static_cast<int>(strtol(p, &next, 10)));
+    p = *next ? next + 1 : next;
+  }
+  delete BTree<int>::build_from_ordered_vector(parsed, M);
+  double text_ms = elapsed_ms(t0);
+
+  t0 = Clock::now();
+  tree->save(path);
+  double save_ms = elapsed_ms(t0);
+
+  t0 = Clock::now();
+  BTree<int>* loaded = BTree<int>::load(path);
+  double load_ms = elapsed_ms(t0);
+
+  t0 = Clock::now();
+  MappedBTree<int> mapped(path);
+  double open_ms = elapsed_ms(t0);
+  t0 = Clock::now();
+  bool first = mapped.search(probes[0]);
+  double first_us = elapsed_ms(t0) * 1000;
+
+  t0 = Clock::now();
+  size_t hits_mem = 0, hits_map = 0;
+  for (int k : probes) hits_mem += tree->search(k);
+  double mem_ms = elapsed_ms(t0);
+  t0 = Clock::now();
+  for (int k : probes) hits_map += mapped.search(k);
+  double map_ms = elapsed_ms(t0);
+
+  bool ok = loaded->size() == tree->size() && hits_mem == hits_map && first == tree->search(probes[0]);
+  printf("N=%lld M=%d | ms texto+reconstruccion=%.0f save=%.0f load=%.0f mmap=%.3f (primer search %.0f us) | "
+         "archivo=%.1f MB | 1M search ms memoria=%.0f mmap=%.0f | %s\n",
+         N, M, text_ms, save_ms, load_ms, open_ms, first_us, mapped.file_size() / 1e6, mem_ms, map_ms,
+         ok ? "ok" : "ERROR");
+  delete loaded;
+  delete tree;
+  remove(path.c_str());
+}
+
+// carga de un archivo de keys ordenadas: vector + build_from_ordered_vector vs
+// build_from_file (streaming) con cantidad conocida y desconocida
+void bench_stream_build(long long N, int M, const string& path) {
+  {
+    vector<int> keys(N);
+    for (long long i = 0; i < N; ++i) keys[i] = static_cast<int>(2 * i);
+    FILE* f = fopen(path.c_str(), "wb");
+    fwrite(keys.data(), sizeof(int), keys.size(), f);
+    fclose(f);
+  }
+
+  auto t0 = Clock::now();
+  vector<int> staged(N);
+  FILE* f = fopen(path.c_str(), "rb");
+  size_t got = fread(staged.data(), sizeof(int), staged.size(), f);
+  fclose(f);
+  BTree<int>* a = BTree<int>::build_from_ordered_vector(staged, M);
+  double vector_ms = elapsed_ms(t0);
+  size_t staging_bytes = staged.capacity() * sizeof(int);
+  vector<int>().swap(staged);
+
+  t0 = Clock::now();
+  BTree<int>* b = BTree<int>::build_from_file(path, M);
+  double known_ms = elapsed_ms(t0);
+
+  t0 = Clock::now();
+  ifstream in(path, ios::binary);
+  BTree<int>* c = BTree<int>::build_from_stream(in, M);
+  double unknown_ms = elapsed_ms(t0);
+
+  bool ok = got == static_cast<size_t>(N) && a->size() == b->size() && b->size() == c->size() && c->check_properties();
+  printf("N=%lld M=%d | ms vector=%.0f stream(cantidad conocida)=%.0f stream(desconocida)=%.0f | arbol=%.0f MB, vector "
+         "intermedio evitado=%.0f MB | %s\n",
+         N, M, vector_ms, known_ms, unknown_ms, b->memory_reserved() / 1e6, staging_bytes / 1e6, ok ? "ok" : "ERROR");
+  delete a;
+  delete b;
+  delete c;
+  remove(path.c_str());
+}
+
+// WAL: inserciones por segundo con cada politica de fsync y tiempo de
+// recuperacion segun el largo del log
+void bench_durability(const string& dir) {
+  const pair<FsyncPolicy, const char*> policies[] = {
+      {FsyncPolicy::Always, "always"}, {FsyncPolicy::Interval, "interval 10ms"}, {FsyncPolicy::Never, "never"}};
+  for (auto& [policy, name] : policies) {
+    for (unsigned threads : {1u, 4u}) {
+      filesystem::remove_all(dir);
+      size_t ops = policy == FsyncPolicy::Always ? 20000 : 1000000;
+      DurabilityOptions opts;
+      opts.fsync = policy;
+      DurableBTree<int> tree(dir, 64, opts);
+      vector<thread> workers;
+      auto t0 = Clock::now();
+      for (unsigned t = 0; t < threads; ++t)
+        workers.emplace_back([&, t] {
+          for (size_t i = t; i < ops; i += threads) tree.insert(static_cast<int>(i));
+        });
+      for (thread& w : workers) w.join();
+      tree.sync();
+      double ms = elapsed_ms(t0);
+      printf("fsync=%-13s hilos=%u | %.0f inserts/s\n", name, threads, ops / ms * 1000);
+    }
+  }
+
+  for (size_t log_len : {10000ul, 100000ul, 1000000ul}) {
+    filesystem::remove_all(dir);
+    {
+      DurabilityOptions opts;
+      opts.fsync = FsyncPolicy::Never;
+      DurableBTree<int> tree(dir, 64, opts);
+      for (size_t i = 0; i < 1000000; ++i) tree.insert(static_cast<int>(2 * i));
+      tree.checkpoint();
+      for (size_t i = 0; i < log_len; ++i) tree.insert(static_cast<int>(2 * i + 1));
+    }
+    auto t0 = Clock::now();
+    DurableBTree<int> recovered(dir, 64);
+    double ms = elapsed_ms(t0);
+    printf("recuperacion: checkpoint de 1M + log de %zu registros | %.0f ms (%zu reaplicados, %s)\n", log_len, ms,
+           recovered.replayed_records(), recovered.size() == static_cast<int>(1000000 + log_len) ? "ok" : "ERROR");
+  }
+  filesystem::remove_all(dir);
+}
+
+// arbol en disco con un buffer pool mucho menor que el arbol. Las lecturas
+// pasan por la cache de paginas del sistema operativo: los tiempos miden el
+// costo de pool + syscalls, no el de un disco frio
+void bench_paged(size_t N, size_t pool_pages, const string& path) {
+  remove(path.c_str());
+  vector<int> keys = random_keys(N, 13);
+  PagedBTree<int> tree(path, pool_pages);
+
+  auto report = [&](const char* name, size_t ops, double ms) {
+    const BufferPool::Stats& s = tree.statistics();
+    printf("%-12s | %8.0f ops/s | aciertos %5.1f%% | lecturas %8zu | escrituras %8zu\n", name, ops / ms * 1000,
+           100 * tree.hit_rate(), s.page_reads, s.page_writes);
+    tree.reset_statistics();
+  };
+
+  auto t0 = Clock::now();
+  for (int k : keys) tree.insert(k);
+  tree.flush();
+  report("insert", N, elapsed_ms(t0));
+  printf("M=%d, %zu paginas de %zu bytes (%.1fx el pool de %zu paginas)\n", tree.order(), tree.page_count(),
+         tree.page_bytes(), static_cast<double>(tree.page_count()) / pool_pages, pool_pages);
+
+  vector<int> probes = random_keys(N, 14);
+  size_t found = 0;
+  t0 = Clock::now();
+  for (int k : probes) found += tree.search(k);
+  report("search", N, elapsed_ms(t0));
+
+  mt19937 rng(15);
+  size_t scanned = 0;
+  const int ranges = 2000;
+  t0 = Clock::now();
+  for (int i = 0; i < ranges; ++i) {
+    int a = static_cast<int>(rng() % (1u << 30));
+    scanned += tree.rangeSearch(a, a + (1 << 20)).size();
+  }
+  report("rangeSearch", ranges, elapsed_ms(t0));
+  printf("(%zu encontradas, %zu keys recorridas, %s)\n", found, scanned, tree.check_properties() ? "ok" : "ERROR");
+  remove(path.c_str());
+}
+
+// datos asociados a cada key: BTree + unordered_map aparte vs BTreeMap
+void bench_map(size_t N, int M) {
+  struct Payload {
+    long long a = 0, b = 0;
+  };
+  vector<int> keys = random_keys(N, 16);
+  vector<int> probes = random_keys(N, 17);
+  for (size_t i = 0; i < probes.size(); i += 2) probes[i] = keys[i];
+
+  long long sum = 0;
+  double ms[2][2];
+  {
+    BTree<int> tree(M);
+    unordered_map<int, Payload> values;
+    auto t0 = Clock::now();
+    for (int k : keys) {
+      tree.insert(k);
+      values[k] = {k, 1};
+    }
+    ms[0][0] = elapsed_ms(t0);
+    t0 = Clock::now();
+    for (int k : probes) {
+      if (!tree.search(k)) continue;
+      sum += values.find(k)->second.a;
+    }
+    ms[0][1] = elapsed_ms(t0);
+  }
+  {
+    BTreeMap<int, Payload> tree(M);
+    auto t0 = Clock::now();
+    for (int k : keys) tree.insert_or_assign(k, Payload{k, 1});
+    ms[1][0] = elapsed_ms(t0);
+    t0 = Clock::now();
+    for (int k : probes) {
+      if (const Payload* v = tree.find(k)) sum -= v->a;
+    }
+    ms[1][1] = elapsed_ms(t0);
+  }
+  printf("N=%zu M=%-4d | BTree + unordered_map: insert %.0f ns, busqueda %.0f ns | BTreeMap: insert %.0f ns, "
+         "busqueda %.0f ns (%s)\n",
+         N, M, ms[0][0] * 1e6 / N, ms[0][1] * 1e6 / N, ms[1][0] * 1e6 / N, ms[1][1] * 1e6 / N, sum == 0 ? "ok" : "ERROR");
+}
+
+// keys string fuera del SSO: insert/remove con movimientos y busqueda con
+// string_view (Compare transparente) vs construir un string por busqueda
+void bench_string_keys(size_t N, int M) {
+  vector<string> keys(N);
+  mt19937 rng(18);
+  for (string& k : keys) k = "usuario/" + to_string(rng()) + "/sesion/" + to_string(rng() % 1000);
+  vector<char> text;  // las mismas keys como texto plano, sin string
+  vector<pair<size_t, size_t>> spans;
+  for (const string& k : keys) {
+    spans.push_back({text.size(), k.size()});
+    text.insert(text.end(), k.begin(), k.end());
+  }
+
+  BTree<string, NoAugment, less<>> tree(M);
+  vector<string> copy = keys;
+  auto t0 = Clock::now();
+  for (string& k : copy) tree.insert(std::move(k));
+  double insert_ms = elapsed_ms(t0);
+
+  size_t found = 0;
+  t0 = Clock::now();
+  for (auto& sp : spans) found += tree.search(string(text.data() + sp.first, sp.second));
+  double string_ms = elapsed_ms(t0);
+  t0 = Clock::now();
+  for (auto& sp : spans) found += tree.search(string_view(text.data() + sp.first, sp.second));
+  double view_ms = elapsed_ms(t0);
+
+  t0 = Clock::now();
+  for (size_t i = 0; i < N; i += 2) tree.remove(keys[i]);
+  double remove_ms = elapsed_ms(t0);
+  printf("N=%zu M=%-4d | insert(move) %.0f ns | search(string) %.0f ns, search(string_view) %.0f ns | remove %.0f ns "
+         "(%s)\n",
+         N, M, insert_ms * 1e6 / N, string_ms * 1e6 / N, view_ms * 1e6 / N, remove_ms * 2e6 / N,
+         found == 2 * N && tree.check_properties() ? "ok" : "ERROR");
+}
+
+// insert/remove recursivos bottom-up vs iterativos top-down
+template <typename Update>
+void time_updates(const vector<int>& keys, int M, double& insert_ns, double& remove_ns, bool& ok) {
+  BTree<int, NoAugment, less<int>, Update> tree(M);
+  auto t0 = Clock::now();
+  for (int k : keys) tree.insert(k);
+  insert_ns = elapsed_ms(t0) * 1e6 / keys.size();
+  t0 = Clock::now();
+  for (size_t i = 0; i < keys.size(); i += 2) tree.remove(keys[i]);
+  remove_ns = elapsed_ms(t0) * 2e6 / keys.size();
+  ok = ok && tree.check_properties();
+}
+
+void bench_update_policy(size_t N) {
+  vector<int> keys = random_keys(N, 19);
+  for (int M : {3, 4, 8, 16, 32, 64, 128, 256}) {
+    double bi, br, ti, tr;
+    bool ok = true;
+    time_updates<BottomUp>(keys, M, bi, br, ok);
+    if (M % 2 != 0) {
+      printf("M=%-4d | bottom-up insert %4.0f ns, remove %4.0f ns | top-down: requiere M par\n", M, bi, br);
+      continue;
+    }
+    time_updates<TopDown>(keys, M, ti, tr, ok);
+    printf("M=%-4d | bottom-up insert %4.0f ns, remove %4.0f ns | top-down insert %4.0f ns, remove %4.0f ns (%s)\n", M,
+           bi, br, ti, tr, ok ? "ok" : "ERROR");
+  }
+}
+
+// ingesta secuencial (ascendente y descendente, por el borde cacheado) vs
+// keys al azar: throughput y ocupacion de los nodos resultantes
+void bench_sequential_ingest(size_t N, int M) {
+  vector<int> random = random_keys(N, 23);
+  vector<int> ascending(N);
+  for (size_t i = 0; i < N; ++i) ascending[i] = static_cast<int>(i);
+  vector<int> descending(ascending.rbegin(), ascending.rend());
+  for (auto& c : {make_pair("ascendente", &ascending), make_pair("descendente", &descending),
+                  make_pair("al azar", &random)}) {
+    BTree<int> tree(M);
+    auto t0 = Clock::now();
+    for (int k : *c.second) tree.insert(k);
+    double ms = elapsed_ms(t0);
+    printf("N=%zu M=%-4d %-11s | insert %5.1f ns | fill %.3f | altura %d | nodos %zu | %.1f MB (%s)\n", N, M, c.first,
+           ms * 1e6 / N, tree.fill_factor(), tree.height(), tree.node_count(), tree.memory_used() / 1048576.0,
+           tree.check_properties() ? "ok" : "ERROR");
+  }
+}
+
+// arbol tras insert/remove al azar (queda al 55-60%) vs compact a dos
+// ocupaciones y vs compact_step de a max_leaves hojas: ocupacion, altura,
+// memoria, busquedas y pausas
+void bench_compaction(size_t N, int M, size_t max_leaves) {
+  vector<int> keys = random_keys(N, 29);
+  vector<int> probes = random_keys(N, 31);
+  for (size_t i = 0; i < N; i += 2) probes[i] = keys[i];
+  auto churn = [&](BTree<int>& tree) {
+    for (int k : keys) tree.insert(k);
+    for (size_t i = 0; i < N; i += 5) {
+      tree.remove(keys[i]);
+      tree.remove(keys[i + 2]);
+    }
+  };
+  auto report = [&](const char* name, BTree<int>& tree, double ms, double pause_us) {
+    auto t0 = Clock::now();
+    size_t found = 0;
+    for (int k : probes) found += tree.search(k);
+    double search_ns = elapsed_ms(t0) * 1e6 / probes.size();
+    printf("N=%zu M=%-4d %-22s | fill %.3f | altura %d | %.1f MB | search %.0f ns", N, M, name, tree.fill_factor(),
+           tree.height(), tree.memory_used() / 1048576.0, search_ns);
+    if (ms >= 0) printf(" | %.0f ms", ms);
+    if (pause_us >= 0) printf(", pausa max %.0f us", pause_us);
+    printf(" (%s)\n", found > 0 && tree.check_properties() ? "ok" : "ERROR");
+  };
+
+  for (double fill : {1.0, 0.7}) {
+    BTree<int> tree(M);
+    churn(tree);
+    if (fill == 1.0) report("tras insert/remove", tree, -1, -1);
+    auto t0 = Clock::now();
+    tree.compact(fill);
+    report(fill == 1.0 ? "compact(1.0)" : "compact(0.7)", tree, elapsed_ms(t0), -1);
+  }
+
+  BTree<int> tree(M);
+  churn(tree);
+  double total = 0, pause = 0;
+  bool more = true;
+  while (more) {
+    auto t0 = Clock::now();
+    more = tree.compact_step(max_leaves);
+    double ms = elapsed_ms(t0);
+    total += ms;
+    pause = std::max(pause, ms * 1e3);
+  }
+  char name[64];
+  snprintf(name, sizeof(name), "compact_step(%zu)", max_leaves);
+  report(name, tree, total, pause);
+}
+
+int main(int argc, char** argv) {
+  // argv[1]: cantidad de keys para el reporte de memoria (por defecto 100M)
+  long long footprint_n = argc > 1 ? atoll(argv[1]) : 100000000LL;
+
+  const size_t N = 2000000;
+  vector<int> keys = random_keys(N, 1);
+  vector<int> probes = random_keys(N, 2);
+  for (size_t i = 0; i < probes.size(); i += 2) probes[i] = keys[i];
+
+  printf("== Orden fijo en tiempo de compilacion (N=%zu) ==\n", N);
+  bench_fixed_order<16>(keys, probes);
+  bench_fixed_order<32>(keys, probes);
+  bench_fixed_order<64>(keys, probes);
+  bench_fixed_order<128>(keys, probes);
+  bench_fixed_order<256>(keys, probes);
+
+  printf("\n== Recorrido de rangos: B clasico vs B+ ==\n");
+  bench_range_scan(keys, 16);
+  bench_range_scan(keys, 128);
+
+  printf("\n== Busquedas en lote con prefetch ==\n");
+  bench_batch_lookup(20000000, 16);
+  bench_batch_lookup(20000000, 64);
+
+  printf("\n== Insercion de lotes ordenados ==\n");
+  bench_insert_sorted(10000000, 2000000, true, 64);
+  bench_insert_sorted(10000000, 200000, false, 64);
+  bench_insert_sorted(10000000, 2000000, false, 64);
+  bench_insert_sorted(2000000, 4000000, true, 64);
+
+  printf("\n== Construccion paralela (hardware_concurrency=%u) ==\n", thread::hardware_concurrency());
+  bench_parallel_build(50000000, 64);
+
+  printf("\n== Construccion desde keys desordenadas ==\n");
+  bench_build_unsorted(10000000, 64);
+
+  printf("\n== Lectores y escritores concurrentes (95/5) ==\n");
+  bench_concurrent(64);
+
+  printf("\n== Snapshots copy-on-write ==\n");
+  bench_snapshots(2000000, 1000000, 16);
+  bench_snapshots(2000000, 1000000, 64);
+
+  printf("\n== Inserciones concurrentes en shards por rango (16 shards) ==\n");
+  bench_sharded_insert("uniforme", random_keys(4000000, 9), 16, 64);
+  bench_sharded_insert("zipf 0.99", zipf_keys(4000000, 50000000, 0.99, 10), 16, 64);
+
+  printf("\n== rangeSearch paralelo ==\n");
+  bench_parallel_range<NoAugment>("sin tamaños", 20000000, 64);
+  bench_parallel_range<SubtreeSize>("SubtreeSize", 20000000, 64);
+
+  printf("\n== Persistencia binaria y mmap ==\n");
+  bench_persistence(10000000, 64, "benchmark_tree.bin");
+
+  printf("\n== Carga en streaming desde archivo ==\n");
+  bench_stream_build(20000000, 64, "benchmark_keys.bin");
+
+  printf("\n== WAL y checkpoints ==\n");
+  bench_durability("benchmark_wal");
+
+  printf("\n== Arbol en disco con buffer pool (pool de 4 MB) ==\n");
+  bench_paged(3000000, 1024, "benchmark_paged.db");
+
+  printf("\n== Valores por key: indice aparte vs BTreeMap ==\n");
+  bench_map(4000000, 16);
+  bench_map(4000000, 64);
+
+  printf("\n== Keys string: movimientos y busqueda heterogenea ==\n");
+  bench_string_keys(1000000, 16);
+  bench_string_keys(1000000, 64);
+
+  printf("\n== insert/remove bottom-up (recursivo) vs top-down (iterativo) ==\n");
+  bench_update_policy(2000000);
+
+  printf("\n== Ingesta secuencial por el borde del arbol ==\n");
+  bench_sequential_ingest(10000000, 16);
+  bench_sequential_ingest(10000000, 64);
+  bench_sequential_ingest(10000000, 256);
+
+  printf("\n== Compactacion tras insert/remove ==\n");
+  bench_compaction(4000000, 16, 256);
+  bench_compaction(4000000, 64, 256);
+
+  printf("\n== Layout separado de hojas e internos ==\n");
+  bench_leaf_layout(footprint_n, 128);
+  return 0;
+}
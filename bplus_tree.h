@@ -0,0 +1,415 @@
+#ifndef BPLUS_TREE_H
+#define BPLUS_TREE_H
+#include <iostream>
+#include <memory_resource>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+#include "node.h"
+#include "node_pool.h"
+#include "node_search.h"
+using namespace std;
+
+// Modo B+ del arbol: todas las keys viven en las hojas, los nodos internos
+// solo guardan copias separadoras y las hojas estan enlazadas (next/prev).
+// Un rangeSearch es un unico descenso hasta la primera hoja y luego un
+// recorrido secuencial por la lista de hojas.
+//
+// Invariante de separadores: para keys[i] de un nodo interno, todas las keys
+// de children[i] son < keys[i] y todas las de children[i + 1] son >= keys[i].
+template <typename TK>
+class BPlusTree {
+  //La implementación de este BTree no soporta valores repetidos
+ public:
+  using node_type = BPlusNode<TK>;
+
+ private:
+  node_type* root;
+  node_type* head;  // hoja mas a la izquierda
+  node_type* tail;  // hoja mas a la derecha
+  int M;  // grado u orden del arbol
+  int n;  // total de elementos en el arbol
+  NodePool<TK, node_type> pool;  // origen de todos los nodos del arbol
+
+ public:
+  BPlusTree(int _M) : root(nullptr), head(nullptr), tail(nullptr), M(_M), n(0), pool(_M) {
+    if (M < 3) throw std::invalid_argument("M debe ser al menos 3");
+  }
+
+  // politica de memoria: slabs pedidos a upstream, opcionalmente con huge pages
+  BPlusTree(int _M, pmr::memory_resource* upstream, bool huge_pages = false)
+      : root(nullptr), head(nullptr), tail(nullptr), M(_M), n(0), pool(_M, upstream, huge_pages) {
+    if (M < 3) throw std::invalid_argument("M debe ser al menos 3");
+  }
+
+  BPlusTree(const BPlusTree&) = delete;
+  BPlusTree& operator=(const BPlusTree&) = delete;
+
+  //indica si se encuentra o no un elemento
+  bool search(TK key) {
+    if (!root) return false;
+    node_type* leaf = find_leaf(key);
+    int pos = node_lower_bound(leaf->keys, leaf->count, key);
+    return pos < leaf->count && leaf->keys[pos] == key;
+  }
+
+  void insert(TK key) {
+    //caso1: arbol sin raiz
+    if (!root) {
+      root = head = tail = pool.create(true);
+      root->keys[0] = key;
+      root->count = 1;
+      n = 1;
+      return;
+    }
+
+    //caso2: insertar normalmente
+    TK promoted_key;
+    node_type* new_child = insert_rec(root, key, promoted_key);
+    if (!new_child) return;
+
+    //caso3: split en la raiz
+    node_type* new_root = pool.create(false);
+    new_root->keys[0] = promoted_key;
+    new_root->count = 1;
+    new_root->children[0] = root;
+    new_root->children[1] = new_child;
+    root = new_root;
+  }
+
+  void remove(TK key) {
+    if (!root) return;
+    if (!remove_rec(root, key)) return;
+    n--;
+    // Si la raíz quedó vacía pero tiene un hijo, promoverlo
+    if (root->count == 0 && !root->leaf) {
+      node_type* old_root = root;
+      root = root->children[0];
+      pool.destroy(old_root);
+    }
+    // Si el árbol quedó completamente vacío
+    if (root->count == 0 && root->leaf) {
+      pool.destroy(root);
+      root = head = tail = nullptr;
+    }
+  }
+
+  //altura del arbol. Considerar altura 0 para arbol vacio
+  int height() {
+    if (!root) return 0;
+    int cont = 0;
+    for (node_type* temp = root; !temp->leaf; temp = temp->children[0]) cont++;
+    return cont;
+  }
+
+  // recorrido en orden por la lista de hojas
+  string toString(const string& sep) {
+    string out;
+    bool first = true;
+    for (node_type* leaf = head; leaf; leaf = leaf->next) {
+      for (int i = 0; i < leaf->count; ++i) {
+        if (!first) out += sep;
+        out += std::to_string(leaf->keys[i]);
+        first = false;
+      }
+    }
+    return out;
+  }
+
+  // un descenso hasta la hoja de begin y luego recorrido secuencial de hojas
+  vector<TK> rangeSearch(TK begin, TK end) {
+    vector<TK> out;
+    if (!root) return out;
+    if (end < begin) std::swap(begin, end);
+    node_type* leaf = find_leaf(begin);
+    int i = node_lower_bound(leaf->keys, leaf->count, begin);
+    while (leaf) {
+      // traer la siguiente hoja mientras se recorre la actual, sin leerla
+      if (leaf->next) pool.prefetch(leaf->next);
+      for (; i < leaf->count; ++i) {
+        if (end < leaf->keys[i]) return out;
+        out.push_back(leaf->keys[i]);
+      }
+      leaf = leaf->next;
+      i = 0;
+    }
+    return out;
+  }
+
+  // mínimo valor del árbol
+  TK minKey() {
+    if (!root) throw runtime_error("El árbol está vacío");
+    return head->keys[0];
+  }
+
+  // máximo valor del árbol
+  TK maxKey() {
+    if (!root) throw runtime_error("El árbol está vacío");
+    return tail->keys[tail->count - 1];
+  }
+
+  // eliminar todos lo elementos del arbol: se devuelven los slabs completos,
+  // O(#slabs) si TK es trivialmente destructible
+  void clear() {
+    if constexpr (!is_trivially_destructible<TK>::value) {
+      if (root) destroy_subtree(root);
+    }
+    pool.release();
+    root = head = tail = nullptr;
+    n = 0;
+  }
+
+  // estadisticas del reservador de nodos
+  size_t node_count() const { return pool.live_nodes(); }
+  size_t memory_used() const { return pool.bytes_used(); }
+
+  int size() const { return n; }
+
+  // Verifique las propiedades de un árbol B+
+  bool check_properties() {
+    if (!root) return head == nullptr && tail == nullptr && n == 0;
+    int leaf_level = -1;
+    node_type* prev_leaf = nullptr;
+    long long total = 0;
+    if (!check(root, true, 1, nullptr, nullptr, leaf_level, prev_leaf, total)) return false;
+    return prev_leaf == tail && tail->next == nullptr && head->prev == nullptr && total == n;
+  }
+
+  ~BPlusTree() {
+    clear();
+  }
+
+ private:
+  // indice del hijo por el que descender: cantidad de separadores <= key
+  static int child_index(node_type* node, const TK& key) {
+    int idx = node_lower_bound(node->keys, node->count, key);
+    if (idx < node->count && !(key < node->keys[idx])) idx++;
+    return idx;
+  }
+
+  node_type* find_leaf(const TK& key) {
+    node_type* node = root;
+    while (!node->leaf) node = node->children[child_index(node, key)];
+    return node;
+  }
+
+  // metodos para la insercion
+  // hoja: la mitad derecha se mueve a un nodo nuevo y su primera key sube como copia
+  node_type* split_leaf(node_type* node, TK& promoted_key) {
+    int mid_idx = M / 2;
+    node_type* right = pool.create(true);
+    int j = 0;
+    for (int i = mid_idx; i < node->count; i++) right->keys[j++] = node->keys[i];
+    right->count = j;
+    node->count = mid_idx;
+    promoted_key = right->keys[0];
+
+    // enlazar la nueva hoja
+    right->next = node->next;
+    right->prev = node;
+    if (node->next)
+      node->next->prev = right;
+    else
+      tail = right;
+    node->next = right;
+    return right;
+  }
+
+  // interno: igual que en el arbol B, la key del medio sube
+  node_type* split_internal(node_type* node, TK& promoted_key) {
+    int mid_idx = M / 2;
+    promoted_key = node->keys[mid_idx];
+    node_type* right = pool.create(false);
+    int j = 0;
+    for (int i = mid_idx + 1; i < node->count; i++) right->keys[j++] = node->keys[i];
+    right->count = j;
+    for (int i = mid_idx + 1, k = 0; i <= node->count; i++, k++) {
+      right->children[k] = node->children[i];
+      node->children[i] = nullptr;
+    }
+    node->count = mid_idx;
+    return right;
+  }
+
+  node_type* insert_rec(node_type* node, const TK& key, TK& promoted_key) {
+    if (node->leaf) {
+      int pos = node_lower_bound(node->keys, node->count, key);
+      if (pos < node->count && node->keys[pos] == key) return nullptr;  // llave duplicada
+      for (int i = node->count; i > pos; i--) node->keys[i] = node->keys[i - 1];
+      node->keys[pos] = key;
+      node->count++;
+      n++;
+      if (node->count == M) return split_leaf(node, promoted_key);
+      return nullptr;
+    }
+
+    int child_idx = child_index(node, key);
+    TK child_promoted_key;
+    node_type* new_child = insert_rec(node->children[child_idx], key, child_promoted_key);
+    if (!new_child) return nullptr;
+
+    for (int i = node->count; i > child_idx; i--) {
+      node->keys[i] = node->keys[i - 1];
+      node->children[i + 1] = node->children[i];
+    }
+    node->keys[child_idx] = child_promoted_key;
+    node->children[child_idx + 1] = new_child;
+    node->count++;
+    if (node->count == M) return split_internal(node, promoted_key);
+    return nullptr;
+  }
+
+  // metodos para la eliminacion
+  // los separadores iguales a la key borrada pueden quedarse: siguen
+  // cumpliendo el invariante y no hace falta subir a corregirlos
+  bool remove_rec(node_type* node, const TK& key) {
+    if (node->leaf) {
+      int pos = node_lower_bound(node->keys, node->count, key);
+      if (pos == node->count || !(node->keys[pos] == key)) return false;
+      for (int i = pos; i < node->count - 1; i++) node->keys[i] = node->keys[i + 1];
+      node->count--;
+      return true;
+    }
+
+    int child_idx = child_index(node, key);
+    node_type* child = node->children[child_idx];
+    if (!remove_rec(child, key)) return false;
+    if (child->count < (M + 1) / 2 - 1) fix_child(node, child_idx);
+    return true;
+  }
+
+  // arreglar un hijo que quedó con menos del mínimo
+  void fix_child(node_type* parent, int child_idx) {
+    int min_keys = (M + 1) / 2 - 1;
+    if (child_idx > 0 && parent->children[child_idx - 1]->count > min_keys) {
+      borrow_from_left(parent, child_idx);
+    } else if (child_idx < parent->count && parent->children[child_idx + 1]->count > min_keys) {
+      borrow_from_right(parent, child_idx);
+    } else if (child_idx > 0) {
+      merge(parent, child_idx - 1);
+    } else {
+      merge(parent, child_idx);
+    }
+  }
+
+  void borrow_from_left(node_type* parent, int child_idx) {
+    node_type* child = parent->children[child_idx];
+    node_type* left_sibling = parent->children[child_idx - 1];
+    for (int i = child->count; i > 0; i--) child->keys[i] = child->keys[i - 1];
+
+    if (child->leaf) {
+      // la ultima key del hermano pasa a la hoja y el separador se copia de ella
+      child->keys[0] = left_sibling->keys[left_sibling->count - 1];
+      parent->keys[child_idx - 1] = child->keys[0];
+    } else {
+      for (int i = child->count + 1; i > 0; i--) child->children[i] = child->children[i - 1];
+      child->keys[0] = parent->keys[child_idx - 1];
+      child->children[0] = left_sibling->children[left_sibling->count];
+      left_sibling->children[left_sibling->count] = nullptr;
+      parent->keys[child_idx - 1] = left_sibling->keys[left_sibling->count - 1];
+    }
+    child->count++;
+    left_sibling->count--;
+  }
+
+  void borrow_from_right(node_type* parent, int child_idx) {
+    node_type* child = parent->children[child_idx];
+    node_type* right_sibling = parent->children[child_idx + 1];
+
+    if (child->leaf) {
+      child->keys[child->count] = right_sibling->keys[0];
+    } else {
+      child->keys[child->count] = parent->keys[child_idx];
+      child->children[child->count + 1] = right_sibling->children[0];
+      parent->keys[child_idx] = right_sibling->keys[0];
+    }
+    child->count++;
+
+    for (int i = 0; i < right_sibling->count - 1; i++) right_sibling->keys[i] = right_sibling->keys[i + 1];
+    if (!right_sibling->leaf) {
+      for (int i = 0; i < right_sibling->count; i++) right_sibling->children[i] = right_sibling->children[i + 1];
+      right_sibling->children[right_sibling->count] = nullptr;
+    }
+    right_sibling->count--;
+    if (child->leaf) parent->keys[child_idx] = right_sibling->keys[0];
+  }
+
+  // fusionar children[idx + 1] dentro de children[idx]
+  void merge(node_type* parent, int idx) {
+    node_type* left = parent->children[idx];
+    node_type* right = parent->children[idx + 1];
+
+    if (left->leaf) {
+      // en hojas el separador es una copia: se descarta
+      for (int i = 0; i < right->count; i++) left->keys[left->count++] = right->keys[i];
+      left->next = right->next;
+      if (right->next)
+        right->next->prev = left;
+      else
+        tail = left;
+    } else {
+      left->keys[left->count++] = parent->keys[idx];
+      int base = left->count;
+      for (int i = 0; i < right->count; i++) left->keys[left->count++] = right->keys[i];
+      for (int i = 0; i <= right->count; i++) left->children[base + i] = right->children[i];
+    }
+
+    for (int i = idx; i < parent->count - 1; i++) parent->keys[i] = parent->keys[i + 1];
+    for (int i = idx + 1; i < parent->count; i++) parent->children[i] = parent->children[i + 1];
+    parent->children[parent->count] = nullptr;
+    parent->count--;
+    pool.destroy(right);
+  }
+
+  // helpers
+  // destruye las keys de todos los nodos (solo para TK no trivial)
+  void destroy_subtree(node_type* x) {
+    if (!x->leaf) {
+      for (int i = 0; i <= x->count; ++i) destroy_subtree(x->children[i]);
+    }
+    pool.destroy(x);
+  }
+
+  // lo / hi: cotas de las keys del subarbol (lo <= key < hi), nullptr si no hay
+  bool check(node_type* x, bool is_root, int depth, const TK* lo, const TK* hi, int& leaf_level,
+             node_type*& prev_leaf, long long& total) {
+    const int max_keys = M - 1;
+    const int min_keys = (M + 1) / 2 - 1;
+
+    if (x->count > max_keys) return false;
+    if (is_root) {
+      if (!x->leaf && x->count < 1) return false;
+    } else if (x->count < min_keys) {
+      return false;
+    }
+    for (int i = 0; i < x->count; ++i) {
+      if (i > 0 && !(x->keys[i - 1] < x->keys[i])) return false;
+      if (lo && x->keys[i] < *lo) return false;
+      if (hi && !(x->keys[i] < *hi)) return false;
+    }
+
+    if (x->leaf) {
+      if (x->children != nullptr) return false;
+      if (leaf_level == -1)
+        leaf_level = depth;
+      else if (leaf_level != depth)
+        return false;
+      // la lista de hojas debe seguir el orden del recorrido
+      if (x->prev != prev_leaf) return false;
+      if (prev_leaf ? prev_leaf->next != x : head != x) return false;
+      prev_leaf = x;
+      total += x->count;
+      return true;
+    }
+
+    for (int i = 0; i <= x->count; ++i) {
+      if (x->children[i] == nullptr) return false;
+      const TK* child_lo = i == 0 ? lo : &x->keys[i - 1];
+      const TK* child_hi = i == x->count ? hi : &x->keys[i];
+      if (!check(x->children[i], false, depth + 1, child_lo, child_hi, leaf_level, prev_leaf, total)) return false;
+    }
+    return true;
+  }
+};
+
+#endif
@@ -1,79 +1,203 @@
 #ifndef BTree_H
 #define BTree_H
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
 #include <iostream>
+#include <exception>
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <memory_resource>
+#include <stdexcept>
+#include <type_traits>
+#include <numeric>
+#include <thread>
 #include <vector>
+#if __cplusplus >= 202002L
+#include <span>
+#endif
+#include "btree_file.h"
+#include "btree_iterator.h"
 #include "node.h"
+#include "node_pool.h"
+#include "node_search.h"
+#include "parallel_sort.h"
 using namespace std;
 
-template <typename TK>
+// Politicas de actualizacion de BTree (parametro Update).
+// BottomUp: insert/remove recursivos; bajan hasta la hoja y parten o
+// rebalancean a la vuelta. Cualquier M >= 3.
+struct BottomUp {};
+// TopDown: insert/remove iterativos en una sola pasada. insert parte de
+// antemano cada nodo lleno (M - 1 keys) antes de bajar por el; remove
+// asegura que el hijo tenga mas del minimo (borrow o merge) antes de bajar.
+// Ningun nodo ya visitado se vuelve a tocar, salvo para actualizar la
+// aumentacion si la hay. Requiere M par: con M impar un nodo lleno no se
+// parte en dos mitades con el minimo ni dos nodos minimos se fusionan en uno.
+struct TopDown {};
+
+// Aug: aumentacion opcional de los nodos (NoAugment, SubtreeSize o
+// SubtreeAggregate<Monoid>, ver node.h)
+// Compare: orden estricto de las keys (std::less<TK> por defecto). Se
+// construye por defecto en cada comparacion, asi que debe ser sin estado.
+// Con Compare::is_transparent (p. ej. std::less<>) search, contains, find,
+// lower_bound y upper_bound aceptan cualquier tipo comparable con TK (un
+// string_view en un arbol de string) sin construir un TK.
+// Update: BottomUp (por defecto) o TopDown
+template <typename TK, typename Aug = NoAugment, typename Compare = less<TK>, typename Update = BottomUp>
 class BTree {
   //La implementación de este BTree no soporta valores repetidos
+ public:
+  using node_type = Node<TK, Aug>;
+  using key_compare = Compare;
+
  private:
-  Node<TK>* root;
+  node_type* root;
   int M;  // grado u orden del arbol
   int n;  // total de elementos en el arbol
+  NodePool<TK, node_type> pool;  // origen de todos los nodos del arbol
+
+  // bordes cacheados para insertar al final (o al principio) sin bajar desde
+  // la raiz: right_edge[l] / left_edge[l] es el nodo de profundidad l en el
+  // camino al maximo / minimo, con edge_depth niveles. Se invalidan cuando
+  // cambia la raiz o se parte o libera un nodo del borde derecho (el nodo
+  // del borde izquierdo se queda con la mitad izquierda y nunca se libera)
+  node_type* right_edge[BTreeIterator<TK, node_type>::kMaxDepth];
+  node_type* left_edge[BTreeIterator<TK, node_type>::kMaxDepth];
+  int edge_depth;
+  bool edges_valid;
+
+  // compact_step sigue por la hoja que contiene al sucesor de compact_after,
+  // o por la primera hoja si !compact_resume
+  TK compact_after;
+  bool compact_resume;
+
+  // tareas por hilo en rangeSearch paralelo, para repartir subarboles desparejos
+  static constexpr size_t kScanTasksPerThread = 8;
+  // keys leidas por bloque en build_from_stream
+  static constexpr size_t kStreamChunk = 1 << 16;
 
  public:
-  BTree(int _M) : root(nullptr), M(_M), n(0){}
+  using iterator = BTreeIterator<TK, node_type>;
+  using const_iterator = iterator;
+  using reverse_iterator = std::reverse_iterator<iterator>;
+  using const_reverse_iterator = reverse_iterator;
+
+  BTree(int _M) : root(nullptr), M(_M), n(0), pool(_M), edge_depth(0), edges_valid(false), compact_after(), compact_resume(false) {
+    check_order();
+  }
+
+  // politica de memoria: slabs pedidos a upstream, opcionalmente con huge pages
+  BTree(int _M, pmr::memory_resource* upstream, bool huge_pages = false)
+      : root(nullptr), M(_M), n(0), pool(_M, upstream, huge_pages), edge_depth(0), edges_valid(false), compact_after(),
+        compact_resume(false) {
+    check_order();
+  }
+
+  BTree(const BTree&) = delete;
+  BTree& operator=(const BTree&) = delete;
 
   //indica si se encuentra o no un elemento
-  bool search(TK key) {
+  bool search(const TK& key) const {
     return search_rec(this->root, key);
   }
 
-  Node<TK>* insert(TK key){
-    //caso1: arbol sin raiz
-    if(!root){
-      root = new Node<TK>(M);
-      root->keys[0] = key;
-      root->count = 1;
-      root->leaf = true;
-      n = 1;
-      return root;
-    }
+  // busqueda heterogenea (solo con Compare transparente)
+  template <typename K, typename C = Compare, typename = typename C::is_transparent>
+  bool search(const K& key) const {
+    return search_rec(this->root, key);
+  }
 
-    //caso2: insertar normalmente
-    n++;
-    TK promoted_key;
-    Node<TK>* new_child = insert_rec(root, key, promoted_key);
-    if(!new_child) return root;
+  bool contains(const TK& key) const { return search_rec(root, key); }
 
-    //caso3: split en la raiz
-    Node<TK>* new_root = new Node<TK>(M);
-    new_root->leaf = false;
-    new_root->keys[0] = promoted_key;
-    new_root->count = 1;
-    new_root->children[0] = root;
-    new_root->children[1] = new_child;
-    root = new_root;
-    return root;
+  template <typename K, typename C = Compare, typename = typename C::is_transparent>
+  bool contains(const K& key) const {
+    return search_rec(root, key);
   }
 
-  void remove(TK key) {
+  // busquedas en lote: cada grupo de kBatchGroup busquedas baja un nivel a la
+  // vez y se prefetchea el siguiente hijo de cada una, asi los fallos de cache
+  // de busquedas distintas se solapan. sorted: las keys se procesan en orden
+  // y cada busqueda arranca desde el nodo mas profundo del camino anterior
+  // que todavia contiene su key, sin volver a bajar los niveles compartidos
+  // (conviene cuando el lote es denso en un rango; con keys dispersas solo
+  // se comparten los primeros niveles y pesa mas el ordenamiento).
+  void searchBatch(const TK* keys, size_t count, bool* found, bool sorted = false) const {
+    batch_descend(keys, count, sorted, [&](size_t i, node_type* x, int) { found[i] = x != nullptr; });
+  }
+
+  // como searchBatch, pero devuelve un puntero a la key guardada (o nullptr)
+  void findBatch(const TK* keys, size_t count, const TK** out, bool sorted = false) const {
+    batch_descend(keys, count, sorted, [&](size_t i, node_type* x, int pos) { out[i] = x ? &x->keys[pos] : nullptr; });
+  }
+
+  vector<bool> searchBatch(const vector<TK>& keys, bool sorted = false) const {
+    vector<bool> found(keys.size());
+    batch_descend(keys.data(), keys.size(), sorted, [&](size_t i, node_type* x, int) { found[i] = x != nullptr; });
+    return found;
+  }
+
+#if __cplusplus >= 202002L
+  void searchBatch(span<const TK> keys, span<bool> found, bool sorted = false) const {
+    searchBatch(keys.data(), keys.size(), found.data(), sorted);
+  }
+
+  void findBatch(span<const TK> keys, span<const TK*> out, bool sorted = false) const {
+    findBatch(keys.data(), keys.size(), out.data(), sorted);
+  }
+#endif
+
+  // la key se copia (o se mueve) una sola vez, al lugar donde queda; si ya
+  // estaba no se copia
+  node_type* insert(const TK& key) { return insert_key(key); }
+  node_type* insert(TK&& key) { return insert_key(std::move(key)); }
+
+  // construye la key desde args y la mueve al arbol
+  template <typename... Args>
+  node_type* emplace(Args&&... args) {
+    return insert_key(TK(std::forward<Args>(args)...));
+  }
+
+  void remove(const TK& key) {
     if (!root) return;
-    bool found = remove_rec(root, key);
+    node_type* old_top = root;
+    bool found;
+    if constexpr (is_same<Update, TopDown>::value) {
+      found = remove_top_down(key);
+      // un merge en la raiz la puede dejar vacia aunque key no estuviera
+      if (!found && root->count == 0 && !root->leaf) {
+        node_type* old_root = root;
+        root = root->children[0];
+        pool.destroy(old_root);
+      }
+    } else {
+      found = remove_rec(root, key);
+    }
     if (found) {
       n--;
       // Si la raíz quedó vacía pero tiene un hijo, promoverlo
       if (root->count == 0 && !root->leaf) {
-        Node<TK>* old_root = root;
+        node_type* old_root = root;
         root = root->children[0];
-        old_root->children[0] = nullptr;
-        delete old_root;
+        pool.destroy(old_root);
       }
       // Si el árbol quedó completamente vacío
       if (root && root->count == 0 && root->leaf) {
-        delete root;
+        pool.destroy(root);
         root = nullptr;
       }
     }
+    if (root != old_top) edges_valid = false;
   }
 
   //altura del arbol. Considerar altura 0 para arbol vacio
   int height() {
     if (!root) return 0;
     int cont = 0;
-    Node<TK>* temp = root;
+    node_type* temp = root;
 
     while (!temp->leaf) {
       temp = temp->children[0];
@@ -94,15 +218,94 @@ class BTree {
   vector<TK> rangeSearch(TK begin, TK end) {
     vector<TK> out;
     if (!root) return out;
-    if (end < begin) std::swap(begin, end);
+    if (key_less(end, begin)) std::swap(begin, end);
     range_search_rec(root, begin, end, out);
     return out;
   }
 
+  // rangeSearch repartido entre hilos: el rango se corta en subarboles
+  // independientes (unas kScanTasksPerThread tareas por hilo) que los hilos
+  // toman en orden. Con SubtreeSize el tamaño de cada tarea es exacto y se
+  // escribe directo en su tramo del resultado; si no, cada tarea junta sus
+  // keys aparte y los tramos se copian en paralelo al final.
+  vector<TK> rangeSearch(TK begin, TK end, unsigned threads) const {
+    if (key_less(end, begin)) std::swap(begin, end);
+    vector<TK> out;
+    if (threads <= 1) {
+      if (root) range_search_rec(root, begin, end, out);
+      return out;
+    }
+    vector<ScanTask> tasks = plan_scan(begin, end, kScanTasksPerThread * threads);
+    vector<size_t> offsets(tasks.size() + 1, 0);
+
+    if constexpr (Aug::counted) {
+      for (size_t i = 0; i < tasks.size(); ++i) offsets[i + 1] = offsets[i] + task_count(tasks[i], begin, end);
+      out.resize(offsets.back());
+      run_tasks(tasks.size(), threads, [&](size_t i) {
+        SliceWriter w{out.data() + offsets[i]};
+        run_scan_task(tasks[i], begin, end, w);
+      });
+    } else {
+      vector<vector<TK>> parts(tasks.size());
+      run_tasks(tasks.size(), threads, [&](size_t i) { run_scan_task(tasks[i], begin, end, parts[i]); });
+      for (size_t i = 0; i < tasks.size(); ++i) offsets[i + 1] = offsets[i] + parts[i].size();
+      out.resize(offsets.back());
+      run_tasks(tasks.size(), threads, [&](size_t i) {
+        std::copy(parts[i].begin(), parts[i].end(), out.begin() + offsets[i]);
+        vector<TK>().swap(parts[i]);
+      });
+    }
+    return out;
+  }
+
+  // como rangeSearch(begin, end, threads) sin armar el resultado: se llama
+  // f(chunk, keys, count) por tramo desde los hilos, concurrentemente. chunk
+  // numera los tramos en orden de keys (los vacios no se entregan).
+  template <typename F>
+  void rangeSearchChunks(TK begin, TK end, unsigned threads, F f) const {
+    if (key_less(end, begin)) std::swap(begin, end);
+    vector<ScanTask> tasks = plan_scan(begin, end, kScanTasksPerThread * std::max(1u, threads));
+    run_tasks(tasks.size(), std::max(1u, threads), [&](size_t i) {
+      vector<TK> part;
+      run_scan_task(tasks[i], begin, end, part);
+      if (!part.empty()) f(i, static_cast<const TK*>(part.data()), part.size());
+    });
+  }
+
+  // recorridos perezosos en orden (las keys no se pueden modificar)
+  iterator begin() const {
+    iterator it(root);
+    if (root) it.push_leftmost(root);
+    return it;
+  }
+  iterator end() const { return iterator(root); }
+  reverse_iterator rbegin() const { return reverse_iterator(end()); }
+  reverse_iterator rend() const { return reverse_iterator(begin()); }
+
+  // primera key >= key
+  iterator lower_bound(const TK& key) const { return lower_bound_of(key); }
+  // primera key > key
+  iterator upper_bound(const TK& key) const { return upper_bound_of(key); }
+  iterator find(const TK& key) const { return find_of(key); }
+
+  // versiones heterogeneas (solo con Compare transparente)
+  template <typename K, typename C = Compare, typename = typename C::is_transparent>
+  iterator lower_bound(const K& key) const {
+    return lower_bound_of(key);
+  }
+  template <typename K, typename C = Compare, typename = typename C::is_transparent>
+  iterator upper_bound(const K& key) const {
+    return upper_bound_of(key);
+  }
+  template <typename K, typename C = Compare, typename = typename C::is_transparent>
+  iterator find(const K& key) const {
+    return find_of(key);
+  }
+
   // mínimo valor del árbol
   TK minKey() {
     if (!root) throw runtime_error("El árbol está vacío");
-    Node<TK>* temp = root;
+    node_type* temp = root;
 
     while (!temp->leaf) {
       temp = temp->children[0];
@@ -113,7 +316,7 @@ class BTree {
   // máximo valor del árbol
   TK maxKey() {
     if (!root) throw runtime_error("El árbol está vacío");
-    Node<TK>* temp = root;
+    node_type* temp = root;
 
     while (!temp->leaf) {
       temp = temp->children[temp->count];
@@ -121,42 +324,384 @@ class BTree {
     return temp->keys[temp->count - 1];
   }
 
-  // eliminar todos lo elementos del arbol
+  // estadisticas de orden: requieren BTree<TK, SubtreeSize>. O(M log n)
+  // cantidad de keys menores que key
+  long long rank(const TK& key) const {
+    static_assert(Aug::counted, "rank requiere la aumentacion SubtreeSize");
+    return count_less(key, false);
+  }
+
+  // i-esima key mas chica (i desde 0)
+  TK select(long long i) const {
+    static_assert(Aug::counted, "select requiere la aumentacion SubtreeSize");
+    if (i < 0 || i >= n) throw out_of_range("Indice fuera de rango");
+    node_type* x = root;
+    while (!x->leaf) {
+      int c = 0;
+      for (;; ++c) {
+        long long s = subtree_size(x->children[c]);
+        if (i < s) break;
+        i -= s;
+        if (i == 0) return x->keys[c];
+        i--;
+      }
+      x = x->children[c];
+    }
+    return x->keys[i];
+  }
+
+  // cantidad de keys en [begin, end]
+  long long rangeCount(TK begin, TK end) const {
+    static_assert(Aug::counted, "rangeCount requiere la aumentacion SubtreeSize");
+    if (key_less(end, begin)) std::swap(begin, end);
+    return count_less(end, true) - count_less(begin, false);
+  }
+
+  // agregado del monoide sobre las keys en [begin, end]: requiere
+  // BTree<TK, SubtreeAggregate<Monoid>>. O(M log n)
+  template <typename A = Aug>
+  typename A::monoid::value_type aggregate(TK begin, TK end) const {
+    static_assert(A::aggregated, "aggregate requiere la aumentacion SubtreeAggregate");
+    if (key_less(end, begin)) std::swap(begin, end);
+    if (!root) return A::monoid::identity();
+    return aggregate_rec<typename A::monoid::value_type>(root, begin, end, false, false);
+  }
+
+  // eliminar todos lo elementos del arbol: se devuelven los slabs completos,
+  // O(#slabs) si TK es trivialmente destructible
   void clear() {
-    if (root) {
-      root->killSelf();
-      delete root;
-      root = nullptr;
+    if constexpr (!is_trivially_destructible<TK>::value) {
+      if (root) destroy_subtree(root);
     }
+    pool.release();
+    root = nullptr;
     n = 0;
+    edges_valid = false;
+    compact_resume = false;
+  }
+
+  // reconstruye el arbol con sus nodos ocupados a fill_factor de M - 1 keys
+  // (sin bajar del minimo; la raiz y algun nodo pueden pasarse si la
+  // cantidad de keys no permite otra forma): el recorrido en orden alimenta
+  // al constructor por niveles de build_from_ordered_vector. Los nodos nuevos salen de un
+  // pool aparte, asi que hace falta memoria para ambos arboles hasta el final.
+  // O(n)
+  void compact(double fill_factor = 1.0) {
+    vector<long long> fillK = fill_sizes_per_height(keys_for_fill(M, fill_factor), 64);
+    if (!root) return;
+    vector<long long> minK, maxK;
+    compute_minmax_per_height(M, 64, minK, maxK);
+    long long N = n;
+    int h = choose_height_for_fill(N, M, minK, maxK, fillK);
+    if (h == -1) throw runtime_error("No se pudo determinar altura adecuada");
+
+    NodePool<TK, node_type> fresh(M, pool.resource(), pool.uses_huge_pages());
+    iterator it = begin();
+    auto next = [&]() -> const TK& {
+      const TK& key = *it;
+      ++it;
+      return key;
+    };
+    node_type* new_root = build_subtree_from_source(fresh, next, M, h, N, minK, maxK, true, &fillK);
+    clear();
+    pool.absorb(fresh);
+    root = new_root;
+    n = static_cast<int>(N);
+  }
+
+  // compactacion incremental, para llamar de a poco desde un ciclo de
+  // mantenimiento: sigue de izquierda a derecha desde donde quedo la llamada
+  // anterior y reparte las hojas de cada padre en la menor cantidad de hojas
+  // con a lo sumo fill_factor de M - 1 keys (ver repack_leaves). Procesa
+  // padres mientras no pase de max_leaves hojas (al menos un padre, o sea
+  // hasta M hojas). Los padres que quedan con menos del minimo se
+  // rebalancean como en remove; los nodos internos no se compactan (para eso
+  // esta compact). Devuelve false al terminar una pasada completa; la
+  // llamada siguiente empieza otra
+  bool compact_step(size_t max_leaves, double fill_factor = 1.0) {
+    int target = keys_for_fill(M, fill_factor);
+    int min_keys = (M + 1) / 2 - 1;
+    node_type* path[iterator::kMaxDepth];
+    int idx[iterator::kMaxDepth];
+    vector<TK> buffer;
+    size_t visited = 0;
+    while (root && !root->leaf) {
+      int depth = 0;
+      for (node_type* x = root; !x->leaf; x = x->children[idx[depth++]]) {
+        int pos = 0;
+        if (compact_resume) {
+          pos = key_lower_bound(x->keys, x->count, compact_after);
+          if (pos < x->count && !key_less(compact_after, x->keys[pos])) pos++;
+        }
+        path[depth] = x;
+        idx[depth] = pos;
+      }
+      node_type* parent = path[depth - 1];
+      size_t leaves = static_cast<size_t>(parent->count) + 1;
+      if (visited > 0 && visited + leaves > max_leaves) return true;
+      visited += leaves;
+
+      // la proxima vez se sigue por la primera hoja despues de este padre
+      int up = depth - 2;
+      while (up >= 0 && idx[up] == path[up]->count) up--;
+      compact_resume = up >= 0;
+      if (compact_resume) compact_after = path[up]->keys[idx[up]];
+
+      repack_leaves(parent, target, buffer);
+      // el padre (y luego sus ancestros) puede quedar varias keys por debajo
+      // del minimo, fix_child le devuelve de a una
+      for (int l = depth - 1; l >= 1; --l) {
+        int pos = idx[l - 1];
+        while (path[l - 1]->children[pos]->count < min_keys) pos = fix_child(path[l - 1], pos);
+      }
+      if (root->count == 0 && !root->leaf) {
+        node_type* old_root = root;
+        root = root->children[0];
+        pool.destroy(old_root);
+        edges_valid = false;
+      }
+      if (!compact_resume) return false;
+    }
+    compact_resume = false;
+    return false;
+  }
+
+  // estadisticas del reservador de nodos
+  size_t node_count() const { return pool.live_nodes(); }
+  size_t slab_count() const { return pool.slab_count(); }
+  size_t memory_reserved() const { return pool.bytes_reserved(); }
+  size_t memory_used() const { return pool.bytes_used(); }
+  size_t leaf_count() const { return pool.live_leaf_nodes(); }
+  size_t internal_count() const { return pool.live_internal_nodes(); }
+  size_t leaf_node_bytes() const { return pool.leaf_node_bytes(); }
+  size_t internal_node_bytes() const { return pool.internal_node_bytes(); }
+
+  // ocupacion media de los nodos: keys guardadas / (nodos * (M - 1))
+  double fill_factor() const {
+    size_t nodes = pool.live_nodes();
+    return nodes ? static_cast<double>(n) / (static_cast<double>(nodes) * (M - 1)) : 0.0;
   }
 
   int size() const { return n; }
 
-  static BTree* build_from_ordered_vector(const vector<TK>& elements, int M) {
+  // guarda el arbol en el formato binario de btree_file.h (TK trivialmente
+  // copiable). Los nodos van en orden por niveles, asi los niveles de arriba
+  // quedan juntos al principio del archivo. El archivo se puede volver a
+  // cargar con load o servir sin deserializar con MappedBTree<TK>.
+  void save(const string& path) const {
+    static_assert(is_trivially_copyable<TK>::value, "save requiere keys trivialmente copiables");
+    namespace bf = btree_file;
+    vector<node_type*> order;
+    if (root) order.push_back(root);
+    for (size_t i = 0; i < order.size(); ++i) {
+      if (!order[i]->leaf)
+        for (int c = 0; c <= order[i]->count; ++c) order.push_back(order[i]->children[c]);
+    }
+    vector<uint64_t> offsets(order.size());
+    uint64_t pos = bf::kPage;
+    for (size_t i = 0; i < order.size(); ++i) {
+      offsets[i] = pos;
+      pos += bf::record_bytes<TK>(order[i]->count, order[i]->leaf);
+    }
+
+    bf::Header h{};
+    memcpy(h.magic, bf::kMagic, sizeof(h.magic));
+    h.version = bf::kVersion;
+    h.key_size = sizeof(TK);
+    h.endian_tag = bf::kEndianTag;
+    h.M = M;
+    h.height = 0;
+    for (node_type* x = root; x && !x->leaf; x = x->children[0]) h.height++;
+    h.n = n;
+    h.node_count = order.size();
+    h.root_offset = order.empty() ? 0 : bf::kPage;
+    h.file_size = bf::round_up(pos, bf::kPage);
+
+    bf::Writer w(path);
+    w.write(&h, sizeof(h));
+    w.zeros(bf::kPage - sizeof(h));
+    // en orden por niveles los hijos de cada nodo son los siguientes sin asignar
+    size_t next_child = 1;
+    vector<char> rec;
+    for (node_type* x : order) {
+      rec.assign(bf::record_bytes<TK>(x->count, x->leaf), 0);
+      bf::RecordHeader rh{x->count, x->leaf ? 1 : 0};
+      memcpy(rec.data(), &rh, sizeof(rh));
+      memcpy(rec.data() + bf::keys_offset<TK>(), x->keys, sizeof(TK) * x->count);
+      if (!x->leaf) {
+        for (int c = 0; c <= x->count; ++c)
+          memcpy(rec.data() + bf::children_offset<TK>(x->count) + 8 * c, &offsets[next_child++], 8);
+      }
+      w.write(rec.data(), rec.size());
+    }
+    w.zeros(h.file_size - pos);
+    w.close();
+  }
+
+  // reconstruye un arbol guardado con save, nodo por nodo (mismas formas).
+  // Lanza runtime_error si el archivo no es valido para este TK
+  static BTree* load(const string& path) {
+    static_assert(is_trivially_copyable<TK>::value, "load requiere keys trivialmente copiables");
+    btree_file::FileImage image(path);
+    btree_file::Header h;
+    if (image.size() < sizeof(h)) throw runtime_error("Archivo truncado o corrupto");
+    memcpy(&h, image.data(), sizeof(h));
+    btree_file::check_header<TK>(h, image.size());
+
+    BTree* tree = new BTree(h.M);
+    try {
+      long long total = 0;
+      if (h.root_offset) tree->root = tree->load_rec(image, h.root_offset, 0, h.height, total);
+      if (total != h.n) throw runtime_error("Archivo corrupto");
+      tree->n = static_cast<int>(total);
+    } catch (...) {
+      delete tree;
+      throw;
+    }
+    return tree;
+  }
+
+  // threads > 1: la verificacion de orden y la construccion de subarboles
+  // hermanos se reparten entre hilos (el upstream debe ser thread-safe)
+  static BTree* build_from_ordered_vector(const vector<TK>& elements, int M, unsigned threads = 1) {
   if (M < 3) throw std::invalid_argument("M debe ser al menos 3");
+  if (!strictly_increasing(elements, threads))
+      throw std::invalid_argument("Los elementos deben estar estrictamente ordenados y sin duplicados");
   BTree* tree = new BTree(M);
   if (elements.empty()) return tree;
-    for (size_t i = 1; i < elements.size(); ++i)
-    if (!(elements[i - 1] < elements[i]))
-      throw std::invalid_argument("Los elementos deben estar estrictamente ordenados y sin duplicados");
 
-  long long N = static_cast<long long>(elements.size());
-  int max_h_est = 64;
-  vector<long long> minK, maxK;
-  compute_minmax_per_height(M, max_h_est, minK, maxK);
-
-  int h = choose_height_for_root(N, M, minK, maxK);
-  if (h == -1) { delete tree; throw runtime_error("No se pudo determinar altura adecuada"); }
-
-  size_t pos = 0;
-  Node<TK>* root = build_subtree_from_sorted(elements, M, h, N, pos, minK, maxK, true);
-  if (!root) { delete tree; throw runtime_error("Construcción fallida"); }
-  tree->root = root;
-  tree->n = static_cast<int>(N);
+  try {
+    tree->build_sorted(elements, threads);
+  } catch (...) {
+    delete tree;
+    throw;
+  }
   return tree;
 }
 
+  // construye desde keys en cualquier orden y con repetidas: se ordenan en
+  // el lugar (radix para enteros, en paralelo con threads > 1), se quitan las
+  // repetidas y el mismo vector alimenta al constructor de abajo hacia arriba
+  static BTree* build_from_unsorted(vector<TK>&& elements, int M, unsigned threads = 1) {
+    if (M < 3) throw std::invalid_argument("M debe ser al menos 3");
+    parallel_sort(elements, threads, Compare());
+    elements.erase(std::unique(elements.begin(), elements.end(),
+                               [](const TK& a, const TK& b) { return !key_less(a, b) && !key_less(b, a); }),
+                   elements.end());
+    BTree* tree = new BTree(M);
+    try {
+      tree->build_sorted(elements, threads);
+    } catch (...) {
+      delete tree;
+      throw;
+    }
+    return tree;
+  }
+
+  // construccion en streaming, sin vector intermedio: next(key) escribe la
+  // siguiente key (estrictamente creciente) y devuelve false al terminar.
+  // Con expected >= 0 el arbol sale con la misma forma que
+  // build_from_ordered_vector; con expected < 0 (cantidad desconocida) se
+  // arma de abajo hacia arriba con un nodo abierto por nivel. En ambos casos
+  // solo se guarda un nodo incompleto por nivel ademas del arbol.
+  template <typename Next>
+  static BTree* build_from_generator(Next next, int M, long long expected = -1) {
+    if (M < 3) throw std::invalid_argument("M debe ser al menos 3");
+    BTree* tree = new BTree(M);
+    try {
+      bool has_prev = false;
+      TK prev{};
+      auto checked = [&](TK& key) {
+        if (!next(key)) return false;
+        if (has_prev && !key_less(prev, key))
+          throw std::invalid_argument("Los elementos deben estar estrictamente ordenados y sin duplicados");
+        prev = key;
+        has_prev = true;
+        return true;
+      };
+      if (expected >= 0)
+        tree->build_stream_known(checked, expected);
+      else
+        tree->build_stream_unknown(checked);
+    } catch (...) {
+      delete tree;
+      throw;
+    }
+    return tree;
+  }
+
+  // desde un rango de iteradores de entrada ya ordenado
+  template <typename InputIt>
+  static BTree* build_from_sorted_range(InputIt first, InputIt last, int M, long long expected = -1) {
+    return build_from_generator(
+        [&](TK& key) {
+          if (first == last) return false;
+          key = *first;
+          ++first;
+          return true;
+        },
+        M, expected);
+  }
+
+  // desde keys binarias (representacion en memoria de TK) leidas de in en
+  // bloques de kStreamChunk
+  static BTree* build_from_stream(istream& in, int M, long long expected = -1) {
+    static_assert(is_trivially_copyable<TK>::value, "build_from_stream requiere keys trivialmente copiables");
+    vector<TK> chunk(kStreamChunk);
+    size_t pos = 0, filled = 0;
+    return build_from_generator(
+        [&](TK& key) {
+          if (pos == filled) {
+            in.read(reinterpret_cast<char*>(chunk.data()), static_cast<streamsize>(sizeof(TK) * chunk.size()));
+            if (in.gcount() % static_cast<streamsize>(sizeof(TK)) != 0)
+              throw runtime_error("El stream termina en medio de una key");
+            filled = static_cast<size_t>(in.gcount()) / sizeof(TK);
+            pos = 0;
+            if (filled == 0) return false;
+          }
+          key = chunk[pos++];
+          return true;
+        },
+        M, expected);
+  }
+
+  // desde un archivo de keys binarias; la cantidad sale del tamaño
+  static BTree* build_from_file(const string& path, int M) {
+    ifstream in(path, ios::binary | ios::ate);
+    if (!in) throw runtime_error("No se pudo abrir " + path);
+    long long bytes = static_cast<long long>(in.tellg());
+    if (bytes % static_cast<long long>(sizeof(TK)) != 0) throw runtime_error("El archivo termina en medio de una key");
+    in.seekg(0);
+    return build_from_stream(in, M, bytes / static_cast<long long>(sizeof(TK)));
+  }
+
+  // inserta un lote ordenado (se ignoran las keys repetidas o ya presentes)
+  // en una sola pasada de izquierda a derecha: cada nodo tocado recibe su
+  // parte del lote y se parte a lo sumo una vez, en tantos nodos como haga
+  // falta. Un subarbol cuya parte del lote es al menos tan grande como el se
+  // reconstruye con build_subtree_from_sorted en vez de recorrerlo; el resto
+  // del arbol no se toca. Devuelve la cantidad de keys nuevas.
+  size_t insertSorted(const vector<TK>& batch) {
+    for (size_t i = 1; i < batch.size(); ++i) {
+      if (key_less(batch[i], batch[i - 1])) throw std::invalid_argument("El lote debe estar ordenado");
+      if (!key_less(batch[i - 1], batch[i])) return insertSorted(batch.begin(), batch.end());
+    }
+    return insert_sorted_range(batch.data(), batch.data() + batch.size());
+  }
+
+  template <typename It>
+  size_t insertSorted(It first, It last) {
+    vector<TK> batch;
+    for (; first != last; ++first) {
+      if (!batch.empty()) {
+        if (key_less(*first, batch.back())) throw std::invalid_argument("El lote debe estar ordenado");
+        if (!key_less(batch.back(), *first)) continue;
+      }
+      batch.push_back(*first);
+    }
+    return insert_sorted_range(batch.data(), batch.data() + batch.size());
+  }
+
   // Verifique las propiedades de un árbol B
   bool check_properties() {
     if (!root) return true;
@@ -172,18 +717,48 @@ class BTree {
 
  private:
   // metodos para la insercion
-  Node<TK>* split(Node<TK>* node, TK& promoted_key, bool is_leaf) {
-    int mid_idx = M / 2;
-    promoted_key = node->keys[mid_idx];
-
-    // partir a la mitad el nodo actual
-    Node<TK>* right = new Node<TK>(M);
-    right->leaf = is_leaf;
-    int j = 0;
-    for(int i = mid_idx + 1; i < node->count; i++){
-      right->keys[j++] = node->keys[i];
+  template <typename K>
+  node_type* insert_key(K&& key) {
+    //caso1: arbol sin raiz
+    if(!root){
+      root = pool.create(true);
+      root->keys[0] = std::forward<K>(key);
+      root->count = 1;
+      n = 1;
+      edges_valid = false;
+      return root;
     }
-    right->count = j;
+    // key nueva maxima o minima: directo a la hoja del borde
+    if (insert_at_edge(std::forward<K>(key))) return root;
+    if constexpr (is_same<Update, TopDown>::value) return insert_top_down(std::forward<K>(key));
+
+    //caso2: insertar normalmente
+    TK promoted_key;
+    node_type* new_child = insert_rec(root, std::forward<K>(key), promoted_key);
+    if(!new_child) return root;
+
+    //caso3: split en la raiz
+    node_type* new_root = pool.create(false);
+    new_root->keys[0] = std::move(promoted_key);
+    new_root->count = 1;
+    new_root->children[0] = root;
+    new_root->children[1] = new_child;
+    recount(new_root);
+    root = new_root;
+    edges_valid = false;
+    return root;
+  }
+
+  // sube la key del medio: M / 2 con M keys (bottom-up), M / 2 - 1 con las
+  // M - 1 keys de un nodo lleno (top-down, M par)
+  node_type* split(node_type* node, TK& promoted_key, bool is_leaf) {
+    int mid_idx = node->count / 2;
+    promoted_key = std::move(node->keys[mid_idx]);
+
+    // partir a la mitad el nodo actual (las keys se mueven, no se copian)
+    node_type* right = pool.create(is_leaf);
+    std::move(node->keys + mid_idx + 1, node->keys + node->count, right->keys);
+    right->count = node->count - mid_idx - 1;
 
     // organizar los hijos si no es hoja
     if(!is_leaf) {
@@ -193,100 +768,401 @@ class BTree {
       }
     }
     node->count = mid_idx;
+    recount(node);
+    recount(right);
     return right; // se retorna la key que sube y el nodo partido
   }
 
-  Node<TK>* insert_rec(Node<TK>* node, TK key, TK& promoted_key){
-    //busqueda binaria del indice > key
-    int left = 0, right = node->count - 1;
-    int child_idx = 0;
-    while(left <= right){
-      int mid = left + (right - left) / 2;
-      if(node->keys[mid] == key) {
-          n--; // llave duplicada, sin insercion
-          return nullptr;
-      }
-      if(node->keys[mid] < key) {
-          left = mid + 1;
-          child_idx = left;
-      } else {
-          right = mid - 1;
-      }
+  template <typename K>
+  node_type* insert_rec(node_type* node, K&& key, TK& promoted_key){
+    //indice del primer key >= key
+    int child_idx = key_lower_bound(node->keys, node->count, key);
+    if(child_idx < node->count && !key_less(key, node->keys[child_idx])) {
+        return nullptr; // llave duplicada, sin insercion
     }
 
     if(node->leaf){
       // insertar en hoja desplazando las keys
-      int insert_pos = node->count;
-      while(insert_pos > 0 && node->keys[insert_pos - 1] > key){
-          node->keys[insert_pos] = node->keys[insert_pos - 1];
-          insert_pos--;
-      }
-      node->keys[insert_pos] = key;
+      std::move_backward(node->keys + child_idx, node->keys + node->count, node->keys + node->count + 1);
+      node->keys[child_idx] = std::forward<K>(key);
       node->count++;
+      n++;
 
       //split en hoja
       if(node->count == M){
+          forget_edge(node);
           return split(node, promoted_key, true);
       }
+      refresh_aggregate(node);
       return nullptr;
     }
     else {
       // nodo interno = descender recursivamente
       TK child_promoted_key;
-      Node<TK>* new_child = insert_rec(node->children[child_idx], key, child_promoted_key);
-      if(!new_child) return nullptr; // sin split
+      int n_before = n;
+      node_type* new_child = insert_rec(node->children[child_idx], std::forward<K>(key), child_promoted_key);
+      if (n == n_before) return nullptr; // llave duplicada
+      if constexpr (Aug::counted) node->size++;
+      if(!new_child) {
+        refresh_aggregate(node);
+        return nullptr; // sin split
+      }
 
       // hubo split, insertar la clave promovida en padre
-      int insert_pos = node->count;
-      while(insert_pos > child_idx && node->keys[insert_pos - 1] > child_promoted_key){
-          node->keys[insert_pos] = node->keys[insert_pos - 1];
-          node->children[insert_pos + 1] = node->children[insert_pos];
-          insert_pos--;
-      }
-      node->keys[insert_pos] = child_promoted_key;
-      node->children[insert_pos + 1] = new_child;
+      std::move_backward(node->keys + child_idx, node->keys + node->count, node->keys + node->count + 1);
+      std::move_backward(node->children + child_idx + 1, node->children + node->count + 1,
+                         node->children + node->count + 2);
+      node->keys[child_idx] = std::move(child_promoted_key);
+      node->children[child_idx + 1] = new_child;
       node->count++;
 
       // split en padre
       if(node->count == M){
+          forget_edge(node);
           return split(node, promoted_key, false);
       }
+      refresh_aggregate(node);
       return nullptr;
     }
   }
 
-  // metodos para la eliminacion
-  bool remove_rec(Node<TK>* node, TK key) {
-    if (!node) return false;
-    
+  // insercion en un borde: si key es mayor que el maximo (o menor que el
+  // minimo) va directo a la hoja cacheada de ese borde y devuelve true; si
+  // no, devuelve false sin tocar key. Un nodo del borde que se desborda le
+  // pasa primero keys a su hermano hasta llenarlo y solo se parte si el
+  // hermano ya estaba lleno, asi con inserciones en orden los nodos que van
+  // quedando atras terminan con M - 1 keys en vez de la mitad, sin que
+  // ningun nodo baje del minimo
+  template <typename K>
+  bool insert_at_edge(K&& key) {
+    if (!edges_valid) load_edges();
+    node_type** edge;
+    node_type* leaf = right_edge[edge_depth - 1];
+    bool at_end = key_less(leaf->keys[leaf->count - 1], key);
+    if (at_end) {
+      edge = right_edge;
+      leaf->keys[leaf->count] = std::forward<K>(key);
+    } else {
+      leaf = left_edge[edge_depth - 1];
+      if (!key_less(key, leaf->keys[0])) return false;
+      edge = left_edge;
+      std::move_backward(leaf->keys, leaf->keys + leaf->count, leaf->keys + leaf->count + 1);
+      leaf->keys[0] = std::forward<K>(key);
+    }
+    leaf->count++;
+    n++;
+    update_path(edge, edge_depth, 1);
+
+    // desbordes de la hoja hacia arriba por el borde
+    for (int level = edge_depth - 1; level >= 0 && edge[level]->count == M; --level) {
+      node_type* x = edge[level];
+      TK promoted_key;
+      if (level == 0) {
+        node_type* right = split(x, promoted_key, x->leaf);
+        node_type* new_root = pool.create(false);
+        new_root->keys[0] = std::move(promoted_key);
+        new_root->count = 1;
+        new_root->children[0] = x;
+        new_root->children[1] = right;
+        recount(new_root);
+        root = new_root;
+        edges_valid = false;
+        break;
+      }
+      node_type* parent = edge[level - 1];
+      if (at_end) {
+        node_type* sibling = parent->children[parent->count - 1];
+        if (sibling->count < M - 1) {
+          shift_to_left(parent, M - 1 - sibling->count);
+          break;
+        }
+        node_type* right = split(x, promoted_key, x->leaf);
+        parent->keys[parent->count] = std::move(promoted_key);
+        parent->children[parent->count + 1] = right;
+        parent->count++;
+        edge[level] = right;
+      } else {
+        node_type* sibling = parent->children[1];
+        if (sibling->count < M - 1) {
+          shift_to_right(parent, M - 1 - sibling->count);
+          break;
+        }
+        node_type* right = split(x, promoted_key, x->leaf);
+        std::move_backward(parent->keys, parent->keys + parent->count, parent->keys + parent->count + 1);
+        std::move_backward(parent->children + 1, parent->children + parent->count + 1,
+                           parent->children + parent->count + 2);
+        parent->keys[0] = std::move(promoted_key);
+        parent->children[1] = right;
+        parent->count++;
+      }
+    }
+    return true;
+  }
+
+  // pasa k keys (con sus hijos) del ultimo hijo de parent a su hermano
+  // izquierdo, rotando por el separador
+  void shift_to_left(node_type* parent, int k) {
+    int s = parent->count - 1;
+    node_type* sibling = parent->children[s];
+    node_type* x = parent->children[s + 1];
+    for (int j = 0; j < k; ++j) {
+      sibling->keys[sibling->count] = std::move(parent->keys[s]);
+      sibling->count++;
+      if (!x->leaf) sibling->children[sibling->count] = x->children[j];
+      parent->keys[s] = std::move(x->keys[j]);
+    }
+    std::move(x->keys + k, x->keys + x->count, x->keys);
+    if (!x->leaf) {
+      std::copy(x->children + k, x->children + x->count + 1, x->children);
+      std::fill(x->children + x->count + 1 - k, x->children + x->count + 1, nullptr);
+    }
+    x->count -= k;
+    recount(sibling);
+    recount(x);
+    refresh_aggregate(parent);
+  }
+
+  // pasa k keys (con sus hijos) del primer hijo de parent a su hermano
+  // derecho, rotando por el separador
+  void shift_to_right(node_type* parent, int k) {
+    node_type* x = parent->children[0];
+    node_type* sibling = parent->children[1];
+    std::move_backward(sibling->keys, sibling->keys + sibling->count, sibling->keys + sibling->count + k);
+    if (!sibling->leaf) {
+      std::copy_backward(sibling->children, sibling->children + sibling->count + 1,
+                         sibling->children + sibling->count + 1 + k);
+    }
+    for (int j = k - 1; j >= 0; --j) {
+      sibling->keys[j] = std::move(parent->keys[0]);
+      if (!x->leaf) {
+        sibling->children[j] = x->children[x->count];
+        x->children[x->count] = nullptr;
+      }
+      parent->keys[0] = std::move(x->keys[x->count - 1]);
+      x->count--;
+    }
+    sibling->count += k;
+    recount(sibling);
+    recount(x);
+    refresh_aggregate(parent);
+  }
+
+  // reparte las keys de las hojas hijas de parent, con sus separadores, en
+  // partes iguales entre la menor cantidad de esas hojas que deja a lo sumo
+  // target keys en cada una (sin bajar del minimo ni usar hojas nuevas). Las
+  // hojas que sobran se liberan; parent puede quedar con menos del minimo
+  void repack_leaves(node_type* parent, int target, vector<TK>& buffer) {
     int min_keys = (M + 1) / 2 - 1;
+    int c = parent->count + 1;
+    buffer.clear();
+    for (int i = 0; i < c; ++i) {
+      node_type* leaf = parent->children[i];
+      std::move(leaf->keys, leaf->keys + leaf->count, back_inserter(buffer));
+      if (i < parent->count) buffer.push_back(std::move(parent->keys[i]));
+    }
+    long long total = static_cast<long long>(buffer.size());
+    long long want = (total + target + 1) / (target + 1);  // techo((total + 1) / (target + 1))
+    int used = static_cast<int>(std::max(1LL, std::min({want, (total + 1) / (min_keys + 1), (long long)c})));
+
+    long long child_total = total - (used - 1);
+    size_t pos = 0;
+    for (int i = 0; i < used; ++i) {
+      node_type* leaf = parent->children[i];
+      int cnt = static_cast<int>(child_total / used + (i < child_total % used ? 1 : 0));
+      std::move(buffer.begin() + pos, buffer.begin() + pos + cnt, leaf->keys);
+      pos += cnt;
+      leaf->count = cnt;
+      if (i < used - 1) parent->keys[i] = std::move(buffer[pos++]);
+      recount(leaf);
+    }
+    for (int i = used; i < c; ++i) {
+      forget_edge(parent->children[i]);
+      pool.destroy(parent->children[i]);
+      parent->children[i] = nullptr;
+    }
+    parent->count = used - 1;
+    recount(parent);
+  }
 
-    // busqueda binaria para encontrar la posición
-    int left = 0, right = node->count - 1;
-    int pos = -1;
-    int child_idx = 0;
-    
-    while (left <= right) {
-      int mid = left + (right - left) / 2;
-      if (node->keys[mid] == key) {
-        pos = mid;
+  // recorre ambos bordes desde la raiz (que no es nula)
+  void load_edges() {
+    edge_depth = 0;
+    for (node_type* x = root;; x = x->children[x->count]) {
+      right_edge[edge_depth++] = x;
+      if (x->leaf) break;
+    }
+    int depth = 0;
+    for (node_type* x = root;; x = x->children[0]) {
+      left_edge[depth++] = x;
+      if (x->leaf) break;
+    }
+    edges_valid = true;
+  }
+
+  // x se va a partir o liberar: si esta en el borde derecho el cache ya no vale
+  void forget_edge(node_type* x) {
+    if (!edges_valid) return;
+    for (int i = 0; i < edge_depth; ++i) {
+      if (right_edge[i] == x) {
+        edges_valid = false;
+        return;
+      }
+    }
+  }
+
+  // insercion top-down: los nodos llenos se parten antes de bajar, asi el
+  // padre siempre tiene lugar para la key que sube
+  template <typename K>
+  node_type* insert_top_down(K&& key) {
+    if (root->count == M - 1) {
+      node_type* new_root = pool.create(false);
+      new_root->children[0] = root;
+      root = new_root;
+      split_child(new_root, 0);
+      recount(new_root);
+      edges_valid = false;
+    }
+
+    // camino recorrido, para la aumentacion
+    node_type* path[iterator::kMaxDepth];
+    int depth = 0;
+    node_type* x = root;
+    while (true) {
+      int pos = key_lower_bound(x->keys, x->count, key);
+      if (pos < x->count && !key_less(key, x->keys[pos])) return root;  // llave duplicada
+      path[depth++] = x;
+      if (x->leaf) break;
+      if (x->children[pos]->count == M - 1) {
+        split_child(x, pos);
+        // la key que subio queda en x->keys[pos]
+        if (!key_less(key, x->keys[pos])) {
+          if (!key_less(x->keys[pos], key)) return root;
+          pos++;
+        }
+      }
+      x = x->children[pos];
+    }
+
+    // insertar en hoja desplazando las keys
+    int pos = key_lower_bound(x->keys, x->count, key);
+    std::move_backward(x->keys + pos, x->keys + x->count, x->keys + x->count + 1);
+    x->keys[pos] = std::forward<K>(key);
+    x->count++;
+    n++;
+    update_path(path, depth, 1);
+    return root;
+  }
+
+  // parte el hijo pos de x, que esta lleno, y sube su key del medio a x
+  void split_child(node_type* x, int pos) {
+    node_type* child = x->children[pos];
+    forget_edge(child);
+    TK promoted_key;
+    node_type* right = split(child, promoted_key, child->leaf);
+    std::move_backward(x->keys + pos, x->keys + x->count, x->keys + x->count + 1);
+    std::move_backward(x->children + pos + 1, x->children + x->count + 1, x->children + x->count + 2);
+    x->keys[pos] = std::move(promoted_key);
+    x->children[pos + 1] = right;
+    x->count++;
+  }
+
+  // eliminacion top-down: antes de bajar a un hijo con el minimo de keys se
+  // le da una mas (borrow o merge), asi la hoja puede perder una key sin
+  // rebalancear hacia arriba
+  bool remove_top_down(const TK& key) {
+    int min_keys = (M + 1) / 2 - 1;
+    node_type* path[iterator::kMaxDepth];
+    int depth = 0;
+    node_type* x = root;
+    while (true) {
+      int pos = key_lower_bound(x->keys, x->count, key);
+      bool here = pos < x->count && !key_less(key, x->keys[pos]);
+      path[depth++] = x;
+      if (x->leaf) {
+        if (!here) return false;  // Key no encontrada
+        std::move(x->keys + pos + 1, x->keys + x->count, x->keys + pos);
+        x->count--;
         break;
       }
-      if (node->keys[mid] < key) {
-        left = mid + 1;
-        child_idx = left;
-      } else {
-        right = mid - 1;
-        child_idx = mid;
+      if (here) {
+        // key en nodo interno: reemplazar con sucesor o predecesor si ese
+        // lado tiene keys de sobra; si no, fusionar ambos hijos y seguir
+        if (x->children[pos + 1]->count > min_keys) {
+          x->keys[pos] = take_edge_top_down(x->children[pos + 1], true, path, depth);
+          break;
+        }
+        if (x->children[pos]->count > min_keys) {
+          x->keys[pos] = take_edge_top_down(x->children[pos], false, path, depth);
+          break;
+        }
+        merge_with_right(x, pos);
+        x = x->children[pos];
+        continue;
+      }
+      if (x->children[pos]->count == min_keys) pos = fix_child(x, pos);
+      x = x->children[pos];
+    }
+    update_path(path, depth, -1);
+    return true;
+  }
+
+  // saca la key minima (first) o maxima del subarbol de x, que tiene mas
+  // del minimo, asegurando lo mismo en cada hijo antes de bajar
+  TK take_edge_top_down(node_type* x, bool first, node_type** path, int& depth) {
+    int min_keys = (M + 1) / 2 - 1;
+    while (!x->leaf) {
+      path[depth++] = x;
+      int pos = first ? 0 : x->count;
+      if (x->children[pos]->count == min_keys) pos = fix_child(x, pos);
+      x = x->children[pos];
+    }
+    path[depth++] = x;
+    TK key;
+    if (first) {
+      key = std::move(x->keys[0]);
+      std::move(x->keys + 1, x->keys + x->count, x->keys);
+    } else {
+      key = std::move(x->keys[x->count - 1]);
+    }
+    x->count--;
+    return key;
+  }
+
+  // aumentacion del camino tras insertar (+1) o eliminar (-1) una key, de
+  // la hoja hacia arriba; sin aumentacion no hace nada
+  static void update_path(node_type** path, int depth, int delta) {
+    if constexpr (Aug::counted || Aug::aggregated) {
+      for (int i = depth - 1; i >= 0; --i) {
+        if constexpr (Aug::counted) {
+          if (!path[i]->leaf) path[i]->size += delta;
+        }
+        refresh_aggregate(path[i]);
       }
     }
+  }
+
+  // metodos para la eliminacion
+  bool remove_rec(node_type* node, const TK& key) {
+    if (!node) return false;
+    
+    int min_keys = (M + 1) / 2 - 1;
+
+    // buscar la posición (o el hijo por el que descender)
+    int child_idx = key_lower_bound(node->keys, node->count, key);
+    int pos = (child_idx < node->count && !key_less(key, node->keys[child_idx])) ? child_idx : -1;
     
     //caso3: key en nodo interno
     if (pos != -1 && !node->leaf) {
-      // reemplazar con sucesor
-      TK successor = get_successor(node->children[pos + 1]);
-      node->keys[pos] = successor;
-      return remove_rec(node->children[pos + 1], successor); // eliminar sucesor
+      // reemplazar con sucesor: se saca (movido) de la hoja mas a la
+      // izquierda del hijo derecho, sin copiarlo ni volver a buscarlo
+      node_type* child = node->children[pos + 1];
+      node->keys[pos] = take_min(child);
+      if constexpr (Aug::counted) node->size--;
+      if (child->count < min_keys) {
+        fix_child(node, pos + 1);
+      }
+      refresh_aggregate(node);
+      return true;
     }
     
     // CASO 0, 1, 2: key en nodo hoja o descender
@@ -294,65 +1170,78 @@ class BTree {
       if (pos == -1) return false; // Key no encontrada
       
       // eliminar la key desplazando elementos
-      for (int i = pos; i < node->count - 1; i++) {
-        node->keys[i] = node->keys[i + 1];
-      }
+      std::move(node->keys + pos + 1, node->keys + node->count, node->keys + pos);
       node->count--;
+      refresh_aggregate(node);
       return true;
     }
     
     //nodo interno: descender al hijo apropiado
-    Node<TK>* child = node->children[child_idx];
+    node_type* child = node->children[child_idx];
     bool found = remove_rec(child, key);
     
     if (!found) return false;
+    if constexpr (Aug::counted) node->size--;
     
     // si el hijo quedó con menos del mínimo
     if (child->count < min_keys) {
       fix_child(node, child_idx);
     }
+    refresh_aggregate(node);
     
     return true;
   }
 
-  TK get_successor(Node<TK>* node) {
-    while (!node->leaf) {
-      node = node->children[0];
+  // saca la key minima del subarbol de node y rebalancea a la vuelta
+  TK take_min(node_type* node) {
+    if (node->leaf) {
+      TK key = std::move(node->keys[0]);
+      std::move(node->keys + 1, node->keys + node->count, node->keys);
+      node->count--;
+      refresh_aggregate(node);
+      return key;
+    }
+    node_type* child = node->children[0];
+    TK key = take_min(child);
+    if constexpr (Aug::counted) node->size--;
+    if (child->count < (M + 1) / 2 - 1) {
+      fix_child(node, 0);
     }
-    return node->keys[0];
+    refresh_aggregate(node);
+    return key;
   }
   
-  // arreglar un hijo que quedó con menos del mínimo
-  void fix_child(Node<TK>* parent, int child_idx) {
+  // arreglar un hijo que quedó con menos del mínimo (o, en top-down, que
+  // tiene justo el minimo). Devuelve el indice donde quedaron sus keys
+  int fix_child(node_type* parent, int child_idx) {
     int min_keys = (M + 1) / 2 - 1;
     
     //caso1: intentar borrow de hermano izquierdo
     if (child_idx > 0 && parent->children[child_idx - 1]->count > min_keys) {
       borrow_from_left(parent, child_idx);
-      return;
+      return child_idx;
     }
     
     //  caso2: intentar borrow de hermano derecho
     if (child_idx < parent->count && parent->children[child_idx + 1]->count > min_keys) {
       borrow_from_right(parent, child_idx);
-      return;
+      return child_idx;
     }
     
     //caso3 : merge con hermano
     if (child_idx > 0) {
       merge_with_left(parent, child_idx);
-    } else {
-      merge_with_right(parent, child_idx);
+      return child_idx - 1;
     }
+    merge_with_right(parent, child_idx);
+    return child_idx;
   }
   
   // Rotar: tomar una key del hermano izquierdo
-  void borrow_from_left(Node<TK>* parent, int child_idx) {
-    Node<TK>* child = parent->children[child_idx];
-    Node<TK>* left_sibling = parent->children[child_idx - 1];
-    for (int i = child->count; i > 0; i--) {
-      child->keys[i] = child->keys[i - 1];
-    }
+  void borrow_from_left(node_type* parent, int child_idx) {
+    node_type* child = parent->children[child_idx];
+    node_type* left_sibling = parent->children[child_idx - 1];
+    std::move_backward(child->keys, child->keys + child->count, child->keys + child->count + 1);
     
     // Desplazar children si no es hoja
     if (!child->leaf) {
@@ -361,9 +1250,9 @@ class BTree {
       }
     }
 
-    child->keys[0] = parent->keys[child_idx - 1];
+    child->keys[0] = std::move(parent->keys[child_idx - 1]);
     child->count++;
-    parent->keys[child_idx - 1] = left_sibling->keys[left_sibling->count - 1];
+    parent->keys[child_idx - 1] = std::move(left_sibling->keys[left_sibling->count - 1]);
     
     //moover el último hijo del hermano al child (si no es hoja)
     if (!child->leaf) {
@@ -371,20 +1260,20 @@ class BTree {
       left_sibling->children[left_sibling->count] = nullptr;
     }
     left_sibling->count--;
+    recount(child);
+    recount(left_sibling);
   }
 
-  void borrow_from_right(Node<TK>* parent, int child_idx) {
-    Node<TK>* child = parent->children[child_idx];
-    Node<TK>* right_sibling = parent->children[child_idx + 1];
-    child->keys[child->count] = parent->keys[child_idx];
+  void borrow_from_right(node_type* parent, int child_idx) {
+    node_type* child = parent->children[child_idx];
+    node_type* right_sibling = parent->children[child_idx + 1];
+    child->keys[child->count] = std::move(parent->keys[child_idx]);
     child->count++;
-    parent->keys[child_idx] = right_sibling->keys[0];
+    parent->keys[child_idx] = std::move(right_sibling->keys[0]);
     if (!child->leaf) {
       child->children[child->count] = right_sibling->children[0];
     }
-    for (int i = 0; i < right_sibling->count - 1; i++) {
-      right_sibling->keys[i] = right_sibling->keys[i + 1];
-    }
+    std::move(right_sibling->keys + 1, right_sibling->keys + right_sibling->count, right_sibling->keys);
     if (!right_sibling->leaf) {
       for (int i = 0; i < right_sibling->count; i++) {
         right_sibling->children[i] = right_sibling->children[i + 1];
@@ -392,22 +1281,22 @@ class BTree {
       right_sibling->children[right_sibling->count] = nullptr;
     }
     right_sibling->count--;
+    recount(child);
+    recount(right_sibling);
   }
   
   // fusinar child con su hermano izquierdo
-  void merge_with_left(Node<TK>* parent, int child_idx) {
-    Node<TK>* child = parent->children[child_idx];
-    Node<TK>* left_sibling = parent->children[child_idx - 1];
+  void merge_with_left(node_type* parent, int child_idx) {
+    node_type* child = parent->children[child_idx];
+    node_type* left_sibling = parent->children[child_idx - 1];
     
     // bajar la key del padre al hermano izquierdo
-    left_sibling->keys[left_sibling->count] = parent->keys[child_idx - 1];
+    left_sibling->keys[left_sibling->count] = std::move(parent->keys[child_idx - 1]);
     left_sibling->count++;
     
-    // copiar todas las keys del child al hermano izquierdo
-    for (int i = 0; i < child->count; i++) {
-      left_sibling->keys[left_sibling->count] = child->keys[i];
-      left_sibling->count++;
-    }
+    // mover todas las keys del child al hermano izquierdo
+    std::move(child->keys, child->keys + child->count, left_sibling->keys + left_sibling->count);
+    left_sibling->count += child->count;
     
     //copiar los children si no es hoja
     if (!child->leaf) {
@@ -418,28 +1307,26 @@ class BTree {
     }
     
     //eliminar key del padre y ajustar children
-    for (int i = child_idx - 1; i < parent->count - 1; i++) {
-      parent->keys[i] = parent->keys[i + 1];
-    }
+    std::move(parent->keys + child_idx, parent->keys + parent->count, parent->keys + child_idx - 1);
     for (int i = child_idx; i < parent->count; i++) {
       parent->children[i] = parent->children[i + 1];
     }
     parent->children[parent->count] = nullptr;
     parent->count--;
-    delete child;
+    recount(left_sibling);
+    forget_edge(child);
+    pool.destroy(child);
   }
 
-  void merge_with_right(Node<TK>* parent, int child_idx) {
-    Node<TK>* child = parent->children[child_idx];
-    Node<TK>* right_sibling = parent->children[child_idx + 1];
+  void merge_with_right(node_type* parent, int child_idx) {
+    node_type* child = parent->children[child_idx];
+    node_type* right_sibling = parent->children[child_idx + 1];
 
-    child->keys[child->count] = parent->keys[child_idx];
+    child->keys[child->count] = std::move(parent->keys[child_idx]);
     child->count++;
 
-    for (int i = 0; i < right_sibling->count; i++) {
-      child->keys[child->count] = right_sibling->keys[i];
-      child->count++;
-    }
+    std::move(right_sibling->keys, right_sibling->keys + right_sibling->count, child->keys + child->count);
+    child->count += right_sibling->count;
 
     if (!child->leaf) {
       for (int i = 0; i <= right_sibling->count; i++) {
@@ -448,41 +1335,740 @@ class BTree {
       }
     }
 
-    for (int i = child_idx; i < parent->count - 1; i++) {
-      parent->keys[i] = parent->keys[i + 1];
-    }
+    std::move(parent->keys + child_idx + 1, parent->keys + parent->count, parent->keys + child_idx);
     for (int i = child_idx + 1; i < parent->count; i++) {
       parent->children[i] = parent->children[i + 1];
     }
     parent->children[parent->count] = nullptr;
     parent->count--;
-    delete right_sibling;
+    recount(child);
+    forget_edge(right_sibling);
+    pool.destroy(right_sibling);
+  }
+
+  // construye el arbol (vacio) desde elements, estrictamente ordenado
+  void build_sorted(const vector<TK>& elements, unsigned threads = 1) {
+  long long N = static_cast<long long>(elements.size());
+  if (N == 0) return;
+  int max_h_est = 64;
+  vector<long long> minK, maxK;
+  compute_minmax_per_height(M, max_h_est, minK, maxK);
+
+  int h = choose_height_for_root(N, M, minK, maxK);
+  if (h == -1) throw runtime_error("No se pudo determinar altura adecuada");
+
+  node_type* new_root;
+  if (threads > 1 && h > 0) {
+    new_root = build_parallel(elements, h, N, minK, maxK, threads);
+  } else {
+    size_t pos = 0;
+    new_root = build_subtree_from_sorted(pool, elements, M, h, N, pos, minK, maxK, true);
+  }
+  if (!new_root) throw runtime_error("Construcción fallida");
+  root = new_root;
+  n = static_cast<int>(N);
+}
+
+  // construccion en streaming con cantidad conocida: misma forma que build_sorted
+  template <typename Next>
+  void build_stream_known(Next& next, long long N) {
+    if (N == 0) {
+      TK extra;
+      if (next(extra)) throw std::invalid_argument("La fuente tiene mas keys que las esperadas");
+      return;
+    }
+    vector<long long> minK, maxK;
+    compute_minmax_per_height(M, 64, minK, maxK);
+    int h = choose_height_for_root(N, M, minK, maxK);
+    if (h == -1) throw runtime_error("No se pudo determinar altura adecuada");
+
+    auto take = [&]() {
+      TK key;
+      if (!next(key)) throw std::invalid_argument("La fuente tiene menos keys que las esperadas");
+      return key;
+    };
+    root = build_subtree_from_source(pool, take, M, h, N, minK, maxK, true);
+    n = static_cast<int>(N);
+    TK extra;
+    if (next(extra)) throw std::invalid_argument("La fuente tiene mas keys que las esperadas");
+  }
+
+  // construccion en streaming sin cantidad: open[l] es el nodo que se esta
+  // llenando en el nivel l (0 = hojas). Los nodos se cierran llenos (M - 1
+  // keys) y la key que no entra sube como separador
+  template <typename Next>
+  void build_stream_unknown(Next& next) {
+    vector<node_type*> open;
+    TK key;
+    long long count = 0;
+    while (next(key)) {
+      count++;
+      if (open.empty()) open.push_back(pool.create(true));
+      node_type* leaf = open[0];
+      if (leaf->count < M - 1) {
+        leaf->keys[leaf->count++] = key;
+        continue;
+      }
+      open[0] = pool.create(true);
+      stream_attach(open, leaf, key);
+    }
+    if (open.empty()) return;
+
+    // colgar los nodos abiertos: cada uno es el ultimo hijo del de arriba
+    node_type* top = open[0];
+    for (size_t level = 1; level < open.size(); ++level) {
+      open[level]->children[open[level]->count] = top;
+      top = open[level];
+    }
+    // niveles de arriba que quedaron con un solo hijo
+    while (!top->leaf && top->count == 0) {
+      node_type* only = top->children[0];
+      pool.destroy(top);
+      top = only;
+    }
+    root = top;
+    n = static_cast<int>(count);
+    fix_right_spine();
+  }
+
+  // cierra child (lleno) en el nivel de arriba con sep como separador siguiente
+  void stream_attach(vector<node_type*>& open, node_type* child, const TK& sep) {
+    for (size_t level = 1;; ++level) {
+      recount(child);
+      if (open.size() == level) open.push_back(pool.create(false));
+      node_type* parent = open[level];
+      parent->children[parent->count] = child;
+      if (parent->count < M - 1) {
+        parent->keys[parent->count++] = sep;
+        return;
+      }
+      // el padre tambien se lleno: sube el mismo separador
+      open[level] = pool.create(false);
+      child = parent;
+    }
+  }
+
+  // los nodos del borde derecho pueden quedar bajo el minimo (los ultimos
+  // que se abrieron); cada uno se reparte con su hermano izquierdo, que esta
+  // lleno, asi ambos quedan con al menos el minimo sin cambiar al padre
+  void fix_right_spine() {
+    int min_keys = (M + 1) / 2 - 1;
+    vector<node_type*> spine;
+    for (node_type* x = root; !x->leaf; x = x->children[x->count]) {
+      spine.push_back(x);
+      node_type* right = x->children[x->count];
+      if (right->count >= min_keys) continue;
+      node_type* left = x->children[x->count - 1];
+
+      vector<TK> keys(left->keys, left->keys + left->count);
+      keys.push_back(x->keys[x->count - 1]);
+      keys.insert(keys.end(), right->keys, right->keys + right->count);
+      vector<node_type*> kids;
+      if (!left->leaf) {
+        kids.assign(left->children, left->children + left->count + 1);
+        kids.insert(kids.end(), right->children, right->children + right->count + 1);
+      }
+
+      int a = (static_cast<int>(keys.size()) - 1) / 2;
+      left->count = a;
+      std::copy(keys.begin(), keys.begin() + a, left->keys);
+      x->keys[x->count - 1] = keys[a];
+      right->count = static_cast<int>(keys.size()) - a - 1;
+      std::copy(keys.begin() + a + 1, keys.end(), right->keys);
+      if (!left->leaf) {
+        std::copy(kids.begin(), kids.begin() + a + 1, left->children);
+        std::copy(kids.begin() + a + 1, kids.end(), right->children);
+      }
+      recount(left);
+    }
+    // la ultima hoja del borde tambien pudo cambiar
+    node_type* last = root;
+    while (!last->leaf) last = last->children[last->count];
+    recount(last);
+    for (auto it = spine.rbegin(); it != spine.rend(); ++it) recount(*it);
+  }
+
+  // subarbol que un hilo construye con build_subtree_from_sorted
+  struct BuildTask {
+    int height;
+    long long target_n;
+    size_t start;       // posicion de su primera key en elements
+    node_type** slot;   // donde se cuelga el subarbol construido
+  };
+
+  // construccion paralela: los niveles de arriba se crean en este hilo hasta
+  // tener unas 4 tareas por hilo; cada tarea conoce su offset en elements por
+  // los tamaños de distribute_children_sizes, asi que no hay cursor compartido.
+  // Cada hilo usa su propio NodePool, que al final se une al del arbol.
+  node_type* build_parallel(const vector<TK>& elements, int h, long long N, const vector<long long>& minK,
+                            const vector<long long>& maxK, unsigned threads) {
+    vector<BuildTask> tasks;
+    vector<node_type*> upper;  // nodos de arriba en preorden
+    node_type* new_root = nullptr;
+    plan_parallel(elements, h, N, 0, true, 4 * static_cast<long long>(threads), &new_root, tasks, upper, minK, maxK);
+
+    unsigned used = static_cast<unsigned>(std::min<size_t>(threads, tasks.size()));
+    vector<unique_ptr<NodePool<TK, node_type>>> pools;
+    for (unsigned t = 0; t < used; ++t)
+      pools.push_back(make_unique<NodePool<TK, node_type>>(M, pool.resource(), pool.uses_huge_pages()));
+    vector<exception_ptr> errors(used);
+    vector<thread> workers;
+    for (unsigned t = 0; t < used; ++t) {
+      workers.emplace_back([&, t] {
+        try {
+          for (size_t i = tasks.size() * t / used; i < tasks.size() * (t + 1) / used; ++i) {
+            size_t pos = tasks[i].start;
+            *tasks[i].slot = build_subtree_from_sorted(*pools[t], elements, M, tasks[i].height, tasks[i].target_n,
+                                                       pos, minK, maxK, false);
+          }
+        } catch (...) {
+          errors[t] = current_exception();
+        }
+      });
+    }
+    for (thread& w : workers) w.join();
+    for (auto& p : pools) pool.absorb(*p);
+    for (exception_ptr& e : errors)
+      if (e) rethrow_exception(e);
+
+    // los hijos ya estan completos: recalcular la aumentacion de abajo hacia arriba
+    for (auto it = upper.rbegin(); it != upper.rend(); ++it) recount(*it);
+    return new_root;
+  }
+
+  void plan_parallel(const vector<TK>& elements, int height, long long target_n, size_t start, bool is_root,
+                     long long budget, node_type** slot, vector<BuildTask>& tasks, vector<node_type*>& upper,
+                     const vector<long long>& minK, const vector<long long>& maxK) {
+    if (height == 0 || budget <= 1) {
+      tasks.push_back({height, target_n, start, slot});
+      return;
+    }
+    vector<long long> child_sizes = plan_children(M, height, target_n, minK, maxK, is_root);
+    int k = static_cast<int>(child_sizes.size());
+    node_type* parent = pool.create(false);
+    upper.push_back(parent);
+    *slot = parent;
+    size_t pos = start;
+    for (int i = 0; i < k; ++i) {
+      plan_parallel(elements, height - 1, child_sizes[i], pos, false, budget / k, &parent->children[i], tasks, upper,
+                    minK, maxK);
+      pos += child_sizes[i];
+      if (i < k - 1) parent->keys[i] = elements[pos++];
+    }
+    parent->count = k - 1;
+  }
+
+  // verificacion de orden estricto, repartida en bloques entre hilos
+  static bool strictly_increasing(const vector<TK>& elements, unsigned threads) {
+    size_t size = elements.size();
+    if (threads <= 1 || size < (size_t(1) << 16)) {
+      for (size_t i = 1; i < size; ++i)
+        if (!key_less(elements[i - 1], elements[i])) return false;
+      return true;
+    }
+    vector<char> ok(threads, 1);
+    vector<thread> workers;
+    for (unsigned t = 0; t < threads; ++t) {
+      workers.emplace_back([&, t] {
+        size_t lo = std::max<size_t>(1, size * t / threads), hi = size * (t + 1) / threads;
+        for (size_t i = lo; i < hi; ++i)
+          if (!key_less(elements[i - 1], elements[i])) {
+            ok[t] = 0;
+            return;
+          }
+      });
+    }
+    for (thread& w : workers) w.join();
+    return std::all_of(ok.begin(), ok.end(), [](char c) { return c != 0; });
+  }
+
+  // metodos para la insercion por lotes
+  // [b, e) estrictamente ordenado
+  size_t insert_sorted_range(const TK* b, const TK* e) {
+    if (b == e) return 0;
+    int before = n;
+    edges_valid = false;
+
+    if (!root) {
+      build_sorted(vector<TK>(b, e));
+      return static_cast<size_t>(n);
+    }
+
+    vector<long long> minK, maxK;
+    compute_minmax_per_height(M, 64, minK, maxK);
+    int h = 0;
+    for (node_type* x = root; !x->leaf; x = x->children[0]) h++;
+    vector<pair<TK, node_type*>> extra;
+    merge_sorted_rec(root, h, b, e, extra, minK, maxK);
+    // la raiz se partio: agregar niveles hasta que quepa en un nodo
+    while (!extra.empty()) {
+      vector<TK> ks;
+      vector<node_type*> cs{root};
+      for (auto& p : extra) {
+        ks.push_back(p.first);
+        cs.push_back(p.second);
+      }
+      extra.clear();
+      root = pool.create(false);
+      distribute(root, ks, cs, extra);
+    }
+    return static_cast<size_t>(n - before);
+  }
+
+  // mezcla [b, e) en el subarbol de node, de altura h. Los nodos nuevos que
+  // quedan a la derecha de node se devuelven en out junto a su separador.
+  // Un hijo interno cuya parte del lote es al menos tan grande como el no se
+  // recorre: se reconstruye entero con sus keys y las del lote (ver
+  // rebuild_child), asi el costo es lineal en lo que se toca y el resto del
+  // arbol queda igual
+  void merge_sorted_rec(node_type* node, int h, const TK* b, const TK* e, vector<pair<TK, node_type*>>& out,
+                        const vector<long long>& minK, const vector<long long>& maxK) {
+    if (node->leaf) {
+      vector<TK> merged;
+      merged.reserve(node->count + (e - b));
+      std::set_union(node->keys, node->keys + node->count, b, e, back_inserter(merged), Compare());
+      n += static_cast<int>(merged.size()) - node->count;
+      distribute(node, merged, {}, out);
+      return;
+    }
+
+    vector<TK> ks;
+    vector<node_type*> cs;
+    const TK* p = b;
+    for (int i = 0; i <= node->count; ++i) {
+      // la parte del lote que cae en el hijo i
+      const TK* q = i < node->count ? std::lower_bound(p, e, node->keys[i], Compare()) : e;
+      node_type* child = node->children[i];
+      if (p < q && !child->leaf && q - p >= subtree_keys(child)) {
+        rebuild_child(child, h - 1, p, q, ks, cs, minK, maxK);
+      } else {
+        vector<pair<TK, node_type*>> child_out;
+        if (p < q) merge_sorted_rec(child, h - 1, p, q, child_out, minK, maxK);
+        cs.push_back(child);
+        for (auto& x : child_out) {
+          ks.push_back(x.first);
+          cs.push_back(x.second);
+        }
+      }
+      if (i < node->count) {
+        ks.push_back(node->keys[i]);
+        p = q;
+        if (p < e && !key_less(node->keys[i], *p)) ++p;  // ya estaba en el arbol
+      }
+    }
+    if (static_cast<int>(cs.size()) == node->count + 1) {
+      std::copy(cs.begin(), cs.end(), node->children);  // un hijo reconstruido puede ser otro nodo
+      recount(node);
+      return;
+    }
+    distribute(node, ks, cs, out);
+  }
+
+  // reemplaza el subarbol child, de altura h, por uno o mas subarboles de
+  // altura h con sus keys unidas a [b, e): se agregan a cs, con sus
+  // separadores en ks, para que el padre los reparta con distribute. Cada
+  // uno recibe la misma cantidad de keys, entre minK[h] y maxK[h]
+  void rebuild_child(node_type* child, int h, const TK* b, const TK* e, vector<TK>& ks, vector<node_type*>& cs,
+                     const vector<long long>& minK, const vector<long long>& maxK) {
+    vector<TK> old_keys;
+    move_keys_out(child, old_keys);
+    vector<TK> merged;
+    merged.reserve(old_keys.size() + (e - b));
+    std::set_union(old_keys.begin(), old_keys.end(), b, e, back_inserter(merged), Compare());
+    n += static_cast<int>(merged.size() - old_keys.size());
+    destroy_subtree(child);
+
+    long long t = static_cast<long long>(merged.size());
+    long long pieces = (t + maxK[h] + 1) / (maxK[h] + 1);  // techo((t + 1) / (maxK[h] + 1))
+    long long data = t - (pieces - 1);
+    size_t pos = 0;
+    for (long long i = 0; i < pieces; ++i) {
+      long long size = data / pieces + (i < data % pieces ? 1 : 0);
+      if (i > 0) ks.push_back(merged[pos++]);
+      cs.push_back(build_subtree_from_sorted(pool, merged, M, h, size, pos, minK, maxK, false));
+    }
+  }
+
+  // mueve a out las keys del subarbol de x en orden (el subarbol se descarta)
+  static void move_keys_out(node_type* x, vector<TK>& out) {
+    for (int i = 0; i < x->count; ++i) {
+      if (!x->leaf) move_keys_out(x->children[i], out);
+      out.push_back(std::move(x->keys[i]));
+    }
+    if (!x->leaf) move_keys_out(x->children[x->count], out);
+  }
+
+  // keys del subarbol de x: O(1) con Aug::counted, si no O(nodos)
+  static long long subtree_keys(node_type* x) {
+    if constexpr (Aug::counted) return subtree_size(x);
+    long long total = x->count;
+    if (!x->leaf) {
+      for (int i = 0; i <= x->count; ++i) total += subtree_keys(x->children[i]);
+    }
+    return total;
+  }
+
+  // reparte ks (y cs, con ks.size() + 1 hijos si es interno) en node y, si no
+  // caben, en los nodos nuevos de la derecha que hagan falta, todos con al
+  // menos el minimo de keys
+  void distribute(node_type* node, const vector<TK>& ks, const vector<node_type*>& cs,
+                  vector<pair<TK, node_type*>>& out) {
+    long long t = static_cast<long long>(ks.size());
+    long long pieces = (t + M) / M;  // techo((t + 1) / M)
+    long long data = t - (pieces - 1);
+    size_t idx = 0;
+    for (long long i = 0; i < pieces; ++i) {
+      int s = static_cast<int>(data / pieces + (i < data % pieces ? 1 : 0));
+      node_type* x = i == 0 ? node : pool.create(node->leaf);
+      if (i > 0) out.push_back({ks[idx++], x});
+      for (int j = 0; j < s; ++j) x->keys[j] = ks[idx + j];
+      if (!x->leaf) {
+        for (int j = 0; j <= s; ++j) x->children[j] = cs[idx + j];
+        for (int j = s + 1; j <= M; ++j) x->children[j] = nullptr;
+      }
+      x->count = s;
+      idx += s;
+      recount(x);
+    }
   }
 
   // helpers
-  void range_search_rec(Node<TK>* x, const TK& a, const TK& b, vector<TK>& out) {
+  void check_order() const {
+    if constexpr (is_same<Update, TopDown>::value) {
+      if (M < 4 || M % 2 != 0) throw std::invalid_argument("TopDown requiere M par y al menos 4");
+    }
+  }
+
+  template <typename K>
+  iterator lower_bound_of(const K& key) const {
+    iterator it(root);
+    for (node_type* nodo = root; nodo;) {
+      int pos = key_lower_bound(nodo->keys, nodo->count, key);
+      it.push(nodo, pos);
+      if ((pos < nodo->count && !key_less(key, nodo->keys[pos])) || nodo->leaf) break;
+      nodo = nodo->children[pos];
+    }
+    it.ascend_forward();
+    return it;
+  }
+
+  template <typename K>
+  iterator upper_bound_of(const K& key) const {
+    iterator it = lower_bound_of(key);
+    if (it != end() && !key_less(key, *it)) ++it;
+    return it;
+  }
+
+  template <typename K>
+  iterator find_of(const K& key) const {
+    iterator it = lower_bound_of(key);
+    return (it != end() && !key_less(key, *it)) ? it : end();
+  }
+
+  // orden de las keys segun Compare (a o b pueden ser de otro tipo si
+  // Compare es transparente). Dos keys son iguales si ninguna es menor
+  template <typename A, typename B>
+  static bool key_less(const A& a, const B& b) {
+    return Compare()(a, b);
+  }
+
+  // primer indice i con !key_less(keys[i], key) (ver node_search.h)
+  template <typename K>
+  static int key_lower_bound(const TK* keys, int count, const K& key) {
+    return node_lower_bound(keys, count, key, Compare());
+  }
+
+  // busquedas que avanzan juntas en searchBatch/findBatch
+  static constexpr int kBatchGroup = 16;
+
+  // emit(i, nodo, pos) por cada keys[i]: nodo es nullptr si no esta
+  template <typename Emit>
+  void batch_descend(const TK* keys, size_t count, bool sorted, Emit emit) const {
+    vector<size_t> order;
+    if (sorted) {
+      order.resize(count);
+      std::iota(order.begin(), order.end(), size_t(0));
+      auto by_key = [&](size_t a, size_t b) { return key_less(keys[a], keys[b]); };
+      if (!std::is_sorted(order.begin(), order.end(), by_key)) std::sort(order.begin(), order.end(), by_key);
+    }
+    // ordenado: camino compartido entre grupos (ver group_start)
+    node_type* path[iterator::kMaxDepth];
+    const TK* fence[iterator::kMaxDepth];
+    int depth = 0;
+
+    node_type* cur[kBatchGroup];
+    size_t idx[kBatchGroup];
+    for (size_t base = 0; base < count; base += kBatchGroup) {
+      int g = static_cast<int>(std::min<size_t>(kBatchGroup, count - base));
+      for (int j = 0; j < g; ++j) idx[j] = sorted ? order[base + j] : base + j;
+      if (!root) {
+        for (int j = 0; j < g; ++j) emit(idx[j], nullptr, 0);
+        continue;
+      }
+      node_type* start = sorted ? group_start(keys[idx[0]], keys[idx[g - 1]], path, fence, depth) : root;
+      for (int j = 0; j < g; ++j) cur[j] = start;
+      int active = g;
+
+      // un nivel por vuelta para todas las busquedas activas del grupo
+      while (active > 0) {
+        for (int j = 0; j < g; ++j) {
+          node_type* x = cur[j];
+          if (!x) continue;
+          const TK& key = keys[idx[j]];
+          int pos = key_lower_bound(x->keys, x->count, key);
+          if (pos < x->count && !key_less(key, x->keys[pos])) {
+            emit(idx[j], x, pos);
+          } else if (x->leaf) {
+            emit(idx[j], nullptr, 0);
+          } else {
+            // next->keys recien se lee en la proxima vuelta, cuando ya llego
+            node_type* next = x->children[pos];
+            pool.prefetch(next);
+            cur[j] = next;
+            continue;
+          }
+          cur[j] = nullptr;
+          active--;
+        }
+      }
+    }
+  }
+
+  // nodo mas profundo cuyo rango contiene a todo un grupo ordenado [first,
+  // last]. path guarda el camino del grupo anterior y fence el limite
+  // superior exclusivo de cada nodo (nullptr: sin limite); como los grupos
+  // vienen en orden creciente, se sube solo hasta el primer nodo cuyo fence
+  // supera a last y se baja desde ahi mientras todo el grupo vaya al mismo hijo
+  node_type* group_start(const TK& first, const TK& last, node_type** path, const TK** fence, int& depth) const {
+    while (depth > 0 && fence[depth - 1] && !key_less(last, *fence[depth - 1])) depth--;
+    if (depth == 0) {
+      path[0] = root;
+      fence[0] = nullptr;
+      depth = 1;
+    }
+    node_type* x = path[depth - 1];
+    while (!x->leaf) {
+      int pos = key_lower_bound(x->keys, x->count, last);
+      if (pos < x->count && !key_less(last, x->keys[pos])) break;  // last es una key de x
+      if (pos > 0 && !key_less(x->keys[pos - 1], first)) break;     // first va a otro hijo o esta en x
+      node_type* next = x->children[pos];
+      path[depth] = next;
+      fence[depth] = pos < x->count ? &x->keys[pos] : fence[depth - 1];
+      depth++;
+      x = next;
+    }
+    return x;
+  }
+
+  // keys del subarbol de x (solo con Aug::counted)
+  static long long subtree_size(node_type* x) {
+    if constexpr (Aug::counted) return x->leaf ? x->count : x->size;
+    return 0;
+  }
+
+  // recalcula la aumentacion de x a partir de sus hijos, O(M)
+  static void recount(node_type* x) {
+    if constexpr (Aug::counted) {
+      if (!x->leaf) {
+        long long total = x->count;
+        for (int i = 0; i <= x->count; ++i) total += subtree_size(x->children[i]);
+        x->size = total;
+      }
+    }
+    refresh_aggregate(x);
+  }
+
+  // recalcula solo el agregado de x (keys propias y agregados de los hijos)
+  static void refresh_aggregate(node_type* x) {
+    if constexpr (Aug::aggregated) {
+      using Mo = typename Aug::monoid;
+      auto acc = Mo::identity();
+      for (int i = 0; i < x->count; ++i) {
+        if (!x->leaf) acc = Mo::combine(acc, x->children[i]->agg);
+        acc = Mo::combine(acc, Mo::lift(x->keys[i]));
+      }
+      if (!x->leaf) acc = Mo::combine(acc, x->children[x->count]->agg);
+      x->agg = acc;
+    }
+  }
+
+  // agregado de las keys de x en [a, b]. lo_in / hi_in: todo el subarbol
+  // ya esta por encima de a / por debajo de b
+  template <typename V>
+  V aggregate_rec(node_type* x, const TK& a, const TK& b, bool lo_in, bool hi_in) const {
+    using Mo = typename Aug::monoid;
+    if (lo_in && hi_in) return x->agg;
+    V acc = Mo::identity();
+    int i = lo_in ? 0 : key_lower_bound(x->keys, x->count, a);
+    for (; i <= x->count; ++i) {
+      if (!x->leaf) {
+        // el hijo i esta entre keys[i - 1] (>= a si i > inicio) y keys[i]
+        bool child_lo = lo_in || (i > 0 && !key_less(x->keys[i - 1], a));
+        bool child_hi = hi_in || (i < x->count && !key_less(b, x->keys[i]));
+        acc = Mo::combine(acc, aggregate_rec<V>(x->children[i], a, b, child_lo, child_hi));
+      }
+      if (i == x->count || (!hi_in && key_less(b, x->keys[i]))) break;
+      acc = Mo::combine(acc, Mo::lift(x->keys[i]));
+    }
+    return acc;
+  }
+
+  // cantidad de keys < key (o <= key si inclusive), un solo descenso
+  long long count_less(const TK& key, bool inclusive) const { return count_less_in(root, key, inclusive); }
+
+  // lo mismo dentro del subarbol de x
+  static long long count_less_in(node_type* x, const TK& key, bool inclusive) {
+    long long r = 0;
+    while (x) {
+      int pos = key_lower_bound(x->keys, x->count, key);
+      bool found = pos < x->count && !key_less(key, x->keys[pos]);
+      r += pos;
+      if (!x->leaf) {
+        for (int i = 0; i < pos; ++i) r += subtree_size(x->children[i]);
+      }
+      if (found) {
+        if (!x->leaf) r += subtree_size(x->children[pos]);
+        return r + (inclusive ? 1 : 0);
+      }
+      x = x->leaf ? nullptr : x->children[pos];
+    }
+    return r;
+  }
+
+  // destruye las keys de todos los nodos (solo para TK no trivial)
+  void destroy_subtree(node_type* x) {
+    if (!x->leaf) {
+      for (int i = 0; i <= x->count; ++i) destroy_subtree(x->children[i]);
+    }
+    pool.destroy(x);
+  }
+
+  // Out: vector<TK> o cualquier destino con push_back (ver SliceWriter)
+  template <typename Out>
+  static void range_search_rec(node_type* x, const TK& a, const TK& b, Out& out) {
     if (!x) return;
 
     if (x->leaf) {
       for (int i = 0; i < x->count; ++i) {
-        if (x->keys[i] < a) continue;
-        if (b < x->keys[i]) break;
+        if (key_less(x->keys[i], a)) continue;
+        if (key_less(b, x->keys[i])) break;
         out.push_back(x->keys[i]);
       }
       return;
     }
 
-    for (int i = 0; i < x->count; ++i) {
+    // saltar los hijos que quedan completamente a la izquierda de a
+    for (int i = key_lower_bound(x->keys, x->count, a); i < x->count; ++i) {
       range_search_rec(x->children[i], a, b, out);
-
-      if (!(x->keys[i] < a) && !(b < x->keys[i]))
-        out.push_back(x->keys[i]);
-      else if (b < x->keys[i])
-        return;
+      if (key_less(b, x->keys[i])) return;
+      out.push_back(x->keys[i]);
     }
     range_search_rec(x->children[x->count], a, b, out);
   }
 
+  // metodos para la carga desde archivo
+  node_type* load_rec(const btree_file::FileImage& image, uint64_t off, int depth, int height, long long& total) {
+    namespace bf = btree_file;
+    bf::RecordHeader rh;
+    if (off % 8 != 0 || off < bf::kPage || off + sizeof(rh) > image.size()) throw runtime_error("Archivo corrupto");
+    memcpy(&rh, image.data() + off, sizeof(rh));
+    bool leaf = rh.leaf != 0;
+    if (rh.count < 1 || rh.count > M - 1 || leaf != (depth == height) ||
+        off + bf::record_bytes<TK>(rh.count, leaf) > image.size())
+      throw runtime_error("Archivo corrupto");
+
+    node_type* x = pool.create(leaf);
+    x->count = rh.count;
+    memcpy(x->keys, image.data() + off + bf::keys_offset<TK>(), sizeof(TK) * rh.count);
+    total += rh.count;
+    if (!leaf) {
+      for (int c = 0; c <= rh.count; ++c) {
+        uint64_t child;
+        memcpy(&child, image.data() + off + bf::children_offset<TK>(rh.count) + 8 * c, 8);
+        x->children[c] = load_rec(image, child, depth + 1, height, total);
+      }
+    }
+    recount(x);
+    return x;
+  }
+
+  // metodos para el recorrido de rangos en paralelo
+  // tarea: un subarbol entero (node) o una key suelta de un nodo interno
+  struct ScanTask {
+    node_type* node;
+    const TK* key;
+  };
+
+  // escribe keys consecutivas a partir de p, sin chequear capacidad
+  struct SliceWriter {
+    TK* p;
+    void push_back(const TK& key) { *p++ = key; }
+  };
+
+  // corta [a, b] en tareas en orden de keys: se expanden nivel por nivel los
+  // subarboles (hijos que tocan el rango y separadores dentro del rango)
+  // hasta tener target tareas o llegar a las hojas
+  vector<ScanTask> plan_scan(const TK& a, const TK& b, size_t target) const {
+    vector<ScanTask> tasks;
+    if (root) tasks.push_back({root, nullptr});
+    bool expanded = true;
+    while (expanded && tasks.size() < target) {
+      expanded = false;
+      vector<ScanTask> next;
+      for (const ScanTask& t : tasks) {
+        if (!t.node || t.node->leaf) {
+          next.push_back(t);
+          continue;
+        }
+        expanded = true;
+        node_type* x = t.node;
+        for (int i = key_lower_bound(x->keys, x->count, a); i <= x->count; ++i) {
+          next.push_back({x->children[i], nullptr});
+          if (i == x->count || key_less(b, x->keys[i])) break;
+          next.push_back({nullptr, &x->keys[i]});
+        }
+      }
+      tasks.swap(next);
+    }
+    return tasks;
+  }
+
+  // keys de la tarea en [a, b]; exacto solo con Aug::counted
+  static long long task_count(const ScanTask& t, const TK& a, const TK& b) {
+    if (!t.node) return 1;
+    return count_less_in(t.node, b, true) - count_less_in(t.node, a, false);
+  }
+
+  template <typename Out>
+  static void run_scan_task(const ScanTask& t, const TK& a, const TK& b, Out& out) {
+    if (t.node)
+      range_search_rec(t.node, a, b, out);
+    else
+      out.push_back(*t.key);
+  }
+
+  // body(i) para i en [0, count): cada hilo toma la siguiente tarea libre de
+  // un contador compartido, asi los subarboles grandes no frenan a los demas
+  template <typename Body>
+  static void run_tasks(size_t count, unsigned threads, Body body) {
+    unsigned used = static_cast<unsigned>(std::min<size_t>(threads, count));
+    atomic<size_t> next{0};
+    vector<exception_ptr> errors(used);
+    auto work = [&](unsigned t) {
+      try {
+        for (size_t i = next++; i < count; i = next++) body(i);
+      } catch (...) {
+        errors[t] = current_exception();
+      }
+    };
+    vector<thread> workers;
+    for (unsigned t = 1; t < used; ++t) workers.emplace_back(work, t);
+    if (used > 0) work(0);
+    for (thread& w : workers) w.join();
+    for (exception_ptr& e : errors)
+      if (e) rethrow_exception(e);
+  }
+
   //metodos de apoyo para la construccion de un arbol B desde un vector ordenado
 
 static void compute_minmax_per_height(int M, int max_h, vector<long long>& minK, vector<long long>& maxK) {
@@ -498,32 +2084,62 @@ static void compute_minmax_per_height(int M, int max_h, vector<long long>& minK,
   minK[0] = (minKeys > 0) ? minKeys : 1;
   maxK[0] = maxKeys;
 
+  // saturar en CAP para no desbordar en alturas grandes
+  const long long CAP = 1LL << 60;
+  for (int h = 1; h <= max_h; ++h) {
+    minK[h] = (minK[h - 1] >= CAP / minChildren) ? CAP : std::min(CAP, (long long)minChildren * minK[h - 1] + (minChildren - 1));
+    maxK[h] = (maxK[h - 1] >= CAP / maxChildren) ? CAP : std::min(CAP, (long long)maxChildren * maxK[h - 1] + (maxChildren - 1));
+  }
+}
+
+// keys por nodo para una ocupacion fill en (0, 1] de M - 1, sin bajar del
+// minimo de un nodo no raiz
+static int keys_for_fill(int M, double fill) {
+  if (!(fill > 0.0 && fill <= 1.0)) throw std::invalid_argument("La ocupacion debe estar en (0, 1]");
+  int minKeys = std::max((M + 1) / 2 - 1, 1);
+  long long keys = std::lround(fill * (M - 1));
+  return static_cast<int>(std::max<long long>(minKeys, std::min<long long>(keys, M - 1)));
+}
+
+// fillK[h]: keys de un subarbol de altura h con todos sus nodos de fill_keys
+// keys. Es un objetivo, no un limite: los limites siguen siendo minK y maxK
+static vector<long long> fill_sizes_per_height(int fill_keys, int max_h) {
+  const long long CAP = 1LL << 60;
+  vector<long long> fillK(max_h + 1);
+  fillK[0] = fill_keys;
   for (int h = 1; h <= max_h; ++h) {
-    long long min_sub = (long long)minChildren * minK[h - 1] + (minChildren - 1);
-    long long max_sub = (long long)maxChildren * maxK[h - 1] + (maxChildren - 1);
-    const long long INF = 1e30;
-    minK[h] = (min_sub < 0) ? INF : min_sub;
-    maxK[h] = (max_sub < 0) ? (1LL<<60) : std::min(max_sub, (1LL<<60));
+    fillK[h] = (fillK[h - 1] >= CAP / (fill_keys + 1)) ? CAP
+                                                       : std::min(CAP, (long long)(fill_keys + 1) * fillK[h - 1] + fill_keys);
   }
+  return fillK;
+}
+
+// la raiz de altura h admite N claves
+static bool root_fits(long long N, int h, const vector<long long>& minK, const vector<long long>& maxK) {
+  long long min_root = h == 0 ? 1 : 2 * minK[h - 1] + 1;  // raíz con al menos 2 hijos
+  return N >= min_root && N <= maxK[h];
 }
 
 //  altura minima posible para la raíz que admite N claves
 static int choose_height_for_root(long long N, int M, const vector<long long>& minK, const vector<long long>& maxK) {
   int max_h = (int)minK.size() - 1;
   for (int h = 0; h <= max_h; ++h) {
-    long long min_root, max_root;
-    if (h == 0) {
-      min_root = 1;
-      max_root = maxK[0];
-    } else {
-      min_root = 2 * minK[h - 1] + 1; // raíz con al menos 2 hijos
-      max_root = maxK[h];
-    }
-    if (N >= min_root && N <= max_root) return h;
+    if (root_fits(N, h, minK, maxK)) return h;
   }
   return -1;
 }
 
+// altura minima cuyos nodos, a la ocupacion de fillK, alcanzan para N
+// claves; si esa altura no es posible, la minima posible
+static int choose_height_for_fill(long long N, int M, const vector<long long>& minK, const vector<long long>& maxK,
+                                  const vector<long long>& fillK) {
+  int max_h = (int)minK.size() - 1;
+  for (int h = 0; h <= max_h; ++h) {
+    if (N <= fillK[h] && root_fits(N, h, minK, maxK)) return h;
+  }
+  return choose_height_for_root(N, M, minK, maxK);
+}
+
 // Numero de hijos k válido para un nodo interno
 static int choose_k_for_internal(long long target_n, long long minPer, long long maxPer, int k_min, int k_max) {
   for (int k = k_min; k <= k_max; ++k) {
@@ -598,24 +2214,16 @@ static void adjust_child_sizes(vector<long long>& sizes, long long minPer) {
   }
 }
 
-// Construye un subárbol con target_n llaves, consumiendo desde una posicion global pos
-static Node<TK>* build_subtree_from_sorted(const vector<TK>& elements, int M, int height, long long target_n,
-size_t& pos, const vector<long long>& minK, const vector<long long>& maxK, bool is_root) {
-  if (target_n <= 0) return nullptr;
-
+// cantidad de keys de cada hijo de un nodo interno de altura height con target_n llaves.
+// Sin fillK los primeros hijos se llenan al maximo; con fillK se usan los
+// hijos necesarios para no pasar ese objetivo (dentro de lo posible) y las
+// keys se reparten en partes iguales
+static vector<long long> plan_children(int M, int height, long long target_n, const vector<long long>& minK,
+const vector<long long>& maxK, bool is_root, const vector<long long>* fillK = nullptr) {
   int minKeys = (M + 1) / 2 - 1;
   int minChildren = minKeys + 1;
   int maxChildren = M;
 
-  // caso hoja
-  if (height == 0) {
-    Node<TK>* leaf = new Node<TK>(M);
-    leaf->leaf = true;
-    leaf->count = static_cast<int>(target_n);
-    for (int i = 0; i < leaf->count; ++i) leaf->keys[i] = elements[pos++];
-    return leaf;
-  }
-
   long long minPer = minK[height - 1];
   long long maxPer = maxK[height - 1];
 
@@ -623,28 +2231,65 @@ size_t& pos, const vector<long long>& minK, const vector<long long>& maxK, bool
   int k_max = maxChildren;
 
   int k = choose_k_for_internal(target_n, minPer, maxPer, k_min, k_max);
+  if (fillK) {
+    long long per = (*fillK)[height - 1];
+    long long want = (target_n + per + 1) / (per + 1);
+    long long k_hi = std::min<long long>(k_max, (target_n + 1) / (minPer + 1));
+    k = static_cast<int>(std::max<long long>(k, std::min(want, k_hi)));
+    long long child_total = target_n - (k - 1);
+    vector<long long> child_sizes(k, child_total / k);
+    for (long long i = 0; i < child_total % k; ++i) child_sizes[i]++;
+    return child_sizes;
+  }
   long long child_total = target_n - (k - 1);
 
   // repartir child_total entre k hijos
   vector<long long> child_sizes = distribute_children_sizes(child_total, k, minPer, maxPer);
   adjust_child_sizes(child_sizes, minPer);
+  return child_sizes;
+}
+
+// Construye un subárbol con target_n llaves, consumiendo desde una posicion global pos
+static node_type* build_subtree_from_sorted(NodePool<TK, node_type>& pool, const vector<TK>& elements, int M, int height, long long target_n,
+size_t& pos, const vector<long long>& minK, const vector<long long>& maxK, bool is_root) {
+  auto next = [&]() -> const TK& { return elements[pos++]; };
+  return build_subtree_from_source(pool, next, M, height, target_n, minK, maxK, is_root);
+}
+
+// lo mismo tomando las keys en orden de next(), sin acceso aleatorio
+template <typename Next>
+static node_type* build_subtree_from_source(NodePool<TK, node_type>& pool, Next& next, int M, int height, long long target_n,
+const vector<long long>& minK, const vector<long long>& maxK, bool is_root, const vector<long long>* fillK = nullptr) {
+  if (target_n <= 0) return nullptr;
+
+  // caso hoja
+  if (height == 0) {
+    node_type* leaf = pool.create(true);
+    leaf->count = static_cast<int>(target_n);
+    for (int i = 0; i < leaf->count; ++i) leaf->keys[i] = next();
+    recount(leaf);
+    return leaf;
+  }
+
+  vector<long long> child_sizes = plan_children(M, height, target_n, minK, maxK, is_root, fillK);
+  int k = static_cast<int>(child_sizes.size());
 
   // construir padre y sus hijos
-  Node<TK>* parent = new Node<TK>(M);
-  parent->leaf = false;
+  node_type* parent = pool.create(false);
   int key_idx = 0;
   for (int i = 0; i < k; ++i) {
-    Node<TK>* child = build_subtree_from_sorted(elements, M, height - 1, child_sizes[i], pos, minK, maxK, false);
+    node_type* child = build_subtree_from_source(pool, next, M, height - 1, child_sizes[i], minK, maxK, false, fillK);
     parent->children[i] = child;
     if (i < k - 1) {
-      parent->keys[key_idx++] = elements[pos++]; // "separador" tomado de la secuencia
+      parent->keys[key_idx++] = next(); // "separador" tomado de la secuencia
     }
   }
   parent->count = key_idx;
+  recount(parent);
   return parent;
 }
 
-  bool check(Node<TK>* x,
+  bool check(node_type* x,
               bool is_root,
               int depth,
               int& leaf_level,
@@ -661,17 +2306,16 @@ size_t& pos, const vector<long long>& minK, const vector<long long>& maxK, bool
     }
 
     for (int i = 1; i < x->count; ++i)
-      if (!(x->keys[i - 1] < x->keys[i])) return false;
+      if (!key_less(x->keys[i - 1], x->keys[i])) return false;
 
     if (x->leaf) {
-      for (int i = 0; i <= x->count; ++i)
-        if (x->children[i] != nullptr) return false;
+      if (x->children != nullptr) return false;
       if (leaf_level == -1)
         leaf_level = depth;
       else if (leaf_level != depth)
         return false;
       for (int i = 0; i < x->count; ++i) {
-        if (has_prev && !(prev < x->keys[i])) return false;
+        if (has_prev && !key_less(prev, x->keys[i])) return false;
         prev = x->keys[i];
         has_prev = true;
       }
@@ -685,7 +2329,7 @@ size_t& pos, const vector<long long>& minK, const vector<long long>& maxK, bool
       return false;
 
     for (int i = 0; i < x->count; ++i) {
-      if (has_prev && !(prev < x->keys[i])) return false;
+      if (has_prev && !key_less(prev, x->keys[i])) return false;
       prev = x->keys[i];
       has_prev = true;
       if (!check(x->children[i + 1], false, depth + 1, leaf_level, has_prev, prev))
@@ -694,22 +2338,12 @@ size_t& pos, const vector<long long>& minK, const vector<long long>& maxK, bool
     return true;
   }
 
-  bool search_rec(Node<TK>* nodo, TK key) {
+  template <typename K>
+  static bool search_rec(node_type* nodo, const K& key) {
     if (!nodo) return false;
-    int left = 0, right = nodo->count - 1;
-    int pos = nodo->count;
-    while (left <= right) {
-      int mid = left + (right - left) / 2;
-      if (nodo->keys[mid] == key) {
-        return true;
-      }
-      if (key < nodo->keys[mid]) {
-        pos = mid;
-        right = mid - 1;
-      } else {
-        left = mid + 1;
-        pos = left;
-      }
+    int pos = key_lower_bound(nodo->keys, nodo->count, key);
+    if (pos < nodo->count && !key_less(key, nodo->keys[pos])) {
+      return true;
     }
     if (nodo->leaf) {
       return false;
@@ -717,7 +2351,7 @@ size_t& pos, const vector<long long>& minK, const vector<long long>& maxK, bool
     return search_rec(nodo->children[pos], key);
   }
 
-  void toString(Node<TK>* nodo, const string& sep, string& out, bool& first) {
+  void toString(node_type* nodo, const string& sep, string& out, bool& first) {
     if (!nodo) return;
 
     // Si es hoja, simplemente imprime todas las claves en orden
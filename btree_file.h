@@ -0,0 +1,274 @@
+#ifndef BTREE_FILE_H
+#define BTREE_FILE_H
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define BTREE_FILE_MMAP 1
+#endif
+#include "node_search.h"
+using namespace std;
+
+// Formato binario de BTree::save / BTree::load / MappedBTree.
+//
+//   [0, kPage)       BTreeFileHeader, el resto de la pagina en cero
+//   [kPage, ...)     un registro por nodo, en orden por niveles (BFS)
+//   relleno en cero hasta un multiplo de kPage
+//
+// Registro: {int32 count, int32 leaf}, count keys (alineadas a su tipo) y,
+// en nodos internos, count + 1 offsets uint64 de los hijos (alineados a 8).
+// Los offsets son bytes desde el inicio del archivo, asi el archivo se puede
+// mapear en cualquier direccion y leerse sin deserializar. Cada registro
+// empieza en un multiplo de 8. Las keys se guardan con su representacion en
+// memoria: TK debe ser trivialmente copiable y el archivo solo se lee en
+// maquinas con el mismo orden de bytes (se verifica con endian_tag).
+namespace btree_file {
+
+constexpr size_t kPage = 4096;
+constexpr char kMagic[8] = {'B', 'T', 'R', 'E', 'E', 'B', 'I', 'N'};
+constexpr uint32_t kVersion = 1;
+constexpr uint64_t kEndianTag = 0x0102030405060708ULL;
+
+struct Header {
+  char magic[8];
+  uint32_t version;
+  uint32_t key_size;
+  uint64_t endian_tag;
+  int32_t M;
+  int32_t height;
+  int64_t n;
+  uint64_t node_count;
+  uint64_t root_offset;  // 0: arbol vacio
+  uint64_t file_size;
+};
+static_assert(sizeof(Header) <= kPage, "el header debe entrar en una pagina");
+
+struct RecordHeader {
+  int32_t count;
+  int32_t leaf;
+};
+
+constexpr size_t round_up(size_t x, size_t a) { return (x + a - 1) / a * a; }
+
+template <typename TK>
+constexpr size_t keys_offset() {
+  return round_up(sizeof(RecordHeader), alignof(TK));
+}
+
+template <typename TK>
+constexpr size_t children_offset(int count) {
+  return round_up(keys_offset<TK>() + sizeof(TK) * count, alignof(uint64_t));
+}
+
+template <typename TK>
+constexpr size_t record_bytes(int count, bool leaf) {
+  return round_up(leaf ? keys_offset<TK>() + sizeof(TK) * count : children_offset<TK>(count) + 8 * (count + 1), 8);
+}
+
+// valida el header contra el tamaño real del archivo y el tipo de key
+template <typename TK>
+void check_header(const Header& h, size_t actual_size) {
+  if (memcmp(h.magic, kMagic, sizeof(kMagic)) != 0) throw runtime_error("No es un archivo de BTree");
+  if (h.version != kVersion) throw runtime_error("Version de archivo no soportada");
+  if (h.endian_tag != kEndianTag) throw runtime_error("Archivo con otro orden de bytes");
+  if (h.key_size != sizeof(TK)) throw runtime_error("El tamaño de key del archivo no coincide");
+  if (h.file_size != actual_size || actual_size < kPage || actual_size % kPage != 0)
+    throw runtime_error("Archivo truncado o corrupto");
+  if (h.M < 3 || h.root_offset >= actual_size) throw runtime_error("Archivo corrupto");
+}
+
+// escritura con buffer sobre FILE*; cierra el archivo al destruirse
+class Writer {
+  FILE* f;
+  string path;
+
+ public:
+  explicit Writer(const string& _path) : f(fopen(_path.c_str(), "wb")), path(_path) {
+    if (!f) throw runtime_error("No se pudo abrir " + path + " para escritura");
+    setvbuf(f, nullptr, _IOFBF, 1 << 20);
+  }
+  ~Writer() {
+    if (f) fclose(f);
+  }
+  Writer(const Writer&) = delete;
+  Writer& operator=(const Writer&) = delete;
+
+  void write(const void* data, size_t bytes) {
+    if (bytes && fwrite(data, 1, bytes, f) != bytes) throw runtime_error("Error escribiendo " + path);
+  }
+  void zeros(size_t bytes) {
+    static const char pad[kPage] = {};
+    while (bytes) {
+      size_t chunk = bytes < kPage ? bytes : kPage;
+      write(pad, chunk);
+      bytes -= chunk;
+    }
+  }
+  void close() {
+    int r = fclose(f);
+    f = nullptr;
+    if (r != 0) throw runtime_error("Error cerrando " + path);
+  }
+};
+
+// contenido del archivo en memoria: mapeado con mmap o, sin POSIX, leido
+class FileImage {
+  const char* base;
+  size_t bytes;
+  vector<char> buffer;
+  bool mapped;
+
+ public:
+  explicit FileImage(const string& path) : base(nullptr), bytes(0), mapped(false) {
+#ifdef BTREE_FILE_MMAP
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) throw runtime_error("No se pudo abrir " + path);
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+      ::close(fd);
+      throw runtime_error("No se pudo leer " + path);
+    }
+    bytes = static_cast<size_t>(st.st_size);
+    if (bytes > 0) {
+      void* p = mmap(nullptr, bytes, PROT_READ, MAP_SHARED, fd, 0);
+      if (p == MAP_FAILED) {
+        ::close(fd);
+        throw runtime_error("No se pudo mapear " + path);
+      }
+      base = static_cast<const char*>(p);
+      mapped = true;
+    }
+    ::close(fd);
+#else
+    FILE* f = fopen(path.c_str(), "rb");
+    if (!f) throw runtime_error("No se pudo abrir " + path);
+    fseek(f, 0, SEEK_END);
+    bytes = static_cast<size_t>(ftell(f));
+    fseek(f, 0, SEEK_SET);
+    buffer.resize(bytes);
+    size_t got = fread(buffer.data(), 1, bytes, f);
+    fclose(f);
+    if (got != bytes) throw runtime_error("Error leyendo " + path);
+    base = buffer.data();
+#endif
+  }
+
+  ~FileImage() {
+#ifdef BTREE_FILE_MMAP
+    if (mapped) munmap(const_cast<char*>(base), bytes);
+#endif
+  }
+
+  FileImage(const FileImage&) = delete;
+  FileImage& operator=(const FileImage&) = delete;
+
+  const char* data() const { return base; }
+  size_t size() const { return bytes; }
+};
+
+}  // namespace btree_file
+
+// Arbol de solo lectura servido directo desde un archivo de BTree::save.
+// Abrir cuesta un mmap y validar el header; las paginas se cargan a demanda
+// en la primera busqueda que las toca. Los offsets de los registros no se
+// validan en cada acceso: el archivo debe venir de BTree::save.
+template <typename TK>
+class MappedBTree {
+  static_assert(is_trivially_copyable<TK>::value, "MappedBTree requiere keys trivialmente copiables");
+
+  btree_file::FileImage image;
+  btree_file::Header header;
+
+ public:
+  explicit MappedBTree(const string& path) : image(path) {
+    if (image.size() < sizeof(btree_file::Header)) throw runtime_error("Archivo truncado o corrupto");
+    memcpy(&header, image.data(), sizeof(header));
+    btree_file::check_header<TK>(header, image.size());
+  }
+
+  MappedBTree(const MappedBTree&) = delete;
+  MappedBTree& operator=(const MappedBTree&) = delete;
+
+  //indica si se encuentra o no un elemento
+  bool search(TK key) const {
+    for (uint64_t off = header.root_offset; off;) {
+      int count = count_of(off);
+      const TK* keys = keys_of(off);
+      int pos = node_lower_bound(keys, count, key);
+      if (pos < count && keys[pos] == key) return true;
+      off = leaf_of(off) ? 0 : children_of(off)[pos];
+    }
+    return false;
+  }
+
+  vector<TK> rangeSearch(TK begin, TK end) const {
+    vector<TK> out;
+    if (end < begin) std::swap(begin, end);
+    if (header.root_offset) range_search_rec(header.root_offset, begin, end, out);
+    return out;
+  }
+
+  // mínimo valor del árbol
+  TK minKey() const {
+    if (!header.root_offset) throw runtime_error("El árbol está vacío");
+    uint64_t off = header.root_offset;
+    while (!leaf_of(off)) off = children_of(off)[0];
+    return keys_of(off)[0];
+  }
+
+  // máximo valor del árbol
+  TK maxKey() const {
+    if (!header.root_offset) throw runtime_error("El árbol está vacío");
+    uint64_t off = header.root_offset;
+    while (!leaf_of(off)) off = children_of(off)[count_of(off)];
+    return keys_of(off)[count_of(off) - 1];
+  }
+
+  //altura del arbol. Considerar altura 0 para arbol vacio
+  int height() const { return header.height; }
+  int size() const { return static_cast<int>(header.n); }
+  int order() const { return header.M; }
+  size_t node_count() const { return header.node_count; }
+  size_t file_size() const { return image.size(); }
+
+ private:
+  const btree_file::RecordHeader* record(uint64_t off) const {
+    return reinterpret_cast<const btree_file::RecordHeader*>(image.data() + off);
+  }
+  int count_of(uint64_t off) const { return record(off)->count; }
+  bool leaf_of(uint64_t off) const { return record(off)->leaf != 0; }
+  const TK* keys_of(uint64_t off) const {
+    return reinterpret_cast<const TK*>(image.data() + off + btree_file::keys_offset<TK>());
+  }
+  const uint64_t* children_of(uint64_t off) const {
+    return reinterpret_cast<const uint64_t*>(image.data() + off + btree_file::children_offset<TK>(count_of(off)));
+  }
+
+  void range_search_rec(uint64_t off, const TK& a, const TK& b, vector<TK>& out) const {
+    int count = count_of(off);
+    const TK* keys = keys_of(off);
+    int i = node_lower_bound(keys, count, a);
+    if (leaf_of(off)) {
+      for (; i < count && !(b < keys[i]); ++i) out.push_back(keys[i]);
+      return;
+    }
+    const uint64_t* children = children_of(off);
+    for (; i < count; ++i) {
+      range_search_rec(children[i], a, b, out);
+      if (b < keys[i]) return;
+      out.push_back(keys[i]);
+    }
+    range_search_rec(children[count], a, b, out);
+  }
+};
+
+#endif
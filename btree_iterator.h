@@ -0,0 +1,124 @@
+#ifndef BTREE_ITERATOR_H
+#define BTREE_ITERATOR_H
+#include <cstddef>
+#include <iterator>
+#include "node.h"
+
+using namespace std;
+
+// Iterador bidireccional inorder sobre un BTree<TK>.
+// Guarda el camino desde la raiz como una pila de (nodo, indice) sin memoria
+// dinamica: en los nodos del camino el indice es el hijo por el que se bajo
+// y en el tope es la key actual. ++ y -- son O(1) amortizado.
+// Cualquier insert/remove/clear del arbol invalida los iteradores.
+template <typename TK, typename NodeT = Node<TK>>
+class BTreeIterator {
+ public:
+  using iterator_category = bidirectional_iterator_tag;
+  using value_type = TK;
+  using difference_type = ptrdiff_t;
+  using pointer = const TK*;
+  using reference = const TK&;
+
+  // n es int, asi que la altura (factor minimo 2) nunca supera 31
+  static constexpr int kMaxDepth = 32;
+
+ private:
+  struct Frame {
+    NodeT* node;
+    int idx;
+  };
+
+  NodeT* root;  // para poder retroceder desde end()
+  Frame path[kMaxDepth];
+  int depth;  // cantidad de frames; 0 es end()
+
+ public:
+  BTreeIterator() : root(nullptr), depth(0) {}
+  explicit BTreeIterator(NodeT* _root) : root(_root), depth(0) {}
+
+  reference operator*() const { return path[depth - 1].node->keys[path[depth - 1].idx]; }
+  pointer operator->() const { return &**this; }
+
+  BTreeIterator& operator++() {
+    Frame& top = path[depth - 1];
+    if (top.node->leaf) {
+      if (++top.idx < top.node->count) return *this;
+      depth--;
+      ascend_forward();
+    } else {
+      // sucesor: la key mas chica del subarbol derecho
+      top.idx++;
+      push_leftmost(top.node->children[top.idx]);
+    }
+    return *this;
+  }
+
+  BTreeIterator& operator--() {
+    if (depth == 0) {
+      // --end(): la key maxima
+      if (root) push_rightmost(root);
+      return *this;
+    }
+    Frame& top = path[depth - 1];
+    if (top.node->leaf) {
+      if (--top.idx >= 0) return *this;
+      depth--;
+      // subir hasta un padre al que se haya bajado por un hijo > 0
+      while (depth > 0 && path[depth - 1].idx == 0) depth--;
+      if (depth > 0) path[depth - 1].idx--;
+    } else {
+      // predecesor: la key mas grande del subarbol izquierdo
+      push_rightmost(top.node->children[top.idx]);
+    }
+    return *this;
+  }
+
+  BTreeIterator operator++(int) {
+    BTreeIterator tmp = *this;
+    ++*this;
+    return tmp;
+  }
+
+  BTreeIterator operator--(int) {
+    BTreeIterator tmp = *this;
+    --*this;
+    return tmp;
+  }
+
+  bool operator==(const BTreeIterator& other) const {
+    if (depth == 0 || other.depth == 0) return depth == other.depth;
+    return path[depth - 1].node == other.path[other.depth - 1].node &&
+           path[depth - 1].idx == other.path[other.depth - 1].idx;
+  }
+  bool operator!=(const BTreeIterator& other) const { return !(*this == other); }
+
+ private:
+  template <typename, typename, typename, typename>
+  friend class BTree;
+
+  void push(NodeT* node, int idx) { path[depth++] = {node, idx}; }
+
+  void push_leftmost(NodeT* node) {
+    while (!node->leaf) {
+      push(node, 0);
+      node = node->children[0];
+    }
+    push(node, 0);
+  }
+
+  void push_rightmost(NodeT* node) {
+    while (!node->leaf) {
+      push(node, node->count);
+      node = node->children[node->count];
+    }
+    push(node, node->count - 1);
+  }
+
+  // tras agotar un subarbol: subir hasta un padre con key pendiente
+  void ascend_forward() {
+    while (depth > 0 && path[depth - 1].idx >= path[depth - 1].node->count) depth--;
+  }
+};
+
+#endif
@@ -0,0 +1,504 @@
+#ifndef BTREE_MAP_H
+#define BTREE_MAP_H
+#include <memory_resource>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "node.h"
+#include "node_pool.h"
+#include "node_search.h"
+using namespace std;
+
+// Arbol B clave-valor: mismos algoritmos que BTree (split al llegar a M
+// keys, sucesor, borrow y merge), con el valor de cada key en un arreglo
+// paralelo del mismo nodo (ver MapNode). Las busquedas solo leen keys; el
+// valor se lee o escribe una vez encontrada la key, sin un segundo indice.
+//
+// Los nodos salen de un NodePool con los valores en el mismo bloque. TV
+// debe ser construible por defecto (los M valores de cada nodo se
+// construyen al crear el nodo); los valores se mueven, no se copian, en los
+// splits y rebalanceos. Los punteros devueltos por find/try_emplace/
+// insert_or_assign quedan invalidos con el siguiente insert o erase.
+template <typename TK, typename TV>
+class BTreeMap {
+  //La implementación de este BTree no soporta valores repetidos
+ public:
+  using node_type = MapNode<TK, TV>;
+
+ private:
+  // posicion de una key dentro del arbol; node == nullptr mientras la key
+  // es la que sube por un split
+  struct Slot {
+    node_type* node;
+    int idx;
+  };
+
+  node_type* root;
+  int M;  // grado u orden del arbol
+  int n;  // total de elementos en el arbol
+  NodePool<TK, node_type, TV> pool;  // origen de todos los nodos del arbol
+
+ public:
+  BTreeMap(int _M) : root(nullptr), M(_M), n(0), pool(_M) {
+    if (M < 3) throw std::invalid_argument("M debe ser al menos 3");
+  }
+
+  // politica de memoria: slabs pedidos a upstream, opcionalmente con huge pages
+  BTreeMap(int _M, pmr::memory_resource* upstream, bool huge_pages = false)
+      : root(nullptr), M(_M), n(0), pool(_M, upstream, huge_pages) {
+    if (M < 3) throw std::invalid_argument("M debe ser al menos 3");
+  }
+
+  BTreeMap(const BTreeMap&) = delete;
+  BTreeMap& operator=(const BTreeMap&) = delete;
+
+  ~BTreeMap() { clear(); }
+
+  // puntero al valor de key, o nullptr si no esta
+  TV* find(const TK& key) {
+    Slot s = locate(key);
+    return s.node ? &s.node->values[s.idx] : nullptr;
+  }
+  const TV* find(const TK& key) const { return const_cast<BTreeMap*>(this)->find(key); }
+
+  bool contains(const TK& key) const { return locate(key).node != nullptr; }
+
+  TV& at(const TK& key) {
+    TV* v = find(key);
+    if (!v) throw std::out_of_range("Key no encontrada");
+    return *v;
+  }
+  const TV& at(const TK& key) const { return const_cast<BTreeMap*>(this)->at(key); }
+
+  // valor de key, insertando uno construido por defecto si no estaba
+  TV& operator[](const TK& key) { return *try_emplace(key).first; }
+
+  // inserta key con TV(args...) si no estaba; si estaba no toca su valor.
+  // Devuelve el valor de key y si se inserto
+  template <typename... Args>
+  pair<TV*, bool> try_emplace(const TK& key, Args&&... args) {
+    return insert_with(key, [&](TV& slot) { slot = TV(std::forward<Args>(args)...); });
+  }
+
+  // inserta key con value, o reemplaza su valor si ya estaba
+  template <typename V>
+  pair<TV*, bool> insert_or_assign(const TK& key, V&& value) {
+    bool inserted = false;
+    pair<TV*, bool> r = insert_with(key, [&](TV& slot) {
+      slot = std::forward<V>(value);
+      inserted = true;
+    });
+    if (!inserted) *r.first = std::forward<V>(value);
+    return r;
+  }
+
+  // true si la key estaba
+  bool erase(const TK& key) {
+    if (!root || !remove_rec(root, key)) return false;
+    n--;
+    // Si la raíz quedó vacía pero tiene un hijo, promoverlo
+    if (root->count == 0 && !root->leaf) {
+      node_type* old_root = root;
+      root = root->children[0];
+      pool.destroy(old_root);
+    }
+    // Si el árbol quedó completamente vacío
+    if (root->count == 0 && root->leaf) {
+      pool.destroy(root);
+      root = nullptr;
+    }
+    return true;
+  }
+
+  // f(key, valor) por cada par, en orden de keys
+  template <typename F>
+  void for_each(F f) const {
+    if (root) for_each_rec(root, f);
+  }
+
+  // pares con key en [begin, end], en orden
+  vector<pair<TK, TV>> rangeSearch(TK begin, TK end) const {
+    vector<pair<TK, TV>> out;
+    if (end < begin) std::swap(begin, end);
+    if (root) range_search_rec(root, begin, end, out);
+    return out;
+  }
+
+  // mínimo valor del árbol
+  TK minKey() const {
+    if (!root) throw runtime_error("El árbol está vacío");
+    node_type* temp = root;
+    while (!temp->leaf) temp = temp->children[0];
+    return temp->keys[0];
+  }
+
+  // máximo valor del árbol
+  TK maxKey() const {
+    if (!root) throw runtime_error("El árbol está vacío");
+    node_type* temp = root;
+    while (!temp->leaf) temp = temp->children[temp->count];
+    return temp->keys[temp->count - 1];
+  }
+
+  //altura del arbol. Considerar altura 0 para arbol vacio
+  int height() const {
+    if (!root) return 0;
+    int cont = 0;
+    for (node_type* temp = root; !temp->leaf; temp = temp->children[0]) cont++;
+    return cont;
+  }
+
+  int size() const { return n; }
+  bool empty() const { return n == 0; }
+
+  // eliminar todos lo elementos del arbol: se devuelven los slabs completos,
+  // O(#slabs) si TK y TV son trivialmente destructibles
+  void clear() {
+    if constexpr (!is_trivially_destructible<TK>::value || !is_trivially_destructible<TV>::value) {
+      if (root) destroy_subtree(root);
+    }
+    pool.release();
+    root = nullptr;
+    n = 0;
+  }
+
+  // estadisticas del reservador de nodos
+  size_t node_count() const { return pool.live_nodes(); }
+  size_t memory_used() const { return pool.bytes_used(); }
+  size_t leaf_node_bytes() const { return pool.leaf_node_bytes(); }
+  size_t internal_node_bytes() const { return pool.internal_node_bytes(); }
+
+  // Verifique las propiedades de un árbol B
+  bool check_properties() const {
+    if (!root) return n == 0;
+    int leaf_level = -1;
+    bool has_prev = false;
+    TK prev{};
+    long long total = 0;
+    return check(root, true, 1, leaf_level, has_prev, prev, total) && total == n;
+  }
+
+ private:
+  Slot locate(const TK& key) const {
+    for (node_type* nodo = root; nodo;) {
+      int pos = node_lower_bound(nodo->keys, nodo->count, key);
+      if (pos < nodo->count && nodo->keys[pos] == key) return {nodo, pos};
+      nodo = nodo->leaf ? nullptr : nodo->children[pos];
+    }
+    return {nullptr, 0};
+  }
+
+  // make(slot) escribe el valor de una key nueva; no se llama si ya estaba
+  template <typename Make>
+  pair<TV*, bool> insert_with(const TK& key, Make make) {
+    //caso1: arbol sin raiz
+    if (!root) {
+      root = pool.create(true);
+      root->keys[0] = key;
+      make(root->values[0]);
+      root->count = 1;
+      n = 1;
+      return {&root->values[0], true};
+    }
+
+    //caso2: insertar normalmente
+    bool inserted = false;
+    Slot slot{nullptr, 0};
+    TK promoted_key;
+    TV promoted_value;
+    node_type* new_child = insert_rec(root, key, make, promoted_key, promoted_value, slot, inserted);
+
+    //caso3: split en la raiz
+    if (new_child) {
+      node_type* new_root = pool.create(false);
+      new_root->keys[0] = std::move(promoted_key);
+      new_root->values[0] = std::move(promoted_value);
+      new_root->count = 1;
+      new_root->children[0] = root;
+      new_root->children[1] = new_child;
+      root = new_root;
+      if (!slot.node) slot = {new_root, 0};
+    }
+    return {&slot.node->values[slot.idx], inserted};
+  }
+
+  // metodos para la insercion
+  // el par del medio sube (promoted_key/promoted_value); slot sigue a la key
+  // insertada o encontrada si estaba en node
+  node_type* split(node_type* node, TK& promoted_key, TV& promoted_value, Slot& slot) {
+    int mid_idx = M / 2;
+    promoted_key = std::move(node->keys[mid_idx]);
+    promoted_value = std::move(node->values[mid_idx]);
+
+    // partir a la mitad el nodo actual
+    node_type* right = pool.create(node->leaf);
+    int j = 0;
+    for (int i = mid_idx + 1; i < node->count; i++, j++) {
+      right->keys[j] = std::move(node->keys[i]);
+      right->values[j] = std::move(node->values[i]);
+    }
+    right->count = j;
+
+    // organizar los hijos si no es hoja
+    if (!node->leaf) {
+      for (int i = mid_idx + 1, k = 0; i <= node->count; i++, k++) {
+        right->children[k] = node->children[i];
+        node->children[i] = nullptr;
+      }
+    }
+    if (slot.node == node && slot.idx >= mid_idx)
+      slot = slot.idx == mid_idx ? Slot{nullptr, 0} : Slot{right, slot.idx - mid_idx - 1};
+    node->count = mid_idx;
+    return right;  // se retorna el par que sube y el nodo partido
+  }
+
+  template <typename Make>
+  node_type* insert_rec(node_type* node, const TK& key, Make& make, TK& promoted_key, TV& promoted_value,
+                        Slot& slot, bool& inserted) {
+    //indice del primer key >= key
+    int child_idx = node_lower_bound(node->keys, node->count, key);
+    if (child_idx < node->count && node->keys[child_idx] == key) {
+      slot = {node, child_idx};  // llave duplicada, sin insercion
+      return nullptr;
+    }
+
+    if (node->leaf) {
+      // insertar en hoja desplazando keys y valores
+      for (int i = node->count; i > child_idx; i--) {
+        node->keys[i] = std::move(node->keys[i - 1]);
+        node->values[i] = std::move(node->values[i - 1]);
+      }
+      node->keys[child_idx] = key;
+      make(node->values[child_idx]);
+      node->count++;
+      n++;
+      inserted = true;
+      slot = {node, child_idx};
+
+      //split en hoja
+      if (node->count == M) return split(node, promoted_key, promoted_value, slot);
+      return nullptr;
+    }
+
+    // nodo interno = descender recursivamente
+    TK child_promoted_key;
+    TV child_promoted_value;
+    node_type* new_child =
+        insert_rec(node->children[child_idx], key, make, child_promoted_key, child_promoted_value, slot, inserted);
+    if (!new_child) return nullptr;  // sin split
+
+    // hubo split, insertar el par promovido en padre
+    for (int i = node->count; i > child_idx; i--) {
+      node->keys[i] = std::move(node->keys[i - 1]);
+      node->values[i] = std::move(node->values[i - 1]);
+      node->children[i + 1] = node->children[i];
+    }
+    node->keys[child_idx] = std::move(child_promoted_key);
+    node->values[child_idx] = std::move(child_promoted_value);
+    node->children[child_idx + 1] = new_child;
+    node->count++;
+    if (!slot.node) slot = {node, child_idx};
+
+    // split en padre
+    if (node->count == M) return split(node, promoted_key, promoted_value, slot);
+    return nullptr;
+  }
+
+  // metodos para la eliminacion
+  bool remove_rec(node_type* node, TK key) {
+    int min_keys = (M + 1) / 2 - 1;
+
+    // buscar la posición (o el hijo por el que descender)
+    int child_idx = node_lower_bound(node->keys, node->count, key);
+    bool here = child_idx < node->count && node->keys[child_idx] == key;
+
+    if (node->leaf) {
+      if (!here) return false;  // Key no encontrada
+      // eliminar el par desplazando elementos
+      for (int i = child_idx; i < node->count - 1; i++) {
+        node->keys[i] = std::move(node->keys[i + 1]);
+        node->values[i] = std::move(node->values[i + 1]);
+      }
+      node->count--;
+      node->values[node->count] = TV();  // soltar lo que guarde el valor movido
+      return true;
+    }
+
+    //caso3: key en nodo interno, reemplazar con sucesor
+    if (here) {
+      node_type* succ = node->children[child_idx + 1];
+      while (!succ->leaf) succ = succ->children[0];
+      node->keys[child_idx] = succ->keys[0];
+      node->values[child_idx] = std::move(succ->values[0]);
+      key = succ->keys[0];  // eliminar sucesor del hijo derecho
+      child_idx++;
+    }
+
+    //nodo interno: descender al hijo apropiado
+    node_type* child = node->children[child_idx];
+    if (!remove_rec(child, key)) return false;
+
+    // si el hijo quedó con menos del mínimo
+    if (child->count < min_keys) fix_child(node, child_idx);
+    return true;
+  }
+
+  // arreglar un hijo que quedó con menos del mínimo
+  void fix_child(node_type* parent, int child_idx) {
+    int min_keys = (M + 1) / 2 - 1;
+
+    //caso1: intentar borrow de hermano izquierdo
+    if (child_idx > 0 && parent->children[child_idx - 1]->count > min_keys) {
+      borrow_from_left(parent, child_idx);
+      return;
+    }
+
+    //  caso2: intentar borrow de hermano derecho
+    if (child_idx < parent->count && parent->children[child_idx + 1]->count > min_keys) {
+      borrow_from_right(parent, child_idx);
+      return;
+    }
+
+    //caso3 : merge con hermano
+    merge(parent, child_idx > 0 ? child_idx - 1 : child_idx);
+  }
+
+  // Rotar: tomar un par del hermano izquierdo
+  void borrow_from_left(node_type* parent, int child_idx) {
+    node_type* child = parent->children[child_idx];
+    node_type* left = parent->children[child_idx - 1];
+    for (int i = child->count; i > 0; i--) {
+      child->keys[i] = std::move(child->keys[i - 1]);
+      child->values[i] = std::move(child->values[i - 1]);
+    }
+    if (!child->leaf) {
+      for (int i = child->count + 1; i > 0; i--) child->children[i] = child->children[i - 1];
+      child->children[0] = left->children[left->count];
+      left->children[left->count] = nullptr;
+    }
+    child->keys[0] = std::move(parent->keys[child_idx - 1]);
+    child->values[0] = std::move(parent->values[child_idx - 1]);
+    child->count++;
+    left->count--;
+    parent->keys[child_idx - 1] = std::move(left->keys[left->count]);
+    parent->values[child_idx - 1] = std::move(left->values[left->count]);
+  }
+
+  void borrow_from_right(node_type* parent, int child_idx) {
+    node_type* child = parent->children[child_idx];
+    node_type* right = parent->children[child_idx + 1];
+    child->keys[child->count] = std::move(parent->keys[child_idx]);
+    child->values[child->count] = std::move(parent->values[child_idx]);
+    child->count++;
+    parent->keys[child_idx] = std::move(right->keys[0]);
+    parent->values[child_idx] = std::move(right->values[0]);
+    if (!child->leaf) child->children[child->count] = right->children[0];
+    for (int i = 0; i < right->count - 1; i++) {
+      right->keys[i] = std::move(right->keys[i + 1]);
+      right->values[i] = std::move(right->values[i + 1]);
+    }
+    if (!right->leaf) {
+      for (int i = 0; i < right->count; i++) right->children[i] = right->children[i + 1];
+      right->children[right->count] = nullptr;
+    }
+    right->count--;
+  }
+
+  // fusionar children[idx + 1] dentro de children[idx] con el par idx del padre
+  void merge(node_type* parent, int idx) {
+    node_type* left = parent->children[idx];
+    node_type* right = parent->children[idx + 1];
+
+    // bajar el par del padre al hermano izquierdo
+    left->keys[left->count] = std::move(parent->keys[idx]);
+    left->values[left->count] = std::move(parent->values[idx]);
+    left->count++;
+    int base = left->count;
+    for (int i = 0; i < right->count; i++, left->count++) {
+      left->keys[left->count] = std::move(right->keys[i]);
+      left->values[left->count] = std::move(right->values[i]);
+    }
+    if (!left->leaf) {
+      for (int i = 0; i <= right->count; i++) {
+        left->children[base + i] = right->children[i];
+        right->children[i] = nullptr;
+      }
+    }
+
+    //eliminar el par del padre y ajustar children
+    for (int i = idx; i < parent->count - 1; i++) {
+      parent->keys[i] = std::move(parent->keys[i + 1]);
+      parent->values[i] = std::move(parent->values[i + 1]);
+    }
+    for (int i = idx + 1; i < parent->count; i++) parent->children[i] = parent->children[i + 1];
+    parent->children[parent->count] = nullptr;
+    parent->count--;
+    pool.destroy(right);
+  }
+
+  void destroy_subtree(node_type* x) {
+    if (!x->leaf) {
+      for (int i = 0; i <= x->count; ++i) destroy_subtree(x->children[i]);
+    }
+    pool.destroy(x);
+  }
+
+  template <typename F>
+  static void for_each_rec(node_type* x, F& f) {
+    for (int i = 0; i < x->count; ++i) {
+      if (!x->leaf) for_each_rec(x->children[i], f);
+      f(static_cast<const TK&>(x->keys[i]), static_cast<const TV&>(x->values[i]));
+    }
+    if (!x->leaf) for_each_rec(x->children[x->count], f);
+  }
+
+  static void range_search_rec(node_type* x, const TK& a, const TK& b, vector<pair<TK, TV>>& out) {
+    int i = node_lower_bound(x->keys, x->count, a);
+    if (x->leaf) {
+      for (; i < x->count && !(b < x->keys[i]); ++i) out.emplace_back(x->keys[i], x->values[i]);
+      return;
+    }
+    // saltar los hijos que quedan completamente a la izquierda de a
+    for (; i < x->count; ++i) {
+      range_search_rec(x->children[i], a, b, out);
+      if (b < x->keys[i]) return;
+      out.emplace_back(x->keys[i], x->values[i]);
+    }
+    range_search_rec(x->children[x->count], a, b, out);
+  }
+
+  bool check(node_type* x, bool is_root, int depth, int& leaf_level, bool& has_prev, TK& prev,
+             long long& total) const {
+    int min_keys = (M + 1) / 2 - 1;
+    if (x->count > M - 1 || (is_root ? x->count < 1 : x->count < min_keys)) return false;
+    total += x->count;
+
+    if (x->leaf) {
+      if (x->children != nullptr) return false;
+      if (leaf_level == -1)
+        leaf_level = depth;
+      else if (leaf_level != depth)
+        return false;
+      for (int i = 0; i < x->count; ++i) {
+        if (has_prev && !(prev < x->keys[i])) return false;
+        prev = x->keys[i];
+        has_prev = true;
+      }
+      return true;
+    }
+
+    for (int i = 0; i <= x->count; ++i) {
+      if (x->children[i] == nullptr) return false;
+      if (!check(x->children[i], false, depth + 1, leaf_level, has_prev, prev, total)) return false;
+      if (i < x->count) {
+        if (has_prev && !(prev < x->keys[i])) return false;
+        prev = x->keys[i];
+        has_prev = true;
+      }
+    }
+    return true;
+  }
+};
+
+#endif
@@ -0,0 +1,168 @@
+#ifndef BUFFER_POOL_H
+#define BUFFER_POOL_H
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+#include <unistd.h>
+using namespace std;
+
+// Cache de paginas de tamaño fijo de un archivo, con reemplazo CLOCK.
+// pin() deja la pagina en memoria hasta el unpin correspondiente; las
+// paginas modificadas se escriben al ser desalojadas o en flush_all(). El
+// archivo lo abre y cierra quien usa el pool. No es thread-safe.
+class BufferPool {
+ public:
+  using page_id = uint64_t;
+
+  struct Stats {
+    size_t hits = 0;         // pin de una pagina que ya estaba en memoria
+    size_t misses = 0;       // pin que tuvo que leer o crear la pagina
+    size_t page_reads = 0;   // lecturas del archivo
+    size_t page_writes = 0;  // escrituras al archivo (desalojos y flush)
+    size_t evictions = 0;
+  };
+
+ private:
+  struct Frame {
+    page_id id;
+    int pins;
+    bool dirty;
+    bool referenced;  // bit de CLOCK: usada desde la ultima pasada
+    bool used;
+  };
+
+  int fd;
+  size_t page_size;
+  char* memory;  // frames.size() paginas contiguas, alineadas a page_size
+  vector<Frame> frames;
+  unordered_map<page_id, size_t> table;  // pagina -> frame
+  size_t hand;  // aguja de CLOCK
+  Stats stats;
+
+ public:
+  BufferPool(int _fd, size_t _page_size, size_t frame_count)
+      : fd(_fd), page_size(_page_size), memory(nullptr), frames(frame_count), hand(0) {
+    if (frame_count == 0) throw std::invalid_argument("El buffer pool necesita al menos un marco");
+    memory = static_cast<char*>(std::aligned_alloc(page_size, page_size * frame_count));
+    if (!memory) throw std::bad_alloc();
+    for (Frame& f : frames) f = {0, 0, false, false, false};
+    table.reserve(frame_count * 2);
+  }
+
+  BufferPool(const BufferPool&) = delete;
+  BufferPool& operator=(const BufferPool&) = delete;
+
+  // sin flush: quien usa el pool decide cuando escribir
+  ~BufferPool() { std::free(memory); }
+
+  // fija la pagina id (leyendola del archivo si hace falta)
+  char* pin(page_id id) { return pin_frame(id, true); }
+
+  // fija una pagina recien asignada: no se lee, se entrega en cero y sucia
+  char* pin_new(page_id id) {
+    char* data = pin_frame(id, false);
+    memset(data, 0, page_size);
+    frames[table[id]].dirty = true;
+    return data;
+  }
+
+  void unpin(page_id id, bool dirty) {
+    Frame& f = frames[table.at(id)];
+    if (f.pins <= 0) throw std::logic_error("unpin de una pagina no fijada");
+    f.pins--;
+    f.dirty = f.dirty || dirty;
+  }
+
+  // escribe todas las paginas sucias
+  void flush_all() {
+    for (size_t i = 0; i < frames.size(); ++i) {
+      if (frames[i].used && frames[i].dirty) write_frame(i);
+    }
+  }
+
+  const Stats& statistics() const { return stats; }
+  void reset_statistics() { stats = Stats(); }
+  size_t frame_count() const { return frames.size(); }
+  size_t pinned_pages() const {
+    size_t c = 0;
+    for (const Frame& f : frames) c += f.used && f.pins > 0;
+    return c;
+  }
+
+ private:
+  char* frame_data(size_t i) const { return memory + i * page_size; }
+
+  char* pin_frame(page_id id, bool read) {
+    auto it = table.find(id);
+    if (it != table.end()) {
+      stats.hits++;
+      Frame& f = frames[it->second];
+      f.pins++;
+      f.referenced = true;
+      return frame_data(it->second);
+    }
+    stats.misses++;
+    size_t i = victim();
+    if (read) {
+      read_page(id, frame_data(i));
+      stats.page_reads++;
+    }
+    frames[i] = {id, 1, false, true, true};
+    table[id] = i;
+    return frame_data(i);
+  }
+
+  // CLOCK: la aguja avanza limpiando bits de referencia hasta encontrar un
+  // marco libre o no fijado sin referencia; se desaloja (escribiendolo si
+  // esta sucio)
+  size_t victim() {
+    for (size_t steps = 0; steps < 2 * frames.size() + 1; ++steps) {
+      size_t i = hand;
+      hand = (hand + 1) % frames.size();
+      Frame& f = frames[i];
+      if (!f.used) return i;
+      if (f.pins > 0) continue;
+      if (f.referenced) {
+        f.referenced = false;
+        continue;
+      }
+      if (f.dirty) write_frame(i);
+      table.erase(f.id);
+      f.used = false;
+      stats.evictions++;
+      return i;
+    }
+    throw runtime_error("Buffer pool sin marcos libres: todas las paginas estan fijadas");
+  }
+
+  void write_frame(size_t i) {
+    const char* data = frame_data(i);
+    off_t offset = static_cast<off_t>(frames[i].id * page_size);
+    for (size_t done = 0; done < page_size;) {
+      ssize_t w = pwrite(fd, data + done, page_size - done, offset + static_cast<off_t>(done));
+      if (w < 0) throw runtime_error("Error escribiendo una pagina");
+      done += static_cast<size_t>(w);
+    }
+    frames[i].dirty = false;
+    stats.page_writes++;
+  }
+
+  void read_page(page_id id, char* data) {
+    off_t offset = static_cast<off_t>(id * page_size);
+    size_t done = 0;
+    while (done < page_size) {
+      ssize_t r = pread(fd, data + done, page_size - done, offset + static_cast<off_t>(done));
+      if (r < 0) throw runtime_error("Error leyendo una pagina");
+      if (r == 0) break;
+      done += static_cast<size_t>(r);
+    }
+    // pagina mas alla del final del archivo: en cero
+    if (done < page_size) memset(data + done, 0, page_size - done);
+  }
+};
+
+#endif
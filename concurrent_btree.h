@@ -0,0 +1,550 @@
+#ifndef CONCURRENT_BTREE_H
+#define CONCURRENT_BTREE_H
+#include <atomic>
+#include <cstdint>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+#include "epoch.h"
+#include "node_search.h"
+using namespace std;
+
+// Nodo con latch de version para lock coupling optimista.
+// version: bit 0 = obsoleto (desenganchado del arbol), bit 1 = bloqueado,
+// el resto es un contador que avanza con cada escritura. Un lector copia la
+// version, lee el nodo sin bloquear y valida que la version no cambio.
+template <typename TK>
+struct OLCNode {
+  atomic<uint64_t> version;
+  // cantidad de keys
+  int count;
+  // indicador de nodo hoja
+  bool leaf;
+  // hoja siguiente (solo en hojas), para rangeSearch
+  OLCNode* next;
+  // keys e hijos viven en el mismo bloque que el nodo
+  TK* keys;
+  OLCNode** children;
+
+  OLCNode() : version(0), count(0), leaf(true), next(nullptr), keys(nullptr), children(nullptr) {}
+};
+
+// Arbol B thread-safe con optimistic lock coupling.
+// - search/rangeSearch no bloquean: bajan validando versiones y reinician si
+//   un escritor cambio algun nodo del camino.
+// - insert/remove bajan igual de forma optimista y bloquean solo los nodos
+//   que modifican: la hoja, o padre + hijo (+ hermano) cuando hay que partir
+//   o fusionar. Los nodos llenos se parten y los que estan en el minimo se
+//   rebalancean antes de bajar por ellos, asi un cambio nunca sube por el
+//   arbol.
+// - los nodos que quedan fuera del arbol en una fusion se liberan por epocas.
+//
+// Usa el esquema B+ (todas las keys en hojas enlazadas, separadores copiados
+// en los nodos internos) porque asi un borrado solo toca hojas. TK debe ser
+// trivialmente copiable: los lectores pueden ver keys a medio escribir antes
+// de descartar la lectura al validar.
+template <typename TK>
+class ConcurrentBTree {
+  //La implementación de este BTree no soporta valores repetidos
+  static_assert(is_trivially_copyable<TK>::value, "ConcurrentBTree requiere keys trivialmente copiables");
+
+ public:
+  using node_type = OLCNode<TK>;
+
+ private:
+  static constexpr size_t kAlign = 64;
+
+  atomic<node_type*> root;
+  int M;  // grado u orden del arbol
+  int min_keys;  // minimo de keys de un nodo no raiz
+  atomic<long long> n;  // total de elementos en el arbol
+  size_t keys_offset;
+  size_t children_offset;
+  size_t leaf_bytes;
+  size_t internal_bytes;
+  EpochManager epochs;
+
+ public:
+  // M >= 4: los nodos se parten al llenarse (M - 1 keys), antes de insertar,
+  // y ambas mitades deben quedar con al menos min_keys = (M - 2) / 2
+  ConcurrentBTree(int _M)
+      : root(nullptr),
+        M(_M),
+        min_keys((_M - 2) / 2),
+        n(0),
+        keys_offset(round_up(sizeof(node_type), alignof(TK))),
+        children_offset(round_up(keys_offset + sizeof(TK) * _M, alignof(node_type*))),
+        leaf_bytes(round_up(keys_offset + sizeof(TK) * _M, kAlign)),
+        internal_bytes(round_up(children_offset + sizeof(node_type*) * (_M + 1), kAlign)),
+        epochs([](void* p) { free_node(p); }) {
+    if (M < 4) throw std::invalid_argument("M debe ser al menos 4");
+    root.store(create(true));
+  }
+
+  ConcurrentBTree(const ConcurrentBTree&) = delete;
+  ConcurrentBTree& operator=(const ConcurrentBTree&) = delete;
+
+  ~ConcurrentBTree() {
+    destroy_subtree(root.load());
+  }
+
+  //indica si se encuentra o no un elemento
+  bool search(TK key) {
+    EpochGuard guard(epochs);
+    while (true) {
+      node_type* leaf;
+      uint64_t v;
+      if (!find_leaf(key, leaf, v)) continue;
+      int pos = node_lower_bound(leaf->keys, leaf->count, key);
+      bool found = pos < leaf->count && leaf->keys[pos] == key;
+      if (validate(leaf, v)) return found;
+    }
+  }
+
+  // true si la key no estaba
+  bool insert(TK key) {
+    EpochGuard guard(epochs);
+    while (true) {
+      int r = try_insert(key);
+      if (r != kRestart) return r == kDone;
+    }
+  }
+
+  // true si la key estaba
+  bool remove(TK key) {
+    EpochGuard guard(epochs);
+    while (true) {
+      int r = try_remove(key);
+      if (r != kRestart) return r == kDone;
+    }
+  }
+
+  // recorrido de hojas validado hoja por hoja; si una hoja cambia se vuelve
+  // a bajar desde la ultima key entregada
+  vector<TK> rangeSearch(TK begin, TK end) {
+    if (end < begin) std::swap(begin, end);
+    EpochGuard guard(epochs);
+    vector<TK> out;
+    vector<TK> buf(M);
+    while (!try_range(begin, end, out, buf)) {
+    }
+    return out;
+  }
+
+  int size() const { return static_cast<int>(n.load()); }
+
+  // operaciones de consulta sin concurrencia (el arbol debe estar quieto)
+  //altura del arbol. Considerar altura 0 para arbol vacio
+  int height() {
+    node_type* x = root.load();
+    if (x->leaf && x->count == 0) return 0;
+    int cont = 0;
+    for (; !x->leaf; x = x->children[0]) cont++;
+    return cont;
+  }
+
+  // Verifique las propiedades del arbol y de la lista de hojas
+  bool check_properties() {
+    int leaf_level = -1;
+    node_type* prev_leaf = nullptr;
+    long long total = 0;
+    if (!check(root.load(), true, 1, nullptr, nullptr, leaf_level, prev_leaf, total)) return false;
+    return prev_leaf->next == nullptr && total == n.load();
+  }
+
+  // nodos retirados que aun esperan a que los lectores salgan de su epoca
+  size_t pending_reclaim() { return epochs.pending(); }
+
+ private:
+  enum { kRestart, kDone, kNoop };
+
+  static constexpr size_t round_up(size_t x, size_t a) { return (x + a - 1) / a * a; }
+
+  node_type* create(bool leaf) {
+    char* mem = static_cast<char*>(::operator new(leaf ? leaf_bytes : internal_bytes, align_val_t(kAlign)));
+    node_type* x = new (mem) node_type();
+    x->leaf = leaf;
+    x->keys = reinterpret_cast<TK*>(mem + keys_offset);
+    if (!leaf) {
+      x->children = reinterpret_cast<node_type**>(mem + children_offset);
+      for (int i = 0; i <= M; ++i) x->children[i] = nullptr;
+    }
+    return x;
+  }
+
+  static void free_node(void* p) { ::operator delete(p, align_val_t(kAlign)); }
+
+  void destroy_subtree(node_type* x) {
+    if (!x->leaf) {
+      for (int i = 0; i <= x->count; ++i) destroy_subtree(x->children[i]);
+    }
+    free_node(x);
+  }
+
+  // latches de version
+  // lectura optimista: false si el nodo esta bloqueado u obsoleto
+  static bool read_lock(node_type* x, uint64_t& v) {
+    v = x->version.load(memory_order_acquire);
+    if (v & 3) {
+      this_thread::yield();
+      return false;
+    }
+    return true;
+  }
+
+  // la lectura hecha desde read_lock sigue siendo valida
+  static bool validate(node_type* x, uint64_t v) {
+    atomic_thread_fence(memory_order_acquire);
+    return x->version.load(memory_order_relaxed) == v;
+  }
+
+  // pasa de lectura a escritura si nadie escribio desde v
+  static bool upgrade(node_type* x, uint64_t v) { return x->version.compare_exchange_strong(v, v + 2); }
+
+  // bloqueo con espera; solo para nodos alcanzables desde un padre bloqueado
+  static void write_lock(node_type* x) {
+    while (true) {
+      uint64_t v = x->version.load();
+      if (!(v & 2) && x->version.compare_exchange_weak(v, v + 2)) return;
+      this_thread::yield();
+    }
+  }
+
+  static void write_unlock(node_type* x) { x->version.fetch_add(2, memory_order_release); }
+  static void write_unlock_obsolete(node_type* x) { x->version.fetch_add(3, memory_order_release); }
+
+  // indice del hijo por el que descender: cantidad de separadores <= key
+  static int child_index(node_type* node, const TK& key) {
+    int idx = node_lower_bound(node->keys, node->count, key);
+    if (idx < node->count && !(key < node->keys[idx])) idx++;
+    return idx;
+  }
+
+  // baja a un hijo: lee el puntero, toma la version del hijo y valida el padre
+  static bool descend(node_type* node, uint64_t v, const TK& key, node_type*& child, uint64_t& cv) {
+    child = node->children[child_index(node, key)];
+    if (!validate(node, v) || child == nullptr) return false;
+    return read_lock(child, cv) && validate(node, v);
+  }
+
+  // la raiz leida y su version; false si cambio mientras tanto
+  bool read_root(node_type*& node, uint64_t& v) {
+    node = root.load();
+    return read_lock(node, v) && node == root.load();
+  }
+
+  bool find_leaf(const TK& key, node_type*& node, uint64_t& v) {
+    if (!read_root(node, v)) return false;
+    while (!node->leaf) {
+      node_type* child;
+      uint64_t cv;
+      if (!descend(node, v, key, child, cv)) return false;
+      node = child;
+      v = cv;
+    }
+    return true;
+  }
+
+  // metodos para la insercion
+  int try_insert(const TK& key) {
+    node_type* node;
+    uint64_t v;
+    if (!read_root(node, v)) return kRestart;
+    node_type* parent = nullptr;
+    uint64_t pv = 0;
+
+    while (true) {
+      if (node->count == M - 1) {
+        // nodo lleno: partirlo antes de seguir (el padre ya tiene lugar)
+        if (parent && !upgrade(parent, pv)) return kRestart;
+        if (!upgrade(node, v)) {
+          if (parent) write_unlock(parent);
+          return kRestart;
+        }
+        if (!parent && node != root.load()) {
+          write_unlock(node);
+          return kRestart;
+        }
+        TK sep;
+        node_type* right = node->leaf ? split_leaf(node, sep) : split_internal(node, sep);
+        if (parent) {
+          insert_child(parent, sep, right);
+        } else {
+          node_type* new_root = create(false);
+          new_root->keys[0] = sep;
+          new_root->children[0] = node;
+          new_root->children[1] = right;
+          new_root->count = 1;
+          root.store(new_root);
+        }
+        write_unlock(node);
+        if (parent) write_unlock(parent);
+        return kRestart;
+      }
+      if (node->leaf) break;
+
+      node_type* child;
+      uint64_t cv;
+      if (!descend(node, v, key, child, cv)) return kRestart;
+      parent = node;
+      pv = v;
+      node = child;
+      v = cv;
+    }
+
+    if (!upgrade(node, v)) return kRestart;
+    int pos = node_lower_bound(node->keys, node->count, key);
+    if (pos < node->count && node->keys[pos] == key) {
+      write_unlock(node);
+      return kNoop;  // llave duplicada
+    }
+    for (int i = node->count; i > pos; i--) node->keys[i] = node->keys[i - 1];
+    node->keys[pos] = key;
+    node->count++;
+    write_unlock(node);
+    n.fetch_add(1, memory_order_relaxed);
+    return kDone;
+  }
+
+  // hoja: la mitad derecha pasa a un nodo nuevo y su primera key sube copiada
+  node_type* split_leaf(node_type* node, TK& sep) {
+    int mid_idx = node->count / 2;
+    node_type* right = create(true);
+    int j = 0;
+    for (int i = mid_idx; i < node->count; i++) right->keys[j++] = node->keys[i];
+    right->count = j;
+    right->next = node->next;
+    sep = right->keys[0];
+    node->next = right;
+    node->count = mid_idx;
+    return right;
+  }
+
+  // interno: la key del medio sube
+  node_type* split_internal(node_type* node, TK& sep) {
+    int mid_idx = node->count / 2;
+    sep = node->keys[mid_idx];
+    node_type* right = create(false);
+    int j = 0;
+    for (int i = mid_idx + 1; i < node->count; i++) right->keys[j++] = node->keys[i];
+    for (int i = mid_idx + 1, k = 0; i <= node->count; i++, k++) right->children[k] = node->children[i];
+    right->count = j;
+    node->count = mid_idx;
+    return right;
+  }
+
+  static void insert_child(node_type* parent, const TK& sep, node_type* right) {
+    int pos = node_lower_bound(parent->keys, parent->count, sep);
+    for (int i = parent->count; i > pos; i--) {
+      parent->keys[i] = parent->keys[i - 1];
+      parent->children[i + 1] = parent->children[i];
+    }
+    parent->keys[pos] = sep;
+    parent->children[pos + 1] = right;
+    parent->count++;
+  }
+
+  // metodos para la eliminacion
+  int try_remove(const TK& key) {
+    node_type* node;
+    uint64_t v;
+    if (!read_root(node, v)) return kRestart;
+
+    while (!node->leaf) {
+      int idx = child_index(node, key);
+      node_type* child;
+      uint64_t cv;
+      if (!descend(node, v, key, child, cv)) return kRestart;
+      if (child->count <= min_keys) {
+        // hijo en el minimo: rebalancearlo antes de bajar por el
+        if (!upgrade(node, v)) return kRestart;
+        if (!upgrade(child, cv)) {
+          write_unlock(node);
+          return kRestart;
+        }
+        rebalance(node, idx);
+        return kRestart;
+      }
+      node = child;
+      v = cv;
+    }
+
+    if (!upgrade(node, v)) return kRestart;
+    int pos = node_lower_bound(node->keys, node->count, key);
+    if (pos == node->count || !(node->keys[pos] == key)) {
+      write_unlock(node);
+      return kNoop;
+    }
+    for (int i = pos; i < node->count - 1; i++) node->keys[i] = node->keys[i + 1];
+    node->count--;
+    write_unlock(node);
+    n.fetch_sub(1, memory_order_relaxed);
+    return kDone;
+  }
+
+  // parent y children[idx] bloqueados: tomar una key de un hermano o fusionarse
+  // con el. Libera todos los bloqueos
+  void rebalance(node_type* parent, int idx) {
+    int sib_idx = idx < parent->count ? idx + 1 : idx - 1;
+    node_type* child = parent->children[idx];
+    node_type* sibling = parent->children[sib_idx];
+    write_lock(sibling);
+
+    if (sibling->count > min_keys) {
+      if (sib_idx > idx)
+        borrow_from_right(parent, idx);
+      else
+        borrow_from_left(parent, idx);
+      write_unlock(sibling);
+      write_unlock(child);
+      write_unlock(parent);
+      return;
+    }
+
+    int left_idx = idx < sib_idx ? idx : sib_idx;
+    node_type* left = parent->children[left_idx];
+    node_type* right = parent->children[left_idx + 1];
+    merge(parent, left_idx);
+    write_unlock(left);
+    write_unlock_obsolete(right);
+    epochs.retire(right);
+
+    // la raiz interna quedo con un solo hijo: el hijo pasa a ser la raiz
+    if (parent->count == 0 && parent == root.load()) {
+      root.store(left);
+      write_unlock_obsolete(parent);
+      epochs.retire(parent);
+    } else {
+      write_unlock(parent);
+    }
+  }
+
+  void borrow_from_left(node_type* parent, int idx) {
+    node_type* child = parent->children[idx];
+    node_type* left = parent->children[idx - 1];
+    for (int i = child->count; i > 0; i--) child->keys[i] = child->keys[i - 1];
+    if (child->leaf) {
+      child->keys[0] = left->keys[left->count - 1];
+      parent->keys[idx - 1] = child->keys[0];
+    } else {
+      for (int i = child->count + 1; i > 0; i--) child->children[i] = child->children[i - 1];
+      child->keys[0] = parent->keys[idx - 1];
+      child->children[0] = left->children[left->count];
+      parent->keys[idx - 1] = left->keys[left->count - 1];
+    }
+    child->count++;
+    left->count--;
+  }
+
+  void borrow_from_right(node_type* parent, int idx) {
+    node_type* child = parent->children[idx];
+    node_type* right = parent->children[idx + 1];
+    if (child->leaf) {
+      child->keys[child->count] = right->keys[0];
+    } else {
+      child->keys[child->count] = parent->keys[idx];
+      child->children[child->count + 1] = right->children[0];
+      parent->keys[idx] = right->keys[0];
+    }
+    child->count++;
+    for (int i = 0; i < right->count - 1; i++) right->keys[i] = right->keys[i + 1];
+    if (!right->leaf) {
+      for (int i = 0; i < right->count; i++) right->children[i] = right->children[i + 1];
+    }
+    right->count--;
+    if (child->leaf) parent->keys[idx] = right->keys[0];
+  }
+
+  // fusionar children[idx + 1] dentro de children[idx]
+  void merge(node_type* parent, int idx) {
+    node_type* left = parent->children[idx];
+    node_type* right = parent->children[idx + 1];
+    if (left->leaf) {
+      for (int i = 0; i < right->count; i++) left->keys[left->count++] = right->keys[i];
+      left->next = right->next;
+    } else {
+      left->keys[left->count++] = parent->keys[idx];
+      int base = left->count;
+      for (int i = 0; i < right->count; i++) left->keys[left->count++] = right->keys[i];
+      for (int i = 0; i <= right->count; i++) left->children[base + i] = right->children[i];
+    }
+    // los lectores pueden seguir viendo el puntero viejo en children[count]:
+    // no se pone en nullptr, el nodo retirado sigue vivo hasta su epoca
+    for (int i = idx; i < parent->count - 1; i++) parent->keys[i] = parent->keys[i + 1];
+    for (int i = idx + 1; i < parent->count; i++) parent->children[i] = parent->children[i + 1];
+    parent->count--;
+  }
+
+  // helpers
+  bool try_range(const TK& a, const TK& b, vector<TK>& out, vector<TK>& buf) {
+    bool resumed = !out.empty();
+    const TK from = resumed ? out.back() : a;
+    node_type* node;
+    uint64_t v;
+    if (!find_leaf(from, node, v)) return false;
+
+    while (true) {
+      int cnt = 0;
+      bool past_end = false;
+      int count = node->count;
+      for (int i = node_lower_bound(node->keys, count, from); i < count; ++i) {
+        TK key = node->keys[i];
+        if (b < key) {
+          past_end = true;
+          break;
+        }
+        if (!resumed || out.back() < key) buf[cnt++] = key;
+      }
+      node_type* next = node->next;
+      if (!validate(node, v)) return false;
+      out.insert(out.end(), buf.begin(), buf.begin() + cnt);
+      resumed = !out.empty();
+      if (past_end || next == nullptr) return true;
+
+      uint64_t nv;
+      if (!read_lock(next, nv) || !validate(node, v)) return false;
+      node = next;
+      v = nv;
+    }
+  }
+
+  // lo / hi: cotas de las keys del subarbol (lo <= key < hi), nullptr si no hay
+  bool check(node_type* x, bool is_root, int depth, const TK* lo, const TK* hi, int& leaf_level,
+             node_type*& prev_leaf, long long& total) {
+    if (x->version.load() & 3) return false;
+    if (x->count > M - 1) return false;
+    if (is_root) {
+      if (!x->leaf && x->count < 1) return false;
+    } else if (x->count < min_keys) {
+      return false;
+    }
+    for (int i = 0; i < x->count; ++i) {
+      if (i > 0 && !(x->keys[i - 1] < x->keys[i])) return false;
+      if (lo && x->keys[i] < *lo) return false;
+      if (hi && !(x->keys[i] < *hi)) return false;
+    }
+
+    if (x->leaf) {
+      if (leaf_level == -1)
+        leaf_level = depth;
+      else if (leaf_level != depth)
+        return false;
+      if (prev_leaf && prev_leaf->next != x) return false;
+      prev_leaf = x;
+      total += x->count;
+      return true;
+    }
+
+    for (int i = 0; i <= x->count; ++i) {
+      const TK* child_lo = i == 0 ? lo : &x->keys[i - 1];
+      const TK* child_hi = i == x->count ? hi : &x->keys[i];
+      if (!check(x->children[i], false, depth + 1, child_lo, child_hi, leaf_level, prev_leaf, total)) return false;
+    }
+    return true;
+  }
+};
+
+#endif
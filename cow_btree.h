@@ -0,0 +1,484 @@
+#ifndef COW_BTREE_H
+#define COW_BTREE_H
+#include <atomic>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+#include "node_search.h"
+using namespace std;
+
+// Nodo compartido entre versiones del arbol. refs cuenta los padres (y
+// snapshots, en el caso de una raiz) que lo apuntan: un nodo con refs == 1
+// alcanzado desde un nodo exclusivo es exclusivo y se puede modificar en el
+// lugar; si no, se copia.
+template <typename TK>
+struct CowNode {
+  atomic<int> refs;
+  // cantidad de keys
+  int count;
+  // keys reservadas (M), para poder liberar el nodo sin el arbol
+  int capacity;
+  // indicador de nodo hoja
+  bool leaf;
+  // keys e hijos viven en el mismo bloque que el nodo
+  TK* keys;
+  CowNode** children;
+
+  CowNode() : refs(1), count(0), capacity(0), leaf(true), keys(nullptr), children(nullptr) {}
+};
+
+// Arbol B con snapshots inmutables por copia de camino (copy-on-write).
+// snapshot() es O(1): comparte la raiz actual. Mientras exista un snapshot,
+// insert/remove copian solo los nodos que modifican (el camino raiz-hoja y
+// los hermanos de un rebalanceo); el resto se comparte entre versiones.
+// Cada version se libera cuando se suelta su ultima referencia.
+//
+// El arbol vivo admite un solo escritor (insert/remove/snapshot deben estar
+// sincronizados entre si). Los Snapshot son de solo lectura y se pueden leer,
+// copiar y destruir desde cualquier hilo sin bloquear al escritor. Los nodos
+// usan el reservador global porque los libera quien suelte la ultima
+// referencia, que puede ser cualquier hilo.
+template <typename TK>
+class CowBTree {
+  //La implementación de este BTree no soporta valores repetidos
+ public:
+  using node_type = CowNode<TK>;
+  class Snapshot;
+
+ private:
+  node_type* root;
+  int M;  // grado u orden del arbol
+  int n;  // total de elementos en el arbol
+  size_t copies;  // nodos copiados por estar compartidos
+
+ public:
+  CowBTree(int _M) : root(nullptr), M(_M), n(0), copies(0) {
+    if (M < 3) throw std::invalid_argument("M debe ser al menos 3");
+  }
+
+  CowBTree(const CowBTree&) = delete;
+  CowBTree& operator=(const CowBTree&) = delete;
+
+  ~CowBTree() { release(root); }
+
+  // version inmutable del arbol actual, O(1)
+  Snapshot snapshot() const { return Snapshot(root, n); }
+
+  //indica si se encuentra o no un elemento
+  bool search(TK key) const { return search_in(root, key); }
+
+  // true si la key no estaba
+  bool insert(TK key) {
+    if (search_in(root, key)) return false;  // sin copias para duplicados
+    n++;
+
+    //caso1: arbol sin raiz
+    if (!root) {
+      root = create(true, M);
+      root->keys[0] = key;
+      root->count = 1;
+      return true;
+    }
+
+    //caso2: insertar normalmente
+    node_type* node = own(root);
+    TK promoted_key;
+    node_type* new_child = insert_rec(node, key, promoted_key);
+    if (!new_child) return true;
+
+    //caso3: split en la raiz
+    node_type* new_root = create(false, M);
+    new_root->keys[0] = promoted_key;
+    new_root->count = 1;
+    new_root->children[0] = root;
+    new_root->children[1] = new_child;
+    root = new_root;
+    return true;
+  }
+
+  // true si la key estaba
+  bool remove(TK key) {
+    if (!search_in(root, key)) return false;
+    n--;
+    remove_rec(own(root), key);
+
+    // Si la raíz quedó vacía pero tiene un hijo, promoverlo
+    if (root->count == 0 && !root->leaf) {
+      node_type* old_root = root;
+      root = root->children[0];
+      free_node(old_root);
+    }
+    // Si el árbol quedó completamente vacío
+    if (root->count == 0 && root->leaf) {
+      free_node(root);
+      root = nullptr;
+    }
+    return true;
+  }
+
+  vector<TK> rangeSearch(TK begin, TK end) const { return range_in(root, begin, end); }
+
+  TK minKey() const { return min_in(root); }
+  TK maxKey() const { return max_in(root); }
+
+  //altura del arbol. Considerar altura 0 para arbol vacio
+  int height() const { return height_in(root); }
+
+  int size() const { return n; }
+
+  // nodos copiados hasta ahora porque estaban compartidos con un snapshot
+  size_t copied_nodes() const { return copies; }
+
+  // Verifique las propiedades de un árbol B
+  bool check_properties() const {
+    if (!root) return true;
+    int leaf_level = -1;
+    bool has_prev = false;
+    TK prev{};
+    return check(root, true, 1, leaf_level, has_prev, prev);
+  }
+
+  // version inmutable: las mismas consultas que el arbol, sin modificaciones
+  class Snapshot {
+    node_type* root;
+    int n;
+
+    friend class CowBTree;
+    Snapshot(node_type* _root, int _n) : root(_root), n(_n) { retain(root); }
+
+   public:
+    Snapshot() : root(nullptr), n(0) {}
+    Snapshot(const Snapshot& other) : root(other.root), n(other.n) { retain(root); }
+    Snapshot(Snapshot&& other) noexcept : root(other.root), n(other.n) {
+      other.root = nullptr;
+      other.n = 0;
+    }
+    Snapshot& operator=(Snapshot other) noexcept {
+      std::swap(root, other.root);
+      std::swap(n, other.n);
+      return *this;
+    }
+    ~Snapshot() { release(root); }
+
+    bool search(TK key) const { return search_in(root, key); }
+    vector<TK> rangeSearch(TK begin, TK end) const { return range_in(root, begin, end); }
+    TK minKey() const { return min_in(root); }
+    TK maxKey() const { return max_in(root); }
+    int height() const { return height_in(root); }
+    int size() const { return n; }
+  };
+
+ private:
+  // nodos
+  static node_type* create(bool leaf, int M) {
+    size_t keys_offset = round_up(sizeof(node_type), alignof(TK));
+    size_t children_offset = round_up(keys_offset + sizeof(TK) * M, alignof(node_type*));
+    size_t bytes = leaf ? keys_offset + sizeof(TK) * M : children_offset + sizeof(node_type*) * (M + 1);
+    char* mem = static_cast<char*>(::operator new(bytes));
+    node_type* x = new (mem) node_type();
+    x->capacity = M;
+    x->leaf = leaf;
+    x->keys = reinterpret_cast<TK*>(mem + keys_offset);
+    for (int i = 0; i < M; ++i) new (&x->keys[i]) TK();
+    if (!leaf) {
+      x->children = reinterpret_cast<node_type**>(mem + children_offset);
+      for (int i = 0; i <= M; ++i) x->children[i] = nullptr;
+    }
+    return x;
+  }
+
+  static constexpr size_t round_up(size_t x, size_t a) { return (x + a - 1) / a * a; }
+
+  // libera solo el bloque del nodo; los hijos los maneja quien llama
+  static void free_node(node_type* x) {
+    for (int i = 0; i < x->capacity; ++i) x->keys[i].~TK();
+    x->~node_type();
+    ::operator delete(x);
+  }
+
+  static void retain(node_type* x) {
+    if (x) x->refs.fetch_add(1, memory_order_relaxed);
+  }
+
+  // soltar una referencia; el ultimo en soltarla libera el subarbol
+  static void release(node_type* x) {
+    if (!x || x->refs.fetch_sub(1, memory_order_acq_rel) != 1) return;
+    if (!x->leaf) {
+      for (int i = 0; i <= x->count; ++i) release(x->children[i]);
+    }
+    free_node(x);
+  }
+
+  // copia de camino: devuelve una version exclusiva del nodo en slot
+  node_type* own(node_type*& slot) {
+    node_type* x = slot;
+    if (x->refs.load(memory_order_acquire) == 1) return x;
+    node_type* copy = create(x->leaf, M);
+    copy->count = x->count;
+    for (int i = 0; i < x->count; ++i) copy->keys[i] = x->keys[i];
+    if (!x->leaf) {
+      for (int i = 0; i <= x->count; ++i) {
+        copy->children[i] = x->children[i];
+        retain(copy->children[i]);
+      }
+    }
+    copies++;
+    release(x);
+    slot = copy;
+    return copy;
+  }
+
+  // metodos para la insercion (node es exclusivo)
+  node_type* split(node_type* node, TK& promoted_key, bool is_leaf) {
+    int mid_idx = M / 2;
+    promoted_key = node->keys[mid_idx];
+
+    // partir a la mitad el nodo actual
+    node_type* right = create(is_leaf, M);
+    int j = 0;
+    for (int i = mid_idx + 1; i < node->count; i++) {
+      right->keys[j++] = node->keys[i];
+    }
+    right->count = j;
+
+    // organizar los hijos si no es hoja
+    if (!is_leaf) {
+      for (int i = mid_idx + 1, k = 0; i <= node->count; i++, k++) {
+        right->children[k] = node->children[i];
+        node->children[i] = nullptr;
+      }
+    }
+    node->count = mid_idx;
+    return right;  // se retorna la key que sube y el nodo partido
+  }
+
+  node_type* insert_rec(node_type* node, const TK& key, TK& promoted_key) {
+    //indice del primer key > key (la key no esta en el arbol)
+    int child_idx = node_lower_bound(node->keys, node->count, key);
+
+    if (node->leaf) {
+      // insertar en hoja desplazando las keys
+      for (int i = node->count; i > child_idx; i--) node->keys[i] = node->keys[i - 1];
+      node->keys[child_idx] = key;
+      node->count++;
+
+      //split en hoja
+      if (node->count == M) return split(node, promoted_key, true);
+      return nullptr;
+    }
+
+    // nodo interno = copiar el hijo si esta compartido y descender
+    TK child_promoted_key;
+    node_type* new_child = insert_rec(own(node->children[child_idx]), key, child_promoted_key);
+    if (!new_child) return nullptr;  // sin split
+
+    // hubo split, insertar la clave promovida en padre
+    for (int i = node->count; i > child_idx; i--) {
+      node->keys[i] = node->keys[i - 1];
+      node->children[i + 1] = node->children[i];
+    }
+    node->keys[child_idx] = child_promoted_key;
+    node->children[child_idx + 1] = new_child;
+    node->count++;
+
+    // split en padre
+    if (node->count == M) return split(node, promoted_key, false);
+    return nullptr;
+  }
+
+  // metodos para la eliminacion (node es exclusivo y la key esta en su subarbol)
+  void remove_rec(node_type* node, TK key) {
+    int min_keys = (M + 1) / 2 - 1;
+
+    int child_idx = node_lower_bound(node->keys, node->count, key);
+    bool here = child_idx < node->count && node->keys[child_idx] == key;
+
+    if (node->leaf) {
+      for (int i = child_idx; i < node->count - 1; i++) node->keys[i] = node->keys[i + 1];
+      node->count--;
+      return;
+    }
+
+    //caso3: key en nodo interno, reemplazar con sucesor
+    if (here) {
+      TK successor = min_in(node->children[child_idx + 1]);
+      node->keys[child_idx] = successor;
+      key = successor;  // eliminar sucesor del hijo derecho
+      child_idx++;
+    }
+
+    node_type* child = own(node->children[child_idx]);
+    remove_rec(child, key);
+
+    // si el hijo quedó con menos del mínimo
+    if (child->count < min_keys) fix_child(node, child_idx);
+  }
+
+  // arreglar un hijo que quedó con menos del mínimo; los hermanos que se
+  // modifican tambien se copian si estan compartidos
+  void fix_child(node_type* parent, int child_idx) {
+    int min_keys = (M + 1) / 2 - 1;
+
+    //caso1: intentar borrow de hermano izquierdo
+    if (child_idx > 0 && parent->children[child_idx - 1]->count > min_keys) {
+      borrow_from_left(parent, child_idx);
+      return;
+    }
+
+    //  caso2: intentar borrow de hermano derecho
+    if (child_idx < parent->count && parent->children[child_idx + 1]->count > min_keys) {
+      borrow_from_right(parent, child_idx);
+      return;
+    }
+
+    //caso3 : merge con hermano
+    merge(parent, child_idx > 0 ? child_idx - 1 : child_idx);
+  }
+
+  // Rotar: tomar una key del hermano izquierdo
+  void borrow_from_left(node_type* parent, int child_idx) {
+    node_type* child = parent->children[child_idx];
+    node_type* left = own(parent->children[child_idx - 1]);
+    for (int i = child->count; i > 0; i--) child->keys[i] = child->keys[i - 1];
+    if (!child->leaf) {
+      for (int i = child->count + 1; i > 0; i--) child->children[i] = child->children[i - 1];
+      child->children[0] = left->children[left->count];
+      left->children[left->count] = nullptr;
+    }
+    child->keys[0] = parent->keys[child_idx - 1];
+    child->count++;
+    parent->keys[child_idx - 1] = left->keys[left->count - 1];
+    left->count--;
+  }
+
+  void borrow_from_right(node_type* parent, int child_idx) {
+    node_type* child = parent->children[child_idx];
+    node_type* right = own(parent->children[child_idx + 1]);
+    child->keys[child->count] = parent->keys[child_idx];
+    child->count++;
+    parent->keys[child_idx] = right->keys[0];
+    if (!child->leaf) child->children[child->count] = right->children[0];
+    for (int i = 0; i < right->count - 1; i++) right->keys[i] = right->keys[i + 1];
+    if (!right->leaf) {
+      for (int i = 0; i < right->count; i++) right->children[i] = right->children[i + 1];
+      right->children[right->count] = nullptr;
+    }
+    right->count--;
+  }
+
+  // fusionar children[idx + 1] dentro de children[idx]. right solo se lee:
+  // si esta compartido no se copia, left toma una referencia a cada hijo y
+  // se suelta la de parent a right
+  void merge(node_type* parent, int idx) {
+    node_type* left = own(parent->children[idx]);
+    node_type* right = parent->children[idx + 1];
+
+    left->keys[left->count++] = parent->keys[idx];
+    int base = left->count;
+    for (int i = 0; i < right->count; i++) left->keys[left->count++] = right->keys[i];
+    if (!left->leaf) {
+      for (int i = 0; i <= right->count; i++) {
+        left->children[base + i] = right->children[i];
+        retain(right->children[i]);
+      }
+    }
+
+    for (int i = idx; i < parent->count - 1; i++) parent->keys[i] = parent->keys[i + 1];
+    for (int i = idx + 1; i < parent->count; i++) parent->children[i] = parent->children[i + 1];
+    parent->children[parent->count] = nullptr;
+    parent->count--;
+    release(right);
+  }
+
+  // consultas sobre una version (arbol vivo o snapshot)
+  static bool search_in(node_type* x, const TK& key) {
+    while (x) {
+      int pos = node_lower_bound(x->keys, x->count, key);
+      if (pos < x->count && x->keys[pos] == key) return true;
+      x = x->leaf ? nullptr : x->children[pos];
+    }
+    return false;
+  }
+
+  static vector<TK> range_in(node_type* x, TK begin, TK end) {
+    vector<TK> out;
+    if (end < begin) std::swap(begin, end);
+    range_search_rec(x, begin, end, out);
+    return out;
+  }
+
+  static void range_search_rec(node_type* x, const TK& a, const TK& b, vector<TK>& out) {
+    if (!x) return;
+
+    if (x->leaf) {
+      for (int i = node_lower_bound(x->keys, x->count, a); i < x->count; ++i) {
+        if (b < x->keys[i]) break;
+        out.push_back(x->keys[i]);
+      }
+      return;
+    }
+
+    // saltar los hijos que quedan completamente a la izquierda de a
+    for (int i = node_lower_bound(x->keys, x->count, a); i < x->count; ++i) {
+      range_search_rec(x->children[i], a, b, out);
+      if (b < x->keys[i]) return;
+      out.push_back(x->keys[i]);
+    }
+    range_search_rec(x->children[x->count], a, b, out);
+  }
+
+  // mínimo valor del árbol
+  static TK min_in(node_type* x) {
+    if (!x) throw runtime_error("El árbol está vacío");
+    while (!x->leaf) x = x->children[0];
+    return x->keys[0];
+  }
+
+  // máximo valor del árbol
+  static TK max_in(node_type* x) {
+    if (!x) throw runtime_error("El árbol está vacío");
+    while (!x->leaf) x = x->children[x->count];
+    return x->keys[x->count - 1];
+  }
+
+  static int height_in(node_type* x) {
+    if (!x) return 0;
+    int cont = 0;
+    for (; !x->leaf; x = x->children[0]) cont++;
+    return cont;
+  }
+
+  bool check(node_type* x, bool is_root, int depth, int& leaf_level, bool& has_prev, TK& prev) const {
+    int min_keys = (M + 1) / 2 - 1;
+    if (x->count > M - 1 || x->refs.load() < 1) return false;
+    if (!is_root && x->count < min_keys) return false;
+    if (is_root && x->count < 1) return false;
+
+    if (x->leaf) {
+      if (leaf_level == -1)
+        leaf_level = depth;
+      else if (leaf_level != depth)
+        return false;
+      for (int i = 0; i < x->count; ++i) {
+        if (has_prev && !(prev < x->keys[i])) return false;
+        prev = x->keys[i];
+        has_prev = true;
+      }
+      return true;
+    }
+
+    for (int i = 0; i <= x->count; ++i) {
+      if (!check(x->children[i], false, depth + 1, leaf_level, has_prev, prev)) return false;
+      if (i < x->count) {
+        if (has_prev && !(prev < x->keys[i])) return false;
+        prev = x->keys[i];
+        has_prev = true;
+      }
+    }
+    return true;
+  }
+};
+
+#endif
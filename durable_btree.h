@@ -0,0 +1,396 @@
+#ifndef DURABLE_BTREE_H
+#define DURABLE_BTREE_H
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+#include "btree.h"
+using namespace std;
+
+// Durabilidad para un BTree: log de escritura anticipada (WAL) con commit en
+// grupo y checkpoints periodicos. Usa POSIX (write/fsync/ftruncate).
+//
+// Directorio:
+//   checkpoint-<lsn>.bin  arbol guardado con BTree::save, incluye hasta lsn
+//   wal-<lsn>.log         registros con lsn > <lsn>, en orden
+//
+// Registro del WAL: {uint64 lsn, uint8 op, TK key, uint32 checksum}. La
+// recuperacion carga el ultimo checkpoint y reaplica los registros
+// siguientes; un registro incompleto o con checksum invalido (escritura
+// cortada por la caida) termina el log y se trunca.
+//
+// Si write o fsync del WAL fallan (salvo EINTR, que se reintenta) el log
+// queda marcado como fallido: no se sabe que llego al disco, asi que toda
+// escritura, sync o checkpoint posterior lanza runtime_error sin tocar el
+// arbol. Reabrir el directorio recupera el ultimo estado durable.
+
+enum class FsyncPolicy {
+  Always,    // insert/remove vuelven cuando su registro esta en disco
+  Interval,  // un hilo hace fsync cada interval_ms
+  Never      // solo write al llenarse el buffer; fsync en sync/checkpoint
+};
+
+struct DurabilityOptions {
+  FsyncPolicy fsync = FsyncPolicy::Always;
+  int interval_ms = 10;
+  // con Interval / Never: se escribe al sistema al llegar a este tamaño
+  size_t buffer_bytes = 1 << 20;
+  // checkpoint automatico cada tantas escrituras (0: solo checkpoint())
+  long long checkpoint_every = 0;
+};
+
+template <typename TK>
+class DurableBTree {
+  static_assert(is_trivially_copyable<TK>::value, "DurableBTree requiere keys trivialmente copiables");
+
+  enum : uint8_t { kInsert = 1, kRemove = 2 };
+  static constexpr size_t kRecordBytes = 8 + 1 + sizeof(TK) + 4;
+
+  filesystem::path dir;
+  int M;
+  DurabilityOptions opts;
+
+  // tree_mtx ordena las operaciones; log_mtx protege el buffer del WAL.
+  // Orden de bloqueo: tree_mtx antes que log_mtx
+  mutable mutex tree_mtx;
+  unique_ptr<BTree<TK>> tree;
+  long long since_checkpoint;
+
+  mutex log_mtx;
+  condition_variable log_cv;
+  int fd;
+  vector<char> buffer;  // registros todavia no escritos
+  vector<char> spare;   // buffer que usa el lider mientras escribe
+  uint64_t appended_lsn;
+  uint64_t written_lsn;
+  uint64_t durable_lsn;
+  bool flushing;
+  bool stopping;
+  atomic<bool> failed;  // un write/fsync del WAL fallo; ver arriba
+  thread syncer;
+
+  size_t replayed;
+
+ public:
+  // mensaje de las excepciones una vez que el log quedo fallido
+  static constexpr const char* kFailedLog = "El WAL fallo en una escritura anterior";
+
+  // abre (o crea) el directorio y recupera el estado guardado
+  DurableBTree(const string& _dir, int _M, DurabilityOptions _opts = {})
+      : dir(_dir), M(_M), opts(_opts), since_checkpoint(0), fd(-1), appended_lsn(0), written_lsn(0), durable_lsn(0),
+        flushing(false), stopping(false), failed(false), replayed(0) {
+    filesystem::create_directories(dir);
+    recover();
+    open_segment(appended_lsn);
+    if (opts.fsync == FsyncPolicy::Interval) syncer = thread([this] { sync_loop(); });
+  }
+
+  DurableBTree(const DurableBTree&) = delete;
+  DurableBTree& operator=(const DurableBTree&) = delete;
+
+  ~DurableBTree() {
+    {
+      lock_guard<mutex> l(log_mtx);
+      stopping = true;
+    }
+    log_cv.notify_all();
+    if (syncer.joinable()) syncer.join();
+    try {
+      sync();
+    } catch (...) {
+    }
+    if (fd >= 0) ::close(fd);
+  }
+
+  // true si la key no estaba
+  bool insert(TK key) { return write_op(kInsert, key); }
+
+  // true si la key estaba
+  bool remove(TK key) { return write_op(kRemove, key); }
+
+  //indica si se encuentra o no un elemento
+  bool search(TK key) const {
+    lock_guard<mutex> l(tree_mtx);
+    return tree->search(key);
+  }
+
+  vector<TK> rangeSearch(TK begin, TK end) const {
+    lock_guard<mutex> l(tree_mtx);
+    return tree->rangeSearch(begin, end);
+  }
+
+  int size() const {
+    lock_guard<mutex> l(tree_mtx);
+    return tree->size();
+  }
+
+  // todo lo aplicado hasta ahora queda en disco
+  void sync() {
+    uint64_t lsn;
+    {
+      lock_guard<mutex> l(log_mtx);
+      lsn = appended_lsn;
+    }
+    flush_to(lsn, true);
+  }
+
+  // guarda el arbol y empieza un segmento de WAL nuevo; los segmentos y
+  // checkpoints anteriores se borran. Bloquea las escrituras mientras dura
+  void checkpoint() {
+    lock_guard<mutex> t(tree_mtx);
+    checkpoint_locked();
+  }
+
+  uint64_t last_lsn() {
+    lock_guard<mutex> l(log_mtx);
+    return appended_lsn;
+  }
+
+  // registros reaplicados en la recuperacion
+  size_t replayed_records() const { return replayed; }
+
+ private:
+  bool write_op(uint8_t op, const TK& key) {
+    uint64_t lsn;
+    bool flush = false;
+    {
+      lock_guard<mutex> t(tree_mtx);
+      if (failed) throw runtime_error(kFailedLog);
+      int before = tree->size();
+      if (op == kInsert)
+        tree->insert(key);
+      else
+        tree->remove(key);
+      if (tree->size() == before) return false;  // sin cambios, nada que registrar
+
+      {
+        lock_guard<mutex> l(log_mtx);
+        lsn = ++appended_lsn;
+        append_record(buffer, lsn, op, key);
+        flush = buffer.size() >= opts.buffer_bytes;
+      }
+      if (opts.checkpoint_every > 0 && ++since_checkpoint >= opts.checkpoint_every) checkpoint_locked();
+    }
+    // fuera del lock del arbol: mientras un hilo escribe el grupo, los demas
+    // siguen aplicando operaciones que entran en el grupo siguiente
+    if (opts.fsync == FsyncPolicy::Always)
+      flush_to(lsn, true);
+    else if (flush)
+      flush_to(lsn, false);
+    return true;
+  }
+
+  static uint32_t checksum(const char* data, size_t bytes) {
+    uint32_t h = 2166136261u;  // FNV-1a
+    for (size_t i = 0; i < bytes; ++i) h = (h ^ static_cast<unsigned char>(data[i])) * 16777619u;
+    return h;
+  }
+
+  static void append_record(vector<char>& out, uint64_t lsn, uint8_t op, const TK& key) {
+    size_t at = out.size();
+    out.resize(at + kRecordBytes);
+    char* p = out.data() + at;
+    memcpy(p, &lsn, 8);
+    p[8] = static_cast<char>(op);
+    memcpy(p + 9, &key, sizeof(TK));
+    uint32_t sum = checksum(p, kRecordBytes - 4);
+    memcpy(p + kRecordBytes - 4, &sum, 4);
+  }
+
+  // commit en grupo: el primer hilo que encuentra el log libre escribe todo
+  // el buffer (con fsync si sync) y los que esperan un lsn incluido vuelven
+  // sin escribir. Si la escritura falla el log queda fallido y tanto el
+  // lider como los que esperaban lanzan
+  void flush_to(uint64_t lsn, bool sync) {
+    unique_lock<mutex> l(log_mtx);
+    while ((sync ? durable_lsn : written_lsn) < lsn) {
+      if (failed) throw runtime_error(kFailedLog);
+      if (flushing) {
+        log_cv.wait(l);
+        continue;
+      }
+      flushing = true;
+      spare.swap(buffer);
+      uint64_t upto = appended_lsn;
+      int out = fd;
+      l.unlock();
+      try {
+        write_all(out, spare.data(), spare.size());
+        if (sync && ::fsync(out) != 0) throw runtime_error("Error en fsync del WAL");
+      } catch (...) {
+        l.lock();
+        failed = true;
+        flushing = false;
+        log_cv.notify_all();
+        throw;
+      }
+      spare.clear();
+      l.lock();
+      written_lsn = upto;
+      if (sync) durable_lsn = upto;
+      flushing = false;
+      log_cv.notify_all();
+    }
+  }
+
+  static void write_all(int out, const char* data, size_t bytes) {
+    while (bytes > 0) {
+      ssize_t w = ::write(out, data, bytes);
+      if (w < 0 && errno == EINTR) continue;
+      if (w < 0) throw runtime_error("Error escribiendo el WAL");
+      data += w;
+      bytes -= static_cast<size_t>(w);
+    }
+  }
+
+  void sync_loop() {
+    unique_lock<mutex> l(log_mtx);
+    while (!stopping) {
+      log_cv.wait_for(l, chrono::milliseconds(opts.interval_ms));
+      uint64_t lsn = appended_lsn;
+      if (durable_lsn >= lsn || failed) continue;
+      l.unlock();
+      try {
+        flush_to(lsn, true);
+      } catch (...) {
+        // el log queda fallido; sync() y las escrituras informan el error
+      }
+      l.lock();
+    }
+  }
+
+  void checkpoint_locked() {
+    uint64_t lsn = last_lsn();
+    flush_to(lsn, true);
+
+    filesystem::path tmp = dir / (name("checkpoint-", lsn) + ".tmp");
+    filesystem::path final_path = dir / (name("checkpoint-", lsn) + ".bin");
+    tree->save(tmp.string());
+    fsync_path(tmp, false);
+    filesystem::rename(tmp, final_path);
+    fsync_path(dir, true);
+    open_segment(lsn);
+
+    // lo anterior al checkpoint ya no hace falta
+    for (auto& entry : filesystem::directory_iterator(dir)) {
+      uint64_t other;
+      string file = entry.path().filename().string();
+      if ((parse(file, "checkpoint-", ".bin", other) || parse(file, "wal-", ".log", other)) && other < lsn)
+        filesystem::remove(entry.path());
+    }
+    since_checkpoint = 0;
+  }
+
+  // cierra el segmento actual y abre wal-<start>.log para lo que sigue
+  void open_segment(uint64_t start) {
+    unique_lock<mutex> l(log_mtx);
+    log_cv.wait(l, [this] { return !flushing; });
+    if (fd >= 0) ::close(fd);
+    filesystem::path path = dir / (name("wal-", start) + ".log");
+    fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+    if (fd < 0) throw runtime_error("No se pudo abrir " + path.string());
+    l.unlock();
+    fsync_path(dir, true);
+  }
+
+  void recover() {
+    uint64_t base = 0;
+    bool has_checkpoint = false;
+    vector<pair<uint64_t, filesystem::path>> segments;
+    for (auto& entry : filesystem::directory_iterator(dir)) {
+      uint64_t lsn;
+      string file = entry.path().filename().string();
+      if (parse(file, "checkpoint-", ".bin", lsn)) {
+        if (!has_checkpoint || lsn > base) base = lsn;
+        has_checkpoint = true;
+      } else if (parse(file, "wal-", ".log", lsn)) {
+        segments.push_back({lsn, entry.path()});
+      } else if (entry.path().extension() == ".tmp") {
+        filesystem::remove(entry.path());  // checkpoint a medio escribir
+      }
+    }
+
+    if (has_checkpoint)
+      tree.reset(BTree<TK>::load((dir / (name("checkpoint-", base) + ".bin")).string()));
+    else
+      tree.reset(new BTree<TK>(M));
+
+    std::sort(segments.begin(), segments.end());
+    uint64_t last = base;
+    for (auto& seg : segments) replay(seg.second, last);
+    appended_lsn = written_lsn = durable_lsn = last;
+  }
+
+  // reaplica los registros consecutivos a last; trunca una cola invalida
+  void replay(const filesystem::path& path, uint64_t& last) {
+    FILE* f = fopen(path.c_str(), "rb");
+    if (!f) throw runtime_error("No se pudo abrir " + path.string());
+    vector<char> data;
+    char chunk[1 << 16];
+    for (size_t got; (got = fread(chunk, 1, sizeof(chunk), f)) > 0;) data.insert(data.end(), chunk, chunk + got);
+    fclose(f);
+
+    size_t pos = 0;
+    for (; pos + kRecordBytes <= data.size(); pos += kRecordBytes) {
+      const char* p = data.data() + pos;
+      uint32_t sum;
+      memcpy(&sum, p + kRecordBytes - 4, 4);
+      uint8_t op = static_cast<uint8_t>(p[8]);
+      if (sum != checksum(p, kRecordBytes - 4) || (op != kInsert && op != kRemove)) break;
+      uint64_t lsn;
+      TK key;
+      memcpy(&lsn, p, 8);
+      memcpy(&key, p + 9, sizeof(TK));
+      if (lsn <= last) continue;  // ya incluido en el checkpoint
+      if (lsn != last + 1) break;
+      if (op == kInsert)
+        tree->insert(key);
+      else
+        tree->remove(key);
+      last = lsn;
+      replayed++;
+    }
+    if (pos < data.size()) filesystem::resize_file(path, pos);
+  }
+
+  static void fsync_path(const filesystem::path& path, bool directory) {
+    int f = ::open(path.c_str(), directory ? O_RDONLY | O_DIRECTORY : O_RDONLY);
+    if (f < 0) throw runtime_error("No se pudo abrir " + path.string());
+    int r = ::fsync(f);
+    ::close(f);
+    if (r != 0) throw runtime_error("Error en fsync de " + path.string());
+  }
+
+  // nombres con el lsn en 20 digitos, asi el orden alfabetico es el numerico
+  static string name(const char* prefix, uint64_t lsn) {
+    char digits[32];
+    snprintf(digits, sizeof(digits), "%020llu", static_cast<unsigned long long>(lsn));
+    return string(prefix) + digits;
+  }
+
+  static bool parse(const string& file, const string& prefix, const string& suffix, uint64_t& lsn) {
+    if (file.size() != prefix.size() + 20 + suffix.size()) return false;
+    if (file.compare(0, prefix.size(), prefix) != 0 || file.compare(prefix.size() + 20, suffix.size(), suffix) != 0)
+      return false;
+    lsn = 0;
+    for (size_t i = prefix.size(); i < prefix.size() + 20; ++i) {
+      if (file[i] < '0' || file[i] > '9') return false;
+      lsn = lsn * 10 + static_cast<uint64_t>(file[i] - '0');
+    }
+    return true;
+  }
+};
+
+#endif
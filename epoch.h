@@ -0,0 +1,138 @@
+#ifndef EPOCH_H
+#define EPOCH_H
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+// Reclamacion de memoria por epocas para estructuras con lectores sin locks.
+// Cada operacion entra con un EpochGuard, que publica la epoca global en el
+// slot del hilo. Un nodo retirado (ya inalcanzable) se libera recien cuando
+// todos los hilos activos entraron en una epoca posterior a su retiro, asi
+// ningun lector optimista puede estar leyendolo.
+
+// indice de slot por hilo, compartido por todos los EpochManager
+class EpochThreadSlot {
+ public:
+  static constexpr int kMaxThreads = 1024;
+
+  static int id() {
+    thread_local EpochThreadSlot slot;
+    return slot.index;
+  }
+
+ private:
+  int index;
+
+  static atomic<bool>* taken() {
+    static atomic<bool> flags[kMaxThreads] = {};
+    return flags;
+  }
+
+  EpochThreadSlot() : index(-1) {
+    for (int i = 0; i < kMaxThreads; ++i) {
+      bool expected = false;
+      if (taken()[i].compare_exchange_strong(expected, true)) {
+        index = i;
+        return;
+      }
+    }
+    throw runtime_error("Demasiados hilos para EpochManager");
+  }
+
+  ~EpochThreadSlot() { taken()[index].store(false); }
+};
+
+class EpochManager {
+  struct alignas(64) Slot {
+    // 0: el hilo no esta dentro de una operacion
+    atomic<uint64_t> epoch{0};
+  };
+
+  struct Retired {
+    uint64_t epoch;
+    void* ptr;
+  };
+
+  // cada cuantos retiros se avanza la epoca y se intenta liberar
+  static constexpr size_t kReclaimEvery = 64;
+
+  atomic<uint64_t> global;
+  Slot slots[EpochThreadSlot::kMaxThreads];
+  mutex retired_mutex;
+  vector<Retired> retired;
+  function<void(void*)> deleter;
+
+ public:
+  explicit EpochManager(function<void(void*)> _deleter) : global(1), deleter(std::move(_deleter)) {}
+
+  EpochManager(const EpochManager&) = delete;
+  EpochManager& operator=(const EpochManager&) = delete;
+
+  // sin hilos activos: libera todo lo retirado
+  ~EpochManager() { drain(); }
+
+  void enter() {
+    slots[EpochThreadSlot::id()].epoch.store(global.load());
+    // la publicacion del slot debe verse antes que cualquier lectura de nodos
+    atomic_thread_fence(memory_order_seq_cst);
+  }
+  void exit() { slots[EpochThreadSlot::id()].epoch.store(0, memory_order_release); }
+
+  // ptr ya no es alcanzable desde la estructura
+  void retire(void* ptr) {
+    lock_guard<mutex> lock(retired_mutex);
+    retired.push_back({global.load(), ptr});
+    if (retired.size() % kReclaimEvery == 0) {
+      global.fetch_add(1);
+      reclaim_locked();
+    }
+  }
+
+  // libera todo lo retirado; solo cuando ningun hilo esta dentro
+  void drain() {
+    lock_guard<mutex> lock(retired_mutex);
+    for (Retired& r : retired) deleter(r.ptr);
+    retired.clear();
+  }
+
+  size_t pending() {
+    lock_guard<mutex> lock(retired_mutex);
+    return retired.size();
+  }
+
+ private:
+  void reclaim_locked() {
+    uint64_t min_active = global.load();
+    for (Slot& s : slots) {
+      uint64_t e = s.epoch.load();
+      if (e != 0 && e < min_active) min_active = e;
+    }
+    size_t kept = 0;
+    for (Retired& r : retired) {
+      if (r.epoch < min_active)
+        deleter(r.ptr);
+      else
+        retired[kept++] = r;
+    }
+    retired.resize(kept);
+  }
+};
+
+// entra en la epoca al construirse y sale al destruirse
+class EpochGuard {
+  EpochManager& manager;
+
+ public:
+  explicit EpochGuard(EpochManager& _manager) : manager(_manager) { manager.enter(); }
+  ~EpochGuard() { manager.exit(); }
+  EpochGuard(const EpochGuard&) = delete;
+  EpochGuard& operator=(const EpochGuard&) = delete;
+};
+
+#endif
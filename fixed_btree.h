@@ -0,0 +1,366 @@
+#ifndef FIXED_BTREE_H
+#define FIXED_BTREE_H
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+#include "node.h"
+#include "node_search.h"
+using namespace std;
+
+// Variante de BTree con el orden M fijado en tiempo de compilacion.
+// Cada nodo es un unico bloque alineado (FixedNode) con keys e hijos inline,
+// por lo que cada nivel del descenso toca un solo bloque de memoria.
+template <typename TK, int M>
+class FixedBTree {
+  //La implementación de este BTree no soporta valores repetidos
+  static_assert(M >= 3, "M debe ser al menos 3");
+
+ public:
+  using node_type = FixedNode<TK, M>;
+
+ private:
+  node_type* root;
+  int n;  // total de elementos en el arbol
+
+ public:
+  FixedBTree() : root(nullptr), n(0) {}
+
+  FixedBTree(const FixedBTree&) = delete;
+  FixedBTree& operator=(const FixedBTree&) = delete;
+
+  static constexpr int order() { return M; }
+
+  //indica si se encuentra o no un elemento
+  bool search(TK key) {
+    node_type* nodo = root;
+    while (nodo) {
+      int pos = node_lower_bound(nodo->keys, nodo->count, key);
+      if (pos < nodo->count && nodo->keys[pos] == key) return true;
+      if (nodo->leaf) return false;
+      nodo = nodo->children[pos];
+    }
+    return false;
+  }
+
+  node_type* insert(TK key) {
+    //caso1: arbol sin raiz
+    if (!root) {
+      root = new node_type();
+      root->keys[0] = key;
+      root->count = 1;
+      n = 1;
+      return root;
+    }
+
+    //caso2: insertar normalmente
+    n++;
+    TK promoted_key;
+    node_type* new_child = insert_rec(root, key, promoted_key);
+    if (!new_child) return root;
+
+    //caso3: split en la raiz
+    node_type* new_root = new node_type();
+    new_root->leaf = false;
+    new_root->keys[0] = promoted_key;
+    new_root->count = 1;
+    new_root->children[0] = root;
+    new_root->children[1] = new_child;
+    root = new_root;
+    return root;
+  }
+
+  void remove(TK key) {
+    if (!root) return;
+    if (!remove_rec(root, key)) return;
+    n--;
+    // Si la raíz quedó vacía pero tiene un hijo, promoverlo
+    if (root->count == 0 && !root->leaf) {
+      node_type* old_root = root;
+      root = root->children[0];
+      old_root->leaf = true;
+      delete old_root;
+    }
+    // Si el árbol quedó completamente vacío
+    if (root && root->count == 0 && root->leaf) {
+      delete root;
+      root = nullptr;
+    }
+  }
+
+  //altura del arbol. Considerar altura 0 para arbol vacio
+  int height() {
+    if (!root) return 0;
+    int cont = 0;
+    for (node_type* temp = root; !temp->leaf; temp = temp->children[0]) cont++;
+    return cont;
+  }
+
+  // recorrido inorder
+  string toString(const string& sep) {
+    string out;
+    bool first = true;
+    toString(root, sep, out, first);
+    return out;
+  }
+
+  vector<TK> rangeSearch(TK begin, TK end) {
+    vector<TK> out;
+    if (!root) return out;
+    if (end < begin) std::swap(begin, end);
+    range_search_rec(root, begin, end, out);
+    return out;
+  }
+
+  // mínimo valor del árbol
+  TK minKey() {
+    if (!root) throw runtime_error("El árbol está vacío");
+    node_type* temp = root;
+    while (!temp->leaf) temp = temp->children[0];
+    return temp->keys[0];
+  }
+
+  // máximo valor del árbol
+  TK maxKey() {
+    if (!root) throw runtime_error("El árbol está vacío");
+    node_type* temp = root;
+    while (!temp->leaf) temp = temp->children[temp->count];
+    return temp->keys[temp->count - 1];
+  }
+
+  // eliminar todos lo elementos del arbol
+  void clear() {
+    delete root;
+    root = nullptr;
+    n = 0;
+  }
+
+  int size() const { return n; }
+
+  // Verifique las propiedades de un árbol B
+  bool check_properties() {
+    if (!root) return true;
+    int leaf_level = -1;
+    bool has_prev = false;
+    TK prev{};
+    return check(root, true, 1, leaf_level, has_prev, prev);
+  }
+
+  ~FixedBTree() {
+    clear();
+  }
+
+ private:
+  // metodos para la insercion
+  node_type* split(node_type* node, TK& promoted_key, bool is_leaf) {
+    int mid_idx = M / 2;
+    promoted_key = node->keys[mid_idx];
+
+    node_type* right = new node_type();
+    right->leaf = is_leaf;
+    int j = 0;
+    for (int i = mid_idx + 1; i < node->count; i++) right->keys[j++] = node->keys[i];
+    right->count = j;
+
+    if (!is_leaf) {
+      for (int i = mid_idx + 1, k = 0; i <= node->count; i++, k++)
+        right->children[k] = node->children[i];
+    }
+    node->count = mid_idx;
+    return right;
+  }
+
+  node_type* insert_rec(node_type* node, const TK& key, TK& promoted_key) {
+    //indice del primer key >= key
+    int child_idx = node_lower_bound(node->keys, node->count, key);
+    if (child_idx < node->count && node->keys[child_idx] == key) {
+      n--;  // llave duplicada, sin insercion
+      return nullptr;
+    }
+
+    if (node->leaf) {
+      int insert_pos = node->count;
+      while (insert_pos > child_idx) {
+        node->keys[insert_pos] = node->keys[insert_pos - 1];
+        insert_pos--;
+      }
+      node->keys[insert_pos] = key;
+      node->count++;
+      if (node->count == M) return split(node, promoted_key, true);
+      return nullptr;
+    }
+
+    TK child_promoted_key;
+    node_type* new_child = insert_rec(node->children[child_idx], key, child_promoted_key);
+    if (!new_child) return nullptr;
+
+    int insert_pos = node->count;
+    while (insert_pos > child_idx) {
+      node->keys[insert_pos] = node->keys[insert_pos - 1];
+      node->children[insert_pos + 1] = node->children[insert_pos];
+      insert_pos--;
+    }
+    node->keys[insert_pos] = child_promoted_key;
+    node->children[insert_pos + 1] = new_child;
+    node->count++;
+    if (node->count == M) return split(node, promoted_key, false);
+    return nullptr;
+  }
+
+  // metodos para la eliminacion
+  bool remove_rec(node_type* node, const TK& key) {
+    const int min_keys = (M + 1) / 2 - 1;
+
+    int child_idx = node_lower_bound(node->keys, node->count, key);
+    int pos = (child_idx < node->count && node->keys[child_idx] == key) ? child_idx : -1;
+
+    if (node->leaf) {
+      if (pos == -1) return false;
+      for (int i = pos; i < node->count - 1; i++) node->keys[i] = node->keys[i + 1];
+      node->count--;
+      return true;
+    }
+
+    //caso3: key en nodo interno, reemplazar con sucesor
+    if (pos != -1) {
+      node_type* succ = node->children[pos + 1];
+      while (!succ->leaf) succ = succ->children[0];
+      node->keys[pos] = succ->keys[0];
+      child_idx = pos + 1;
+    }
+
+    node_type* child = node->children[child_idx];
+    const TK target = pos != -1 ? node->keys[pos] : key;
+    if (!remove_rec(child, target)) return false;
+    if (child->count < min_keys) fix_child(node, child_idx);
+    return true;
+  }
+
+  void fix_child(node_type* parent, int child_idx) {
+    const int min_keys = (M + 1) / 2 - 1;
+    if (child_idx > 0 && parent->children[child_idx - 1]->count > min_keys) {
+      borrow_from_left(parent, child_idx);
+    } else if (child_idx < parent->count && parent->children[child_idx + 1]->count > min_keys) {
+      borrow_from_right(parent, child_idx);
+    } else if (child_idx > 0) {
+      merge(parent, child_idx - 1);
+    } else {
+      merge(parent, child_idx);
+    }
+  }
+
+  void borrow_from_left(node_type* parent, int child_idx) {
+    node_type* child = parent->children[child_idx];
+    node_type* left_sibling = parent->children[child_idx - 1];
+    for (int i = child->count; i > 0; i--) child->keys[i] = child->keys[i - 1];
+    if (!child->leaf) {
+      for (int i = child->count + 1; i > 0; i--) child->children[i] = child->children[i - 1];
+      child->children[0] = left_sibling->children[left_sibling->count];
+    }
+    child->keys[0] = parent->keys[child_idx - 1];
+    child->count++;
+    parent->keys[child_idx - 1] = left_sibling->keys[left_sibling->count - 1];
+    left_sibling->count--;
+  }
+
+  void borrow_from_right(node_type* parent, int child_idx) {
+    node_type* child = parent->children[child_idx];
+    node_type* right_sibling = parent->children[child_idx + 1];
+    child->keys[child->count] = parent->keys[child_idx];
+    child->count++;
+    parent->keys[child_idx] = right_sibling->keys[0];
+    if (!child->leaf) child->children[child->count] = right_sibling->children[0];
+    for (int i = 0; i < right_sibling->count - 1; i++) right_sibling->keys[i] = right_sibling->keys[i + 1];
+    if (!right_sibling->leaf) {
+      for (int i = 0; i < right_sibling->count; i++) right_sibling->children[i] = right_sibling->children[i + 1];
+    }
+    right_sibling->count--;
+  }
+
+  // fusionar children[idx + 1] dentro de children[idx]
+  void merge(node_type* parent, int idx) {
+    node_type* left = parent->children[idx];
+    node_type* right = parent->children[idx + 1];
+
+    left->keys[left->count++] = parent->keys[idx];
+    int base = left->count;
+    for (int i = 0; i < right->count; i++) left->keys[left->count++] = right->keys[i];
+    if (!left->leaf) {
+      for (int i = 0; i <= right->count; i++) left->children[base + i] = right->children[i];
+    }
+
+    for (int i = idx; i < parent->count - 1; i++) parent->keys[i] = parent->keys[i + 1];
+    for (int i = idx + 1; i < parent->count; i++) parent->children[i] = parent->children[i + 1];
+    parent->count--;
+
+    right->leaf = true;  // sus hijos ya pertenecen a left
+    delete right;
+  }
+
+  // helpers
+  void range_search_rec(node_type* x, const TK& a, const TK& b, vector<TK>& out) {
+    if (x->leaf) {
+      for (int i = 0; i < x->count; ++i) {
+        if (x->keys[i] < a) continue;
+        if (b < x->keys[i]) break;
+        out.push_back(x->keys[i]);
+      }
+      return;
+    }
+    for (int i = 0; i < x->count; ++i) {
+      if (!(x->keys[i] < a)) range_search_rec(x->children[i], a, b, out);
+      if (b < x->keys[i]) return;
+      if (!(x->keys[i] < a)) out.push_back(x->keys[i]);
+    }
+    range_search_rec(x->children[x->count], a, b, out);
+  }
+
+  bool check(node_type* x, bool is_root, int depth, int& leaf_level, bool& has_prev, TK& prev) {
+    const int max_keys = M - 1;
+    const int min_keys_non_root = (M + 1) / 2 - 1;
+
+    if (x->count < 0 || x->count > max_keys) return false;
+    if (is_root) {
+      if (!x->leaf && x->count < 1) return false;
+    } else {
+      if (x->count < min_keys_non_root) return false;
+    }
+
+    if (x->leaf) {
+      if (leaf_level == -1)
+        leaf_level = depth;
+      else if (leaf_level != depth)
+        return false;
+      for (int i = 0; i < x->count; ++i) {
+        if (has_prev && !(prev < x->keys[i])) return false;
+        prev = x->keys[i];
+        has_prev = true;
+      }
+      return true;
+    }
+
+    for (int i = 0; i <= x->count; ++i)
+      if (x->children[i] == nullptr) return false;
+
+    if (!check(x->children[0], false, depth + 1, leaf_level, has_prev, prev)) return false;
+    for (int i = 0; i < x->count; ++i) {
+      if (has_prev && !(prev < x->keys[i])) return false;
+      prev = x->keys[i];
+      has_prev = true;
+      if (!check(x->children[i + 1], false, depth + 1, leaf_level, has_prev, prev)) return false;
+    }
+    return true;
+  }
+
+  void toString(node_type* nodo, const string& sep, string& out, bool& first) {
+    if (!nodo) return;
+    for (int i = 0; i < nodo->count; ++i) {
+      if (!nodo->leaf) toString(nodo->children[i], sep, out, first);
+      if (!first) out += sep;
+      out += std::to_string(nodo->keys[i]);
+      first = false;
+    }
+    if (!nodo->leaf) toString(nodo->children[nodo->count], sep, out, first);
+  }
+};
+
+#endif
@@ -1,13 +1,73 @@
 #ifndef NODE_H
 #define NODE_H
+#include <limits>
+#include <type_traits>
 
 using namespace std;
 
+// Aumentaciones opcionales de BTree: cada politica define los datos extra
+// que guarda cada nodo sobre su subarbol.
+// sin datos extra (la base vacia no ocupa espacio)
+struct NoAugment {
+  static constexpr bool counted = false;
+  static constexpr bool aggregated = false;
+  struct data {};
+};
+
+// cantidad de keys del subarbol, para rank/select/rangeCount
+struct SubtreeSize {
+  static constexpr bool counted = true;
+  static constexpr bool aggregated = false;
+  struct data {
+    // keys del subarbol (en hojas se usa count)
+    long long size = 0;
+  };
+};
+
+// agregado del subarbol segun un monoide, para aggregate(a, b).
+// Monoid define value_type, identity(), lift(key) y combine(x, y);
+// combine debe ser asociativa. Con Counted tambien guarda el tamaño.
+template <typename Monoid, bool Counted = false>
+struct SubtreeAggregate {
+  using monoid = Monoid;
+  static constexpr bool counted = Counted;
+  static constexpr bool aggregated = true;
+  struct data : conditional_t<Counted, SubtreeSize::data, NoAugment::data> {
+    // combinacion en orden de todas las keys del subarbol
+    typename Monoid::value_type agg = Monoid::identity();
+  };
+};
+
+// monoides de uso comun sobre la propia key
+template <typename TK, typename V = TK>
+struct SumMonoid {
+  using value_type = V;
+  static V identity() { return V(); }
+  static V lift(const TK& key) { return static_cast<V>(key); }
+  static V combine(const V& x, const V& y) { return x + y; }
+};
+
+template <typename TK>
+struct MinMonoid {
+  using value_type = TK;
+  static TK identity() { return numeric_limits<TK>::max(); }
+  static TK lift(const TK& key) { return key; }
+  static TK combine(const TK& x, const TK& y) { return y < x ? y : x; }
+};
+
 template <typename TK>
-struct Node {
+struct MaxMonoid {
+  using value_type = TK;
+  static TK identity() { return numeric_limits<TK>::lowest(); }
+  static TK lift(const TK& key) { return key; }
+  static TK combine(const TK& x, const TK& y) { return x < y ? y : x; }
+};
+
+template <typename TK, typename Aug = NoAugment>
+struct Node : Aug::data {
   // array de keys
   TK* keys;
-  // array de punteros a hijos
+  // array de punteros a hijos (nullptr en hojas, ver NodePool)
   Node** children;
   // cantidad de keys
   int count;
@@ -16,30 +76,75 @@ struct Node {
 
   Node() : keys(nullptr), children(nullptr), count(0), leaf(true) {}
 
-  Node(int M) {
-    keys = new TK[M];
-    children = new Node<TK>*[M + 1];
-    for (int i = 0; i < M + 1; ++i)
-      children[i] = nullptr;
-    count = 0;
-    leaf = true;
-  }
+  // keys (e hijos si es interno) viven en el mismo bloque que el nodo
+  Node(TK* _keys, Node** _children) : keys(_keys), children(_children), count(0), leaf(true) {}
+};
+
+// Nodo del modo B+: las hojas guardan todas las keys y se enlazan con
+// next/prev para recorrer rangos sin volver a subir por el arbol
+template <typename TK>
+struct BPlusNode {
+  // array de keys (en nodos internos son copias separadoras)
+  TK* keys;
+  // array de punteros a hijos (nullptr en hojas)
+  BPlusNode** children;
+  // hojas vecinas (solo en hojas)
+  BPlusNode* next;
+  BPlusNode* prev;
+  // cantidad de keys
+  int count;
+  // indicador de nodo hoja
+  bool leaf;
+
+  BPlusNode(TK* _keys, BPlusNode** _children)
+      : keys(_keys), children(_children), next(nullptr), prev(nullptr), count(0), leaf(true) {}
+};
+
+// Nodo de BTreeMap: los valores van en un arreglo aparte, paralelo a keys
+// (values[i] es el valor de keys[i]). La busqueda solo recorre keys, que
+// quedan contiguas como en Node; el valor se toca solo al encontrar la key
+template <typename TK, typename TV>
+struct MapNode {
+  // array de keys
+  TK* keys;
+  // array de valores (mismo bloque, despues de keys)
+  TV* values;
+  // array de punteros a hijos (nullptr en hojas)
+  MapNode** children;
+  // cantidad de keys
+  int count;
+  // indicador de nodo hoja
+  bool leaf;
+
+  MapNode(TK* _keys, TV* _values, MapNode** _children)
+      : keys(_keys), values(_values), children(_children), count(0), leaf(true) {}
+};
+
+// Nodo de orden fijo M: keys e hijos viven dentro del mismo bloque,
+// alineado a linea de cache, con una sola reserva de memoria por nodo
+template <typename TK, int M>
+struct alignas(64) FixedNode {
+  // cantidad de keys
+  int count;
+  // indicador de nodo hoja
+  bool leaf;
+  // array de keys (inline)
+  TK keys[M];
+  // array de punteros a hijos (inline, solo se usa en nodos internos)
+  FixedNode* children[M + 1];
+
+  FixedNode() : count(0), leaf(true) {}
 
   void killSelf() {
-    if (children) {
-      int limit = leaf ? 0 : (count + 1);
-      for (int i = 0; i < limit; ++i) {
-        delete children[i];
-        children[i] = nullptr;
-      }
-      delete[] children;
-      children = nullptr;
+    if (leaf) return;
+    for (int i = 0; i <= count; ++i) {
+      delete children[i];
+      children[i] = nullptr;
     }
-    delete[] keys;
-    keys = nullptr;
+    leaf = true;
   }
 
-  ~Node(){
+  ~FixedNode() {
     killSelf();
   }
 };
@@ -0,0 +1,224 @@
+#ifndef NODE_POOL_H
+#define NODE_POOL_H
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <new>
+#include <type_traits>
+#include <vector>
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+#include "node.h"
+
+using namespace std;
+
+// Reserva de nodos por slabs para un arbol de orden M. NodeT es el tipo de
+// cabecera (Node<TK> o BPlusNode<TK>), construible desde (keys, children);
+// con TV != void (MapNode<TK, TV>) el bloque lleva ademas M valores despues
+// de las keys y NodeT se construye desde (keys, values, children).
+// Cada nodo (cabecera + keys [+ valores] [+ hijos]) ocupa un solo bloque de tamaño fijo
+// tomado de slabs grandes pedidos a un std::pmr::memory_resource. Las hojas
+// usan un bloque sin arreglo de hijos; los nodos internos uno con los M + 1
+// punteros. Cada tipo de bloque tiene su propia free list y release()
+// devuelve todos los slabs de una vez, en O(#slabs).
+template <typename TK, typename NodeT = Node<TK>, typename TV = void>
+class NodePool {
+  struct FreeBlock {
+    FreeBlock* next;
+  };
+
+  struct Slab {
+    void* ptr;
+    size_t bytes;
+    size_t align;
+  };
+
+  static constexpr size_t round_up(size_t x, size_t a) { return (x + a - 1) / a * a; }
+
+  template <typename T>
+  static constexpr size_t size_of() {
+    if constexpr (is_void<T>::value) return 0;
+    else return sizeof(T);
+  }
+  template <typename T>
+  static constexpr size_t align_of() {
+    if constexpr (is_void<T>::value) return 1;
+    else return alignof(T);
+  }
+
+  static constexpr size_t kValueSize = size_of<TV>();
+  static constexpr size_t kValueAlign = align_of<TV>();
+  static constexpr size_t kKeyAlign = alignof(NodeT) > alignof(TK) ? alignof(NodeT) : alignof(TK);
+  static constexpr size_t kAlign = kKeyAlign > kValueAlign ? kKeyAlign : kValueAlign;
+  static constexpr size_t kKeysOffset = round_up(sizeof(NodeT), alignof(TK));
+  static constexpr size_t kCacheLine = 64;
+
+  int M;
+  size_t values_offset;
+  size_t children_offset;
+  size_t leaf_bytes;
+  size_t internal_bytes;
+  size_t slab_bytes;
+  bool huge_pages;
+  pmr::memory_resource* upstream;
+
+  vector<Slab> slabs;
+  char* cur;
+  char* end;
+  FreeBlock* free_leaves;
+  FreeBlock* free_internals;
+  size_t live_leaves;
+  size_t live_internals;
+
+ public:
+  static constexpr size_t kDefaultSlabBytes = size_t(1) << 20;
+  static constexpr size_t kHugePageBytes = size_t(2) << 20;
+
+  // upstream: origen de los slabs (por defecto el recurso pmr global)
+  // huge_pages: alinear los slabs a 2MB y pedir transparent huge pages
+  NodePool(int _M, pmr::memory_resource* _upstream = pmr::get_default_resource(), bool _huge_pages = false,
+           size_t _slab_bytes = kDefaultSlabBytes)
+      : M(_M),
+        values_offset(round_up(kKeysOffset + sizeof(TK) * _M, kValueAlign)),
+        children_offset(round_up(values_offset + kValueSize * _M, alignof(NodeT*))),
+        leaf_bytes(round_up(values_offset + kValueSize * _M, kAlign)),
+        internal_bytes(round_up(children_offset + sizeof(NodeT*) * (_M + 1), kAlign)),
+        slab_bytes(_slab_bytes),
+        huge_pages(_huge_pages),
+        upstream(_upstream ? _upstream : pmr::get_default_resource()),
+        cur(nullptr),
+        end(nullptr),
+        free_leaves(nullptr),
+        free_internals(nullptr),
+        live_leaves(0),
+        live_internals(0) {
+    if (huge_pages) slab_bytes = round_up(slab_bytes, kHugePageBytes);
+    if (slab_bytes < internal_bytes) slab_bytes = internal_bytes;
+  }
+
+  NodePool(const NodePool&) = delete;
+  NodePool& operator=(const NodePool&) = delete;
+
+  ~NodePool() {
+    release();
+  }
+
+  // nodo vacio con keys (y valores) construidos por defecto. Las hojas no
+  // tienen arreglo de hijos (children == nullptr); los internos lo tienen en
+  // nullptr
+  NodeT* create(bool leaf) {
+    char* mem = leaf ? take(free_leaves, leaf_bytes) : take(free_internals, internal_bytes);
+    TK* keys = reinterpret_cast<TK*>(mem + kKeysOffset);
+    std::uninitialized_default_construct_n(keys, M);
+    NodeT** children = nullptr;
+    if (!leaf) {
+      children = reinterpret_cast<NodeT**>(mem + children_offset);
+      for (int i = 0; i < M + 1; ++i) children[i] = nullptr;
+    }
+    NodeT* node;
+    if constexpr (is_void<TV>::value) {
+      node = new (mem) NodeT(keys, children);
+    } else {
+      TV* values = reinterpret_cast<TV*>(mem + values_offset);
+      std::uninitialized_default_construct_n(values, M);
+      node = new (mem) NodeT(keys, values, children);
+    }
+    node->leaf = leaf;
+    (leaf ? live_leaves : live_internals)++;
+    return node;
+  }
+
+  // devuelve un nodo a la free list de su tipo (no libera sus hijos)
+  void destroy(NodeT* node) {
+    bool leaf = node->leaf;
+    std::destroy_n(node->keys, M);
+    if constexpr (!is_void<TV>::value) std::destroy_n(node->values, M);
+    node->~NodeT();
+    FreeBlock* block = reinterpret_cast<FreeBlock*>(node);
+    FreeBlock*& list = leaf ? free_leaves : free_internals;
+    block->next = list;
+    list = block;
+    (leaf ? live_leaves : live_internals)--;
+  }
+
+  // pide a la cache el bloque de node sin leerlo: la cabecera y, si las
+  // keys pasan de la primera linea, la siguiente. node->keys apunta dentro
+  // del mismo bloque, asi que no hace falta esperar al nodo para ubicarlas
+  void prefetch(const NodeT* node) const {
+    const char* p = reinterpret_cast<const char*>(node);
+    __builtin_prefetch(p);
+    if (values_offset > kCacheLine) __builtin_prefetch(p + kCacheLine);
+  }
+
+  // adopta los slabs, free lists y nodos vivos de other, que queda vacio.
+  // Ambos pools deben tener el mismo M y el mismo upstream (p. ej. pools
+  // locales de cada hilo en la construccion paralela)
+  void absorb(NodePool& other) {
+    slabs.insert(slabs.end(), other.slabs.begin(), other.slabs.end());
+    splice(free_leaves, other.free_leaves);
+    splice(free_internals, other.free_internals);
+    live_leaves += other.live_leaves;
+    live_internals += other.live_internals;
+    other.slabs.clear();
+    other.cur = other.end = nullptr;
+    other.live_leaves = other.live_internals = 0;
+  }
+
+  // devuelve todos los slabs al upstream. Las keys (y valores) de los nodos
+  // vivos deben haberse destruido antes si no son trivialmente destructibles.
+  void release() {
+    for (const Slab& s : slabs) upstream->deallocate(s.ptr, s.bytes, s.align);
+    slabs.clear();
+    cur = end = nullptr;
+    free_leaves = free_internals = nullptr;
+    live_leaves = live_internals = 0;
+  }
+
+  size_t live_nodes() const { return live_leaves + live_internals; }
+  size_t live_leaf_nodes() const { return live_leaves; }
+  size_t live_internal_nodes() const { return live_internals; }
+  size_t slab_count() const { return slabs.size(); }
+  size_t bytes_reserved() const { return slabs.size() * slab_bytes; }
+  // bytes ocupados por los nodos vivos
+  size_t bytes_used() const { return live_leaves * leaf_bytes + live_internals * internal_bytes; }
+  pmr::memory_resource* resource() const { return upstream; }
+  bool uses_huge_pages() const { return huge_pages; }
+  size_t leaf_node_bytes() const { return leaf_bytes; }
+  size_t internal_node_bytes() const { return internal_bytes; }
+
+ private:
+  static void splice(FreeBlock*& list, FreeBlock*& other) {
+    if (!other) return;
+    FreeBlock* last = other;
+    while (last->next) last = last->next;
+    last->next = list;
+    list = other;
+    other = nullptr;
+  }
+
+  char* take(FreeBlock*& list, size_t bytes) {
+    if (list) {
+      char* mem = reinterpret_cast<char*>(list);
+      list = list->next;
+      return mem;
+    }
+    if (cur == nullptr || static_cast<size_t>(end - cur) < bytes) grow();
+    char* mem = cur;
+    cur += bytes;
+    return mem;
+  }
+
+  void grow() {
+    size_t align = huge_pages ? kHugePageBytes : (kAlign > 64 ? kAlign : 64);
+    void* ptr = upstream->allocate(slab_bytes, align);
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+    if (huge_pages) madvise(ptr, slab_bytes, MADV_HUGEPAGE);
+#endif
+    slabs.push_back({ptr, slab_bytes, align});
+    cur = static_cast<char*>(ptr);
+    end = cur + slab_bytes;
+  }
+};
+
+#endif
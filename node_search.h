@@ -0,0 +1,153 @@
+#ifndef NODE_SEARCH_H
+#define NODE_SEARCH_H
+#include <cstdint>
+#include <functional>
+#include <type_traits>
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+using namespace std;
+
+// Busqueda dentro de un nodo compartida por search/insert/remove.
+// NodeSearch<TK>::lower_bound(keys, count, key) devuelve el primer indice i
+// con !(keys[i] < key), es decir, el hijo por el que se debe descender
+// (o la posicion de key si keys[i] == key).
+//
+// El kernel se elige en tiempo de compilacion segun el tipo de la key:
+//  - int32/int64 con signo, float y double: acotamiento sin saltos hasta un
+//    bloque pequeño y luego conteo con comparacion SIMD + movemask.
+//  - otros tipos aritmeticos: acotamiento y conteo escalar sin saltos.
+//  - el resto (string, tipos compuestos...): busqueda binaria generica.
+
+enum class NodeSearchKind { Generic, Branchless, Simd };
+
+template <typename TK>
+struct node_search_kind {
+  static constexpr NodeSearchKind value =
+      (is_floating_point<TK>::value && (sizeof(TK) == 4 || sizeof(TK) == 8)) ||
+              (is_integral<TK>::value && is_signed<TK>::value && (sizeof(TK) == 4 || sizeof(TK) == 8))
+          ? NodeSearchKind::Simd
+          : is_arithmetic<TK>::value ? NodeSearchKind::Branchless : NodeSearchKind::Generic;
+};
+
+// cuenta las keys de [keys, keys + len) menores que key (version escalar)
+template <typename TK>
+inline int count_less_scalar(const TK* keys, int len, const TK& key) {
+  int c = 0;
+  for (int i = 0; i < len; ++i) c += keys[i] < key;
+  return c;
+}
+
+// conteo vectorizado: una comparacion por registro y popcount del movemask
+template <typename TK>
+inline int count_less_simd(const TK* keys, int len, TK key) {
+  int c = 0, i = 0;
+#if defined(__AVX2__)
+  if constexpr (is_same<TK, float>::value) {
+    __m256 k = _mm256_set1_ps(key);
+    for (; i + 8 <= len; i += 8)
+      c += __builtin_popcount(_mm256_movemask_ps(_mm256_cmp_ps(_mm256_loadu_ps(keys + i), k, _CMP_LT_OQ)));
+  } else if constexpr (is_same<TK, double>::value) {
+    __m256d k = _mm256_set1_pd(key);
+    for (; i + 4 <= len; i += 4)
+      c += __builtin_popcount(_mm256_movemask_pd(_mm256_cmp_pd(_mm256_loadu_pd(keys + i), k, _CMP_LT_OQ)));
+  } else if constexpr (sizeof(TK) == 4) {
+    __m256i k = _mm256_set1_epi32(key);
+    for (; i + 8 <= len; i += 8) {
+      __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(keys + i));
+      c += __builtin_popcount(_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(k, v))));
+    }
+  } else {
+    __m256i k = _mm256_set1_epi64x(key);
+    for (; i + 4 <= len; i += 4) {
+      __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(keys + i));
+      c += __builtin_popcount(_mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpgt_epi64(k, v))));
+    }
+  }
+#elif defined(__SSE2__)
+  if constexpr (is_same<TK, float>::value) {
+    __m128 k = _mm_set1_ps(key);
+    for (; i + 4 <= len; i += 4)
+      c += __builtin_popcount(_mm_movemask_ps(_mm_cmplt_ps(_mm_loadu_ps(keys + i), k)));
+  } else if constexpr (is_same<TK, double>::value) {
+    __m128d k = _mm_set1_pd(key);
+    for (; i + 2 <= len; i += 2)
+      c += __builtin_popcount(_mm_movemask_pd(_mm_cmplt_pd(_mm_loadu_pd(keys + i), k)));
+  } else if constexpr (sizeof(TK) == 4) {
+    __m128i k = _mm_set1_epi32(key);
+    for (; i + 4 <= len; i += 4) {
+      __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(keys + i));
+      c += __builtin_popcount(_mm_movemask_ps(_mm_castsi128_ps(_mm_cmplt_epi32(v, k))));
+    }
+  }
+  // int64 sin SSE4.2 no tiene comparacion vectorial: cae al conteo escalar
+#endif
+  return c + count_less_scalar(keys + i, len - i, key);
+}
+
+template <typename TK, NodeSearchKind Kind = node_search_kind<TK>::value>
+struct NodeSearch {
+  static int lower_bound(const TK* keys, int count, const TK& key) {
+    int left = 0, right = count;
+    while (left < right) {
+      int mid = left + (right - left) / 2;
+      if (keys[mid] < key)
+        left = mid + 1;
+      else
+        right = mid;
+    }
+    return left;
+  }
+};
+
+template <typename TK, NodeSearchKind Kind>
+struct NodeSearchBranchless {
+  // tamaño del bloque final que se resuelve por conteo (dos lineas de cache)
+  static constexpr int kBlock = 128 / sizeof(TK);
+
+  static int lower_bound(const TK* keys, int count, const TK& key) {
+    const TK* base = keys;
+    int len = count;
+    while (len > kBlock) {
+      int half = len / 2;
+      base = (base[half] < key) ? base + half : base;
+      len -= half;
+    }
+    int c = (Kind == NodeSearchKind::Simd) ? count_less_simd(base, len, key) : count_less_scalar(base, len, key);
+    return static_cast<int>(base - keys) + c;
+  }
+};
+
+template <typename TK>
+struct NodeSearch<TK, NodeSearchKind::Branchless> : NodeSearchBranchless<TK, NodeSearchKind::Branchless> {};
+
+template <typename TK>
+struct NodeSearch<TK, NodeSearchKind::Simd> : NodeSearchBranchless<TK, NodeSearchKind::Simd> {};
+
+template <typename TK>
+inline int node_lower_bound(const TK* keys, int count, const TK& key) {
+  return NodeSearch<TK>::lower_bound(keys, count, key);
+}
+
+// con comparador: los kernels de arriba solo valen para el orden natural
+// (std::less<TK> o std::less<>) con una key del mismo tipo; cualquier otro
+// orden, o una key de otro tipo (busqueda heterogenea), usa binaria con comp
+template <typename TK, typename K, typename Compare>
+inline int node_lower_bound(const TK* keys, int count, const K& key, const Compare& comp) {
+  if constexpr (is_same<K, TK>::value && (is_same<Compare, less<TK>>::value || is_same<Compare, less<>>::value)) {
+    return NodeSearch<TK>::lower_bound(keys, count, key);
+  } else {
+    int left = 0, right = count;
+    while (left < right) {
+      int mid = left + (right - left) / 2;
+      if (comp(keys[mid], key))
+        left = mid + 1;
+      else
+        right = mid;
+    }
+    return left;
+  }
+}
+
+#endif
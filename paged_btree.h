@@ -0,0 +1,560 @@
+#ifndef PAGED_BTREE_H
+#define PAGED_BTREE_H
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+#include "buffer_pool.h"
+#include "node_search.h"
+using namespace std;
+
+// Arbol B en disco: cada nodo es una pagina de tamaño fijo de un archivo,
+// identificada por su numero de pagina, y se accede a traves de un
+// BufferPool (CLOCK, pin/unpin, escritura diferida de paginas sucias).
+// Los algoritmos son los de BTree (split al llegar a M keys, sucesor,
+// borrow y merge); solo cambian los punteros por numeros de pagina.
+//
+// Pagina 0: metadatos. Nodo: {int32 count, int32 leaf}, M keys (una de
+// sobra para el split) y M + 1 hijos uint64. M es el mayor orden que entra
+// en la pagina para sizeof(TK). Las paginas liberadas forman una lista
+// (el primer uint64 apunta a la siguiente). flush() (y el destructor)
+// escriben las paginas sucias y los metadatos; no es a prueba de caidas a
+// mitad de una operacion. No es thread-safe.
+template <typename TK>
+class PagedBTree {
+  //La implementación de este BTree no soporta valores repetidos
+  static_assert(is_trivially_copyable<TK>::value, "PagedBTree requiere keys trivialmente copiables");
+
+ public:
+  using page_id = BufferPool::page_id;
+  static constexpr page_id kNoPage = 0;  // la pagina 0 son los metadatos
+
+ private:
+  struct Meta {
+    char magic[8];
+    uint32_t version;
+    uint32_t page_size;
+    uint32_t key_size;
+    int32_t M;
+    uint64_t root;
+    int64_t n;
+    uint64_t page_count;  // paginas del archivo, incluida la 0
+    uint64_t free_head;   // primera pagina libre (kNoPage si no hay)
+  };
+
+  static constexpr char kMagic[8] = {'B', 'T', 'R', 'E', 'E', 'P', 'G', 'S'};
+  static constexpr uint32_t kVersion = 1;
+  static constexpr size_t kHeaderBytes = 2 * sizeof(int32_t);
+
+  int fd;
+  size_t page_size;
+  int M;  // grado u orden del arbol, derivado de page_size y sizeof(TK)
+  size_t keys_offset;
+  size_t children_offset;
+  Meta meta;
+  unique_ptr<BufferPool> pool;
+
+  // nodo fijado en el pool mientras vive el objeto
+  class PinnedNode {
+    BufferPool* pool;
+    page_id id;
+    char* data;
+    const PagedBTree* tree;
+    bool dirty;
+
+   public:
+    PinnedNode(const PagedBTree* _tree, page_id _id, bool fresh)
+        : pool(_tree->pool.get()), id(_id), data(nullptr), tree(_tree), dirty(fresh) {
+      data = fresh ? pool->pin_new(id) : pool->pin(id);
+    }
+    PinnedNode(const PinnedNode&) = delete;
+    PinnedNode& operator=(const PinnedNode&) = delete;
+    ~PinnedNode() { pool->unpin(id, dirty); }
+
+    page_id page() const { return id; }
+    int& count() { return *reinterpret_cast<int32_t*>(data); }
+    bool leaf() const { return reinterpret_cast<const int32_t*>(data)[1] != 0; }
+    void set_leaf(bool leaf) { reinterpret_cast<int32_t*>(data)[1] = leaf ? 1 : 0; }
+    TK* keys() { return reinterpret_cast<TK*>(data + tree->keys_offset); }
+    page_id* children() { return reinterpret_cast<page_id*>(data + tree->children_offset); }
+    // toda modificacion debe marcar la pagina
+    void touch() { dirty = true; }
+  };
+
+ public:
+  // abre el archivo del arbol o lo crea vacio. pool_pages: marcos del buffer
+  // pool (al menos 16: las operaciones fijan el camino y los hermanos)
+  PagedBTree(const string& path, size_t pool_pages, size_t _page_size = 4096)
+      : fd(-1), page_size(_page_size), M(0), keys_offset(0), children_offset(0), meta() {
+    if (pool_pages < 16) throw std::invalid_argument("El buffer pool necesita al menos 16 paginas");
+    fd = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+    if (fd < 0) throw runtime_error("No se pudo abrir " + path);
+    try {
+      off_t size = lseek(fd, 0, SEEK_END);
+      if (size > 0) {
+        read_meta();
+        page_size = meta.page_size;
+      }
+      M = order_for(page_size);
+      if (M < 3) throw std::invalid_argument("La pagina es muy chica para este tipo de key");
+      keys_offset = align_up(kHeaderBytes, alignof(TK));
+      children_offset = align_up(keys_offset + sizeof(TK) * M, alignof(page_id));
+      if (size == 0) {
+        memcpy(meta.magic, kMagic, sizeof(kMagic));
+        meta.version = kVersion;
+        meta.page_size = static_cast<uint32_t>(page_size);
+        meta.key_size = sizeof(TK);
+        meta.M = M;
+        meta.root = kNoPage;
+        meta.n = 0;
+        meta.page_count = 1;
+        meta.free_head = kNoPage;
+        write_meta();
+      } else if (meta.M != M) {
+        throw runtime_error("Archivo de arbol corrupto");
+      }
+      pool.reset(new BufferPool(fd, page_size, pool_pages));
+    } catch (...) {
+      ::close(fd);
+      throw;
+    }
+  }
+
+  PagedBTree(const PagedBTree&) = delete;
+  PagedBTree& operator=(const PagedBTree&) = delete;
+
+  ~PagedBTree() {
+    try {
+      flush();
+    } catch (...) {
+    }
+    pool.reset();
+    ::close(fd);
+  }
+
+  // mayor M tal que M keys y M + 1 hijos entran en una pagina
+  static int order_for(size_t page_size) {
+    int m = 0;
+    while (align_up(align_up(kHeaderBytes, alignof(TK)) + sizeof(TK) * (m + 1), alignof(page_id)) +
+               sizeof(page_id) * (m + 2) <=
+           page_size)
+      m++;
+    return m;
+  }
+
+  //indica si se encuentra o no un elemento
+  bool search(TK key) {
+    for (page_id id = meta.root; id != kNoPage;) {
+      PinnedNode x(this, id, false);
+      int pos = node_lower_bound(x.keys(), x.count(), key);
+      if (pos < x.count() && x.keys()[pos] == key) return true;
+      id = x.leaf() ? kNoPage : x.children()[pos];
+    }
+    return false;
+  }
+
+  // true si la key no estaba
+  bool insert(TK key) {
+    //caso1: arbol sin raiz
+    if (meta.root == kNoPage) {
+      page_id id = allocate_page();
+      PinnedNode r(this, id, true);
+      r.set_leaf(true);
+      r.keys()[0] = key;
+      r.count() = 1;
+      meta.root = id;
+      meta.n = 1;
+      return true;
+    }
+
+    //caso2: insertar normalmente
+    bool inserted = false;
+    TK promoted_key;
+    page_id new_child = insert_rec(meta.root, key, promoted_key, inserted);
+    if (inserted) meta.n++;
+    if (new_child == kNoPage) return inserted;
+
+    //caso3: split en la raiz
+    page_id id = allocate_page();
+    PinnedNode r(this, id, true);
+    r.set_leaf(false);
+    r.keys()[0] = promoted_key;
+    r.count() = 1;
+    r.children()[0] = meta.root;
+    r.children()[1] = new_child;
+    meta.root = id;
+    return true;
+  }
+
+  // true si la key estaba
+  bool remove(TK key) {
+    if (meta.root == kNoPage || !remove_rec(meta.root, key)) return false;
+    meta.n--;
+    page_id old_root = meta.root;
+    bool empty_leaf = false;
+    {
+      PinnedNode r(this, old_root, false);
+      // Si la raíz quedó vacía pero tiene un hijo, promoverlo
+      if (r.count() == 0 && !r.leaf()) meta.root = r.children()[0];
+      empty_leaf = r.count() == 0 && r.leaf();
+    }
+    if (meta.root != old_root) free_page(old_root);
+    // Si el árbol quedó completamente vacío
+    if (empty_leaf) {
+      free_page(old_root);
+      meta.root = kNoPage;
+    }
+    return true;
+  }
+
+  vector<TK> rangeSearch(TK begin, TK end) {
+    vector<TK> out;
+    if (end < begin) std::swap(begin, end);
+    if (meta.root != kNoPage) range_search_rec(meta.root, begin, end, out);
+    return out;
+  }
+
+  // mínimo valor del árbol
+  TK minKey() {
+    if (meta.root == kNoPage) throw runtime_error("El árbol está vacío");
+    page_id id = meta.root;
+    while (true) {
+      PinnedNode x(this, id, false);
+      if (x.leaf()) return x.keys()[0];
+      id = x.children()[0];
+    }
+  }
+
+  // máximo valor del árbol
+  TK maxKey() {
+    if (meta.root == kNoPage) throw runtime_error("El árbol está vacío");
+    page_id id = meta.root;
+    while (true) {
+      PinnedNode x(this, id, false);
+      if (x.leaf()) return x.keys()[x.count() - 1];
+      id = x.children()[x.count()];
+    }
+  }
+
+  //altura del arbol. Considerar altura 0 para arbol vacio
+  int height() {
+    int cont = 0;
+    for (page_id id = meta.root; id != kNoPage; cont++) {
+      PinnedNode x(this, id, false);
+      if (x.leaf()) return cont;
+      id = x.children()[0];
+    }
+    return 0;
+  }
+
+  int size() const { return static_cast<int>(meta.n); }
+  int order() const { return M; }
+  size_t page_bytes() const { return page_size; }
+  size_t page_count() const { return meta.page_count; }
+
+  // escribe las paginas sucias y los metadatos
+  void flush() {
+    pool->flush_all();
+    write_meta();
+    if (::fsync(fd) != 0) throw runtime_error("Error en fsync del arbol");
+  }
+
+  const BufferPool::Stats& statistics() const { return pool->statistics(); }
+  void reset_statistics() { pool->reset_statistics(); }
+  double hit_rate() const {
+    const BufferPool::Stats& s = pool->statistics();
+    return s.hits + s.misses ? static_cast<double>(s.hits) / (s.hits + s.misses) : 0;
+  }
+
+  // Verifique las propiedades de un árbol B
+  bool check_properties() {
+    if (meta.root == kNoPage) return meta.n == 0;
+    int leaf_level = -1;
+    bool has_prev = false;
+    TK prev{};
+    long long total = 0;
+    return check(meta.root, true, 1, leaf_level, has_prev, prev, total) && total == meta.n;
+  }
+
+ private:
+  static constexpr size_t align_up(size_t x, size_t a) { return (x + a - 1) / a * a; }
+
+  void read_meta() {
+    if (pread(fd, &meta, sizeof(meta), 0) != static_cast<ssize_t>(sizeof(meta)))
+      throw runtime_error("Archivo de arbol truncado");
+    if (memcmp(meta.magic, kMagic, sizeof(kMagic)) != 0 || meta.version != kVersion)
+      throw runtime_error("No es un archivo de PagedBTree");
+    if (meta.key_size != sizeof(TK)) throw runtime_error("El tamaño de key del archivo no coincide");
+  }
+
+  void write_meta() {
+    if (pwrite(fd, &meta, sizeof(meta), 0) != static_cast<ssize_t>(sizeof(meta)))
+      throw runtime_error("Error escribiendo los metadatos");
+  }
+
+  // paginas: primero las de la lista libre, si no se agranda el archivo
+  page_id allocate_page() {
+    if (meta.free_head != kNoPage) {
+      page_id id = meta.free_head;
+      char* data = pool->pin(id);
+      memcpy(&meta.free_head, data, sizeof(page_id));
+      pool->unpin(id, false);
+      return id;
+    }
+    return meta.page_count++;
+  }
+
+  void free_page(page_id id) {
+    char* data = pool->pin(id);
+    memcpy(data, &meta.free_head, sizeof(page_id));
+    pool->unpin(id, true);
+    meta.free_head = id;
+  }
+
+  // metodos para la insercion
+  page_id split(PinnedNode& node, TK& promoted_key) {
+    int mid_idx = M / 2;
+    promoted_key = node.keys()[mid_idx];
+
+    // partir a la mitad el nodo actual
+    PinnedNode right(this, allocate_page(), true);
+    right.set_leaf(node.leaf());
+    int j = 0;
+    for (int i = mid_idx + 1; i < node.count(); i++) right.keys()[j++] = node.keys()[i];
+    right.count() = j;
+
+    // organizar los hijos si no es hoja
+    if (!node.leaf()) {
+      for (int i = mid_idx + 1, k = 0; i <= node.count(); i++, k++) right.children()[k] = node.children()[i];
+    }
+    node.count() = mid_idx;
+    node.touch();
+    return right.page();  // se retorna la key que sube y el nodo partido
+  }
+
+  page_id insert_rec(page_id id, const TK& key, TK& promoted_key, bool& inserted) {
+    PinnedNode node(this, id, false);
+    //indice del primer key >= key
+    int child_idx = node_lower_bound(node.keys(), node.count(), key);
+    if (child_idx < node.count() && node.keys()[child_idx] == key) return kNoPage;  // llave duplicada
+
+    if (node.leaf()) {
+      // insertar en hoja desplazando las keys
+      for (int i = node.count(); i > child_idx; i--) node.keys()[i] = node.keys()[i - 1];
+      node.keys()[child_idx] = key;
+      node.count()++;
+      node.touch();
+      inserted = true;
+
+      //split en hoja
+      if (node.count() == M) return split(node, promoted_key);
+      return kNoPage;
+    }
+
+    // nodo interno = descender recursivamente
+    TK child_promoted_key;
+    page_id new_child = insert_rec(node.children()[child_idx], key, child_promoted_key, inserted);
+    if (new_child == kNoPage) return kNoPage;  // sin split
+
+    // hubo split, insertar la clave promovida en padre
+    for (int i = node.count(); i > child_idx; i--) {
+      node.keys()[i] = node.keys()[i - 1];
+      node.children()[i + 1] = node.children()[i];
+    }
+    node.keys()[child_idx] = child_promoted_key;
+    node.children()[child_idx + 1] = new_child;
+    node.count()++;
+    node.touch();
+
+    // split en padre
+    if (node.count() == M) return split(node, promoted_key);
+    return kNoPage;
+  }
+
+  // metodos para la eliminacion
+  bool remove_rec(page_id id, TK key) {
+    int min_keys = (M + 1) / 2 - 1;
+    PinnedNode node(this, id, false);
+
+    // buscar la posición (o el hijo por el que descender)
+    int child_idx = node_lower_bound(node.keys(), node.count(), key);
+    bool here = child_idx < node.count() && node.keys()[child_idx] == key;
+
+    if (node.leaf()) {
+      if (!here) return false;  // Key no encontrada
+      for (int i = child_idx; i < node.count() - 1; i++) node.keys()[i] = node.keys()[i + 1];
+      node.count()--;
+      node.touch();
+      return true;
+    }
+
+    //caso3: key en nodo interno, reemplazar con sucesor
+    if (here) {
+      TK successor = min_of(node.children()[child_idx + 1]);
+      node.keys()[child_idx] = successor;
+      node.touch();
+      key = successor;  // eliminar sucesor del hijo derecho
+      child_idx++;
+    }
+
+    //nodo interno: descender al hijo apropiado
+    if (!remove_rec(node.children()[child_idx], key)) return false;
+
+    // si el hijo quedó con menos del mínimo
+    bool underflow;
+    {
+      PinnedNode child(this, node.children()[child_idx], false);
+      underflow = child.count() < min_keys;
+    }
+    if (underflow) {
+      page_id gone = fix_child(node, child_idx);
+      if (gone != kNoPage) free_page(gone);
+    }
+    return true;
+  }
+
+  TK min_of(page_id id) {
+    while (true) {
+      PinnedNode x(this, id, false);
+      if (x.leaf()) return x.keys()[0];
+      id = x.children()[0];
+    }
+  }
+
+  // arreglar un hijo que quedó con menos del mínimo. Si hubo merge retorna la
+  // pagina vaciada, para liberarla cuando ya no esta fijada
+  page_id fix_child(PinnedNode& parent, int child_idx) {
+    int min_keys = (M + 1) / 2 - 1;
+    PinnedNode child(this, parent.children()[child_idx], false);
+
+    //caso1: intentar borrow de hermano izquierdo
+    if (child_idx > 0) {
+      PinnedNode left(this, parent.children()[child_idx - 1], false);
+      if (left.count() > min_keys) {
+        borrow_from_left(parent, child_idx, child, left);
+        return kNoPage;
+      }
+    }
+
+    //  caso2: intentar borrow de hermano derecho
+    if (child_idx < parent.count()) {
+      PinnedNode right(this, parent.children()[child_idx + 1], false);
+      if (right.count() > min_keys) {
+        borrow_from_right(parent, child_idx, child, right);
+        return kNoPage;
+      }
+    }
+
+    //caso3 : merge con hermano
+    if (child_idx > 0) {
+      PinnedNode left(this, parent.children()[child_idx - 1], false);
+      merge(parent, child_idx - 1, left, child);
+      return child.page();
+    }
+    PinnedNode right(this, parent.children()[child_idx + 1], false);
+    merge(parent, child_idx, child, right);
+    return right.page();
+  }
+
+  // Rotar: tomar una key del hermano izquierdo
+  void borrow_from_left(PinnedNode& parent, int child_idx, PinnedNode& child, PinnedNode& left) {
+    for (int i = child.count(); i > 0; i--) child.keys()[i] = child.keys()[i - 1];
+    if (!child.leaf()) {
+      for (int i = child.count() + 1; i > 0; i--) child.children()[i] = child.children()[i - 1];
+      child.children()[0] = left.children()[left.count()];
+    }
+    child.keys()[0] = parent.keys()[child_idx - 1];
+    child.count()++;
+    parent.keys()[child_idx - 1] = left.keys()[left.count() - 1];
+    left.count()--;
+    parent.touch();
+    child.touch();
+    left.touch();
+  }
+
+  void borrow_from_right(PinnedNode& parent, int child_idx, PinnedNode& child, PinnedNode& right) {
+    child.keys()[child.count()] = parent.keys()[child_idx];
+    child.count()++;
+    parent.keys()[child_idx] = right.keys()[0];
+    if (!child.leaf()) child.children()[child.count()] = right.children()[0];
+    for (int i = 0; i < right.count() - 1; i++) right.keys()[i] = right.keys()[i + 1];
+    if (!right.leaf()) {
+      for (int i = 0; i < right.count(); i++) right.children()[i] = right.children()[i + 1];
+    }
+    right.count()--;
+    parent.touch();
+    child.touch();
+    right.touch();
+  }
+
+  // fusionar children[idx + 1] (right) dentro de children[idx] (left)
+  void merge(PinnedNode& parent, int idx, PinnedNode& left, PinnedNode& right) {
+    left.keys()[left.count()++] = parent.keys()[idx];
+    int base = left.count();
+    for (int i = 0; i < right.count(); i++) left.keys()[left.count()++] = right.keys()[i];
+    if (!left.leaf()) {
+      for (int i = 0; i <= right.count(); i++) left.children()[base + i] = right.children()[i];
+    }
+    for (int i = idx; i < parent.count() - 1; i++) parent.keys()[i] = parent.keys()[i + 1];
+    for (int i = idx + 1; i < parent.count(); i++) parent.children()[i] = parent.children()[i + 1];
+    parent.count()--;
+    parent.touch();
+    left.touch();
+  }
+
+  void range_search_rec(page_id id, const TK& a, const TK& b, vector<TK>& out) {
+    PinnedNode x(this, id, false);
+    int count = x.count();
+    int i = node_lower_bound(x.keys(), count, a);
+    if (x.leaf()) {
+      for (; i < count && !(b < x.keys()[i]); ++i) out.push_back(x.keys()[i]);
+      return;
+    }
+    // saltar los hijos que quedan completamente a la izquierda de a
+    for (; i < count; ++i) {
+      range_search_rec(x.children()[i], a, b, out);
+      if (b < x.keys()[i]) return;
+      out.push_back(x.keys()[i]);
+    }
+    range_search_rec(x.children()[count], a, b, out);
+  }
+
+  bool check(page_id id, bool is_root, int depth, int& leaf_level, bool& has_prev, TK& prev, long long& total) {
+    int min_keys = (M + 1) / 2 - 1;
+    PinnedNode x(this, id, false);
+    if (x.count() > M - 1 || (is_root ? x.count() < 1 : x.count() < min_keys)) return false;
+    total += x.count();
+
+    if (x.leaf()) {
+      if (leaf_level == -1)
+        leaf_level = depth;
+      else if (leaf_level != depth)
+        return false;
+      for (int i = 0; i < x.count(); ++i) {
+        if (has_prev && !(prev < x.keys()[i])) return false;
+        prev = x.keys()[i];
+        has_prev = true;
+      }
+      return true;
+    }
+
+    for (int i = 0; i <= x.count(); ++i) {
+      if (!check(x.children()[i], false, depth + 1, leaf_level, has_prev, prev, total)) return false;
+      if (i < x.count()) {
+        if (has_prev && !(prev < x.keys()[i])) return false;
+        prev = x.keys()[i];
+        has_prev = true;
+      }
+    }
+    return true;
+  }
+};
+
+#endif
@@ -0,0 +1,87 @@
+#ifndef PARALLEL_SORT_H
+#define PARALLEL_SORT_H
+#include <algorithm>
+#include <functional>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+using namespace std;
+
+// Ordenamiento en el lugar usado por BTree::build_from_unsorted.
+// El vector se parte en un bloque por hilo; cada bloque se ordena por
+// separado (radix LSD para enteros, std::sort para el resto) y despues los
+// bloques se mezclan de a pares, tambien en paralelo.
+
+// clave sin signo cuyo orden coincide con el de la key entera
+template <typename TK>
+inline auto radix_key(TK key) {
+  using U = make_unsigned_t<TK>;
+  U u = static_cast<U>(key);
+  if constexpr (is_signed<TK>::value) u ^= U(1) << (sizeof(TK) * 8 - 1);
+  return u;
+}
+
+// radix LSD de 8 bits por pasada; se salta las pasadas en que todas las keys
+// comparten el digito
+template <typename TK>
+void radix_sort(TK* first, TK* last) {
+  size_t size = static_cast<size_t>(last - first);
+  if (size < 256) {
+    std::sort(first, last);
+    return;
+  }
+  vector<TK> buffer(size);
+  TK* src = first;
+  TK* dst = buffer.data();
+  for (size_t shift = 0; shift < sizeof(TK) * 8; shift += 8) {
+    size_t counts[257] = {};
+    for (size_t i = 0; i < size; ++i) counts[((radix_key(src[i]) >> shift) & 0xff) + 1]++;
+    if (std::any_of(counts + 1, counts + 257, [&](size_t c) { return c == size; })) continue;
+    for (int d = 0; d < 256; ++d) counts[d + 1] += counts[d];
+    for (size_t i = 0; i < size; ++i) dst[counts[(radix_key(src[i]) >> shift) & 0xff]++] = src[i];
+    std::swap(src, dst);
+  }
+  if (src != first) std::copy(src, src + size, first);
+}
+
+// radix solo para enteros en orden natural; otro Compare usa std::sort
+template <typename TK, typename Compare>
+void sort_block(TK* first, TK* last, Compare comp) {
+  if constexpr (is_integral<TK>::value && !is_same<TK, bool>::value &&
+                (is_same<Compare, less<TK>>::value || is_same<Compare, less<>>::value))
+    radix_sort(first, last);
+  else
+    std::sort(first, last, comp);
+}
+
+template <typename TK, typename Compare = less<TK>>
+void parallel_sort(vector<TK>& v, unsigned threads, Compare comp = Compare()) {
+  size_t size = v.size();
+  if (threads <= 1 || size < (size_t(1) << 16)) {
+    sort_block(v.data(), v.data() + size, comp);
+    return;
+  }
+
+  // limites de los bloques
+  vector<size_t> bounds(threads + 1);
+  for (unsigned t = 0; t <= threads; ++t) bounds[t] = size * t / threads;
+
+  vector<thread> workers;
+  for (unsigned t = 0; t < threads; ++t)
+    workers.emplace_back([&, t] { sort_block(v.data() + bounds[t], v.data() + bounds[t + 1], comp); });
+  for (thread& w : workers) w.join();
+
+  // mezclar bloques vecinos de a pares hasta que quede uno solo
+  for (size_t width = 1; width < threads; width *= 2) {
+    workers.clear();
+    for (size_t b = 0; b + width < threads; b += 2 * width) {
+      size_t lo = bounds[b], mid = bounds[b + width], hi = bounds[std::min<size_t>(b + 2 * width, threads)];
+      workers.emplace_back(
+          [&v, lo, mid, hi, comp] { std::inplace_merge(v.begin() + lo, v.begin() + mid, v.begin() + hi, comp); });
+    }
+    for (thread& w : workers) w.join();
+  }
+}
+
+#endif
@@ -0,0 +1,461 @@
+#ifndef SHARDED_BTREE_H
+#define SHARDED_BTREE_H
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <stdexcept>
+#include <system_error>
+#include <thread>
+#include <vector>
+#include "btree.h"
+using namespace std;
+
+// Arbol particionado por rangos de keys en shards independientes.
+// El shard i guarda las keys en [splitters[i - 1], splitters[i]); cada uno es
+// un BTree con su propio lock y su propio NodePool, asi inserciones en rangos
+// distintos no se bloquean entre si ni comparten la raiz.
+//
+// Los shards se crean todos al construir. Sin splitters iniciales las keys
+// van al shard 0 hasta juntar kSeedKeys por shard, y con esa primera tanda
+// se fijan los splitters por cuantiles (una sola vez, sobre pocas keys).
+// Despues, si un shard crece mas de kSkew veces el promedio, se mudan keys
+// entre los dos vecinos con mas diferencia hasta emparejarlos: solo esos dos
+// shards se bloquean mientras se copian sus keys, y el lock de layout se
+// toma exclusivo nada mas que para escribir el splitter que los separa. Con
+// keys siempre crecientes las keys sobrantes del ultimo shard van pasando a
+// los anteriores de a un vecino por vez, sin pausas globales.
+//
+// Las operaciones de una key leen los splitters con el lock de layout,
+// lo sueltan, toman el lock del shard y verifican que la key siga en sus
+// limites (una mudanza pudo correrlos en el medio); si no, vuelven a buscar.
+// Con el lock de un shard tomado sus dos splitters no cambian. Las
+// operaciones globales (rangeSearch, minKey/maxKey, for_each) recorren los
+// shards en orden tomando el lock del siguiente antes de soltar el anterior,
+// asi una mudanza queda entera antes o despues del recorrido; aun asi no son
+// una foto atomica de todo el arbol si hay escritores concurrentes.
+template <typename TK>
+class ShardedBTree {
+  //La implementación de este BTree no soporta valores repetidos
+  struct Shard {
+    shared_mutex mtx;
+    unique_ptr<BTree<TK>> tree;
+    atomic<int> count{0};
+  };
+
+  // un shard se considera desbalanceado con kSkew veces el promedio
+  static constexpr int kSkew = 2;
+  // no se rebalancea por debajo de este promedio de keys por shard
+  static constexpr int kMinShardKeys = 4096;
+  // keys por shard de la primera tanda, de la que salen los splitters
+  static constexpr int kSeedKeys = 1024;
+  // cada cuantas escrituras se mira el desbalance
+  static constexpr unsigned kCheckEvery = 1024;
+
+  int M;  // grado u orden de cada shard
+  // protege la lectura de splitters para ubicar una key; se toma exclusivo
+  // (despues de los locks de los shards involucrados) al escribirlos
+  mutable shared_mutex layout;
+  vector<TK> splitters;  // siempre shards.size() - 1
+  vector<unique_ptr<Shard>> shards;  // fijo desde la construccion
+  atomic<bool> seeded{false};  // splitters ya calculados
+  atomic<unsigned> writes{0};
+  atomic<int> rebalances{0};
+
+ public:
+  class iterator;
+
+  // sin limites conocidos: los splitters salen de las primeras keys
+  ShardedBTree(int _M, unsigned _shards) : M(_M) {
+    if (_shards == 0) throw std::invalid_argument("Se necesita al menos un shard");
+    splitters.resize(_shards - 1);
+    for (unsigned i = 0; i < _shards; ++i) shards.push_back(make_shard(new BTree<TK>(M)));
+    seeded = _shards == 1;
+  }
+
+  // limites iniciales conocidos: splitters.size() + 1 shards desde el inicio
+  ShardedBTree(int _M, vector<TK> _splitters) : M(_M), splitters(std::move(_splitters)) {
+    for (size_t i = 1; i < splitters.size(); ++i)
+      if (!(splitters[i - 1] < splitters[i]))
+        throw std::invalid_argument("Los splitters deben estar estrictamente ordenados");
+    for (size_t i = 0; i <= splitters.size(); ++i) shards.push_back(make_shard(new BTree<TK>(M)));
+    seeded = true;
+  }
+
+  ShardedBTree(const ShardedBTree&) = delete;
+  ShardedBTree& operator=(const ShardedBTree&) = delete;
+
+  //indica si se encuentra o no un elemento
+  bool search(TK key) const {
+    shared_lock<shared_mutex> sl;
+    Shard& s = *shards[lock_owner(key, sl)];
+    return s.tree->search(key);
+  }
+
+  // true si la key no estaba
+  bool insert(TK key) {
+    bool inserted;
+    {
+      unique_lock<shared_mutex> sl;
+      Shard& s = *shards[lock_owner(key, sl)];
+      int before = s.tree->size();
+      s.tree->insert(key);
+      inserted = s.tree->size() != before;
+      if (inserted) s.count.fetch_add(1, memory_order_relaxed);
+    }
+    after_write();
+    return inserted;
+  }
+
+  // true si la key estaba
+  bool remove(TK key) {
+    bool removed;
+    {
+      unique_lock<shared_mutex> sl;
+      Shard& s = *shards[lock_owner(key, sl)];
+      int before = s.tree->size();
+      s.tree->remove(key);
+      removed = s.tree->size() != before;
+      if (removed) s.count.fetch_sub(1, memory_order_relaxed);
+    }
+    after_write();
+    return removed;
+  }
+
+  vector<TK> rangeSearch(TK begin, TK end) const {
+    if (end < begin) std::swap(begin, end);
+    vector<TK> out;
+    shared_lock<shared_mutex> sl;
+    size_t first = lock_owner(begin, sl);
+    scan(first, std::move(sl), [&](size_t i, BTree<TK>& t) {
+      vector<TK> part = t.rangeSearch(begin, end);
+      out.insert(out.end(), part.begin(), part.end());
+      // el siguiente shard empieza en splitters[i]
+      return seeded && i < splitters.size() && !(end < splitters[i]);
+    });
+    return out;
+  }
+
+  // mínimo valor del árbol
+  TK minKey() const {
+    bool found = false;
+    TK key{};
+    scan(0, shared_lock<shared_mutex>(shards[0]->mtx), [&](size_t, BTree<TK>& t) {
+      if (t.size() > 0) {
+        key = t.minKey();
+        found = true;
+      }
+      return !found;
+    });
+    if (!found) throw runtime_error("El árbol está vacío");
+    return key;
+  }
+
+  // máximo valor del árbol: el del ultimo shard con keys
+  TK maxKey() const {
+    bool found = false;
+    TK key{};
+    scan(0, shared_lock<shared_mutex>(shards[0]->mtx), [&](size_t, BTree<TK>& t) {
+      if (t.size() > 0) {
+        key = t.maxKey();
+        found = true;
+      }
+      return true;
+    });
+    if (!found) throw runtime_error("El árbol está vacío");
+    return key;
+  }
+
+  int size() const {
+    // las mudanzas actualizan los contadores con layout exclusivo
+    shared_lock<shared_mutex> l(layout);
+    int total = 0;
+    for (auto& s : shards) total += s->count.load(memory_order_relaxed);
+    return total;
+  }
+
+  // visita las keys en orden, un shard a la vez bajo su lock compartido
+  template <typename F>
+  void for_each(F f) const {
+    scan(0, shared_lock<shared_mutex>(shards[0]->mtx), [&](size_t, BTree<TK>& t) {
+      for (const TK& key : t) f(key);
+      return true;
+    });
+  }
+
+  // recorrido en orden sin locks: solo con el arbol quieto
+  iterator begin() const { return iterator(this, 0); }
+  iterator end() const { return iterator(this, shards.size()); }
+
+  // recalcula los splitters por cuantiles y reconstruye todos los shards;
+  // bloquea todo el arbol mientras tanto
+  void rebalance() {
+    vector<unique_lock<shared_mutex>> locks = lock_all();
+    unique_lock<shared_mutex> l(layout);
+    vector<TK> keys;
+    for (auto& s : shards) {
+      for (const TK& key : *s->tree) keys.push_back(key);
+    }
+    redistribute_locked(keys);
+  }
+
+  size_t shard_count() const { return shards.size(); }
+
+  // keys por shard, para ver el desbalance
+  vector<int> shard_sizes() const {
+    shared_lock<shared_mutex> l(layout);
+    vector<int> sizes;
+    for (auto& s : shards) sizes.push_back(s->count.load(memory_order_relaxed));
+    return sizes;
+  }
+
+  // rebalanceos completos y mudanzas entre vecinos
+  int rebalance_count() const { return rebalances.load(); }
+
+  // Verifique las propiedades de cada shard y que respete sus limites
+  bool check_properties() const {
+    vector<shared_lock<shared_mutex>> locks;
+    for (auto& s : shards) locks.emplace_back(s->mtx);
+    shared_lock<shared_mutex> l(layout);
+    for (size_t i = 0; i < shards.size(); ++i) {
+      BTree<TK>& t = *shards[i]->tree;
+      if (!t.check_properties() || t.size() != shards[i]->count.load()) return false;
+      if (i > 0 && i < splitters.size() && seeded && splitters[i] < splitters[i - 1]) return false;
+      if (t.size() == 0) continue;
+      if (!owns(i, t.minKey()) || !owns(i, t.maxKey())) return false;
+    }
+    return true;
+  }
+
+  // recorrido en orden que salta de un shard al siguiente
+  class iterator {
+   public:
+    using iterator_category = forward_iterator_tag;
+    using value_type = TK;
+    using difference_type = ptrdiff_t;
+    using pointer = const TK*;
+    using reference = const TK&;
+
+    reference operator*() const { return *it; }
+    pointer operator->() const { return &*it; }
+
+    iterator& operator++() {
+      ++it;
+      skip_empty();
+      return *this;
+    }
+
+    iterator operator++(int) {
+      iterator tmp = *this;
+      ++*this;
+      return tmp;
+    }
+
+    bool operator==(const iterator& other) const {
+      return shard == other.shard && (shard == owner->shards.size() || it == other.it);
+    }
+    bool operator!=(const iterator& other) const { return !(*this == other); }
+
+   private:
+    friend class ShardedBTree;
+    const ShardedBTree* owner;
+    size_t shard;
+    typename BTree<TK>::iterator it;
+
+    iterator(const ShardedBTree* _owner, size_t _shard) : owner(_owner), shard(_shard) {
+      if (shard < owner->shards.size()) {
+        it = owner->shards[shard]->tree->begin();
+        skip_empty();
+      }
+    }
+
+    // pasar al primer shard con keys pendientes
+    void skip_empty() {
+      while (shard < owner->shards.size() && it == owner->shards[shard]->tree->end()) {
+        if (++shard < owner->shards.size()) it = owner->shards[shard]->tree->begin();
+      }
+    }
+  };
+
+ private:
+  static unique_ptr<Shard> make_shard(BTree<TK>* tree) {
+    unique_ptr<Shard> s(new Shard());
+    s->tree.reset(tree);
+    s->count.store(tree->size());
+    return s;
+  }
+
+  // indice del shard de key segun los splitters: cantidad de splitters <= key
+  size_t shard_of(const TK& key) const {
+    shared_lock<shared_mutex> l(layout);
+    if (!seeded) return 0;
+    return static_cast<size_t>(std::upper_bound(splitters.begin(), splitters.end(), key) - splitters.begin());
+  }
+
+  // key cae en los limites del shard i. Con el lock de ese shard tomado no
+  // cambian: una mudanza necesita los locks de los dos shards que separa
+  bool owns(size_t i, const TK& key) const {
+    if (!seeded) return i == 0;
+    return (i == 0 || !(key < splitters[i - 1])) && (i == splitters.size() || key < splitters[i]);
+  }
+
+  // deja en lock el lock (Lock: compartido o exclusivo) del shard de key y
+  // devuelve su indice
+  template <typename Lock>
+  size_t lock_owner(const TK& key, Lock& lock) const {
+    while (true) {
+      size_t i = shard_of(key);
+      Lock l(shards[i]->mtx);
+      if (owns(i, key)) {
+        lock = std::move(l);
+        return i;
+      }
+    }
+  }
+
+  // recorre los shards desde first (cuyo lock compartido viene en l) en
+  // orden, tomando el lock del siguiente antes de soltar el anterior.
+  // visit(i, arbol) devuelve si seguir con el shard i + 1
+  template <typename F>
+  void scan(size_t first, shared_lock<shared_mutex> l, F visit) const {
+    for (size_t i = first; visit(i, *shards[i]->tree) && i + 1 < shards.size(); ++i) {
+      shared_lock<shared_mutex> next(shards[i + 1]->mtx);
+      l = std::move(next);
+    }
+  }
+
+  // todos los shards en exclusivo, en orden (el mismo de las mudanzas)
+  vector<unique_lock<shared_mutex>> lock_all() const {
+    vector<unique_lock<shared_mutex>> locks;
+    for (auto& s : shards) locks.emplace_back(s->mtx);
+    return locks;
+  }
+
+  void after_write() {
+    if (writes.fetch_add(1, memory_order_relaxed) % kCheckEvery != kCheckEvery - 1) return;
+    if (!seeded) {
+      if (shards[0]->count.load(memory_order_relaxed) < kSeedKeys * static_cast<long long>(shards.size())) return;
+      vector<unique_lock<shared_mutex>> locks = lock_all();
+      unique_lock<shared_mutex> l(layout);
+      // otro hilo pudo haberlos fijado mientras se esperaban los locks
+      if (seeded) return;
+      vector<TK> keys(shards[0]->tree->begin(), shards[0]->tree->end());
+      redistribute_locked(keys);
+      return;
+    }
+    balance();
+  }
+
+  // si el shard mas grande supera kSkew veces el promedio, empareja el par
+  // de vecinos con mas diferencia (el desbalance se va corriendo de a un
+  // vecino por vez hacia los shards mas chicos)
+  void balance() {
+    size_t S = shards.size();
+    if (S < 2) return;
+    vector<long long> c(S);
+    long long total = 0, largest = 0;
+    for (size_t i = 0; i < S; ++i) {
+      c[i] = shards[i]->count.load(memory_order_relaxed);
+      total += c[i];
+      largest = std::max(largest, c[i]);
+    }
+    if (total < static_cast<long long>(S) * kMinShardKeys) return;
+    if (largest <= kSkew * total / static_cast<long long>(S)) return;
+    size_t pair = 0;
+    for (size_t i = 1; i + 1 < S; ++i)
+      if (std::abs(c[i] - c[i + 1]) > std::abs(c[pair] - c[pair + 1])) pair = i;
+    move_between(pair);
+  }
+
+  // muda keys entre shards[i] y shards[i + 1] hasta emparejarlos: las mas
+  // grandes de i o las mas chicas de i + 1, que quedan pegadas al borde del
+  // otro y entran por insertSorted. Solo se bloquean esos dos shards mientras
+  // se copian; el splitter nuevo se escribe con layout exclusivo
+  void move_between(size_t i) {
+    unique_lock<shared_mutex> left_lock(shards[i]->mtx);
+    unique_lock<shared_mutex> right_lock(shards[i + 1]->mtx);
+    BTree<TK>& left = *shards[i]->tree;
+    BTree<TK>& right = *shards[i + 1]->tree;
+    bool up = left.size() > right.size();
+    int k = std::abs(left.size() - right.size()) / 2;
+    if (k == 0) return;
+
+    BTree<TK>& from = up ? left : right;
+    BTree<TK>& to = up ? right : left;
+    vector<TK> moved;
+    moved.reserve(k);
+    if (up) {
+      auto it = from.end();
+      for (int j = 0; j < k; ++j) moved.push_back(*--it);
+      std::reverse(moved.begin(), moved.end());
+    } else {
+      auto it = from.begin();
+      for (int j = 0; j < k; ++j, ++it) moved.push_back(*it);
+    }
+    try {
+      to.insertSorted(moved);
+    } catch (...) {
+      // sacar las que hayan entrado: el par queda como estaba
+      for (const TK& key : moved) to.remove(key);
+      throw;
+    }
+    for (const TK& key : moved) from.remove(key);
+
+    unique_lock<shared_mutex> l(layout);
+    splitters[i] = up ? moved.front() : right.minKey();
+    shards[i]->count.store(left.size());
+    shards[i + 1]->count.store(right.size());
+    rebalances.fetch_add(1);
+  }
+
+  // splitters por cuantiles de keys (ordenadas) y los shards reconstruidos
+  // en paralelo con build_from_ordered_vector. Con todos los locks tomados
+  void redistribute_locked(const vector<TK>& keys) {
+    if (keys.empty()) return;
+    // cuantiles: el shard i recibe las keys [i * n / S, (i + 1) * n / S)
+    size_t count = shards.size();
+    vector<size_t> bounds(count + 1);
+    for (size_t i = 0; i <= count; ++i) bounds[i] = keys.size() * i / count;
+    vector<TK> new_splitters;
+    for (size_t i = 1; i < count; ++i) new_splitters.push_back(keys[bounds[i]]);
+
+    // un error en un hilo se guarda y se relanza despues del join, antes de
+    // tocar splitters o shards
+    vector<unique_ptr<BTree<TK>>> trees(count);
+    vector<exception_ptr> errors(count);
+    auto build = [&](size_t i) {
+      try {
+        vector<TK> part(keys.begin() + bounds[i], keys.begin() + bounds[i + 1]);
+        trees[i].reset(BTree<TK>::build_from_ordered_vector(part, M));
+      } catch (...) {
+        errors[i] = current_exception();
+      }
+    };
+    vector<thread> workers;
+    workers.reserve(count);
+    size_t next = 1;
+    try {
+      for (; next < count; ++next) workers.emplace_back(build, next);
+    } catch (const system_error&) {
+      // sin mas hilos: el resto se construye aca
+      for (; next < count; ++next) build(next);
+    }
+    build(0);
+    for (thread& w : workers) w.join();
+    for (exception_ptr& e : errors)
+      if (e) rethrow_exception(e);
+
+    for (size_t i = 0; i < count; ++i) {
+      shards[i]->tree.swap(trees[i]);
+      shards[i]->count.store(shards[i]->tree->size());
+    }
+    splitters.swap(new_splitters);
+    seeded = true;
+    rebalances.fetch_add(1);
+  }
+};
+
+#endif
@@ -0,0 +1,90 @@
+// Prueba de estres de ConcurrentBTree: varios hilos hacen insert, remove,
+// search y rangeSearch sobre el mismo rango chico de keys, con fases de
+// mayoria de inserciones, de mayoria de borrados (merges y borrows bajo
+// contencion) y mixta. Tras cada fase se verifican check_properties() y el
+// contenido. Sale con codigo distinto de 0 si algo falla.
+//   g++ -std=c++17 -O2 -pthread stress_concurrent.cpp -o stress_concurrent
+#include <atomic>
+#include <random>
+#include <thread>
+#include <vector>
+#include "concurrent_btree.h"
+#include "tester.h"
+
+using namespace std;
+
+const int kThreads = 8;
+const int kKeySpace = 4000;
+const int kOpsPerThread = 60000;
+
+// net[k]: inserts exitosos menos removes exitosos de k. Como insert solo
+// tiene exito si la key no estaba y remove solo si estaba, al final debe
+// valer 0 o 1 y la key debe estar en el arbol si y solo si vale 1
+struct Phase {
+  int insert_pct;
+  int remove_pct;  // el resto: search y rangeSearch
+};
+
+bool run_phase(ConcurrentBTree<int>& tree, vector<atomic<int>>& net, const Phase& phase, unsigned seed) {
+  atomic<bool> range_ok{true};
+  vector<thread> workers;
+  for (int t = 0; t < kThreads; ++t) {
+    workers.emplace_back([&, t] {
+      mt19937 rng(seed * 131 + t);
+      for (int i = 0; i < kOpsPerThread; ++i) {
+        int key = static_cast<int>(rng() % kKeySpace);
+        int op = static_cast<int>(rng() % 100);
+        if (op < phase.insert_pct) {
+          if (tree.insert(key)) net[key]++;
+        } else if (op < phase.insert_pct + phase.remove_pct) {
+          if (tree.remove(key)) net[key]--;
+        } else if (op % 8 != 0) {
+          tree.search(key);
+        } else {
+          int end = key + static_cast<int>(rng() % 200);
+          vector<int> out = tree.rangeSearch(key, end);
+          for (size_t j = 0; j < out.size(); ++j) {
+            if (out[j] < key || out[j] > end || (j > 0 && out[j - 1] >= out[j])) range_ok = false;
+          }
+        }
+      }
+    });
+  }
+  for (thread& w : workers) w.join();
+
+  bool contents_ok = true;
+  long long expected = 0;
+  vector<int> all = tree.rangeSearch(0, kKeySpace);
+  size_t next = 0;
+  for (int k = 0; k < kKeySpace; ++k) {
+    int v = net[k].load();
+    if (v != 0 && v != 1) contents_ok = false;
+    if (v == 1) {
+      expected++;
+      if (next >= all.size() || all[next] != k) contents_ok = false;
+      next++;
+    }
+    if (tree.search(k) != (v == 1)) contents_ok = false;
+  }
+  contents_ok = contents_ok && next == all.size();
+
+  ASSERT(range_ok.load(), "rangeSearch devolvio keys fuera de orden o de rango");
+  ASSERT(tree.check_properties(), "check_properties fallo tras la fase");
+  ASSERT(tree.size() == expected, "size no coincide con los inserts/removes exitosos");
+  ASSERT(contents_ok, "el contenido no coincide con los inserts/removes exitosos");
+  return range_ok && contents_ok && tree.size() == expected;
+}
+
+int main() {
+  const Phase phases[] = {{70, 10}, {10, 70}, {40, 40}, {5, 90}};
+  for (int M : {4, 5, 8, 32}) {
+    ConcurrentBTree<int> tree(M);
+    vector<atomic<int>> net(kKeySpace);
+    for (auto& v : net) v = 0;
+    unsigned seed = static_cast<unsigned>(M);
+    for (const Phase& phase : phases) {
+      if (!run_phase(tree, net, phase, seed++)) break;
+    }
+  }
+  return TrueAsserts == TotalAsserts ? 0 : 1;
+}
@@ -0,0 +1,95 @@
+// Prueba diferencial de aggregate (BTree<TK, SubtreeAggregate<Monoid>>)
+// contra std::set con suma, minimo y maximo, verificando despues de cada
+// insert y remove. Con M chico (3 y 4) los agregados guardados pasan seguido
+// por split, borrow, merge y el reemplazo por el sucesor; las rachas de keys
+// crecientes y decrecientes pasan por la insercion en los bordes, y TopDown
+// por su propio camino.
+//   g++ -std=c++17 -O2 test_aggregate.cpp -o test_aggregate
+#include <iterator>
+#include <random>
+#include <set>
+#include <vector>
+#include "btree.h"
+#include "tester.h"
+
+using namespace std;
+
+using Sum = SumMonoid<int, long long>;
+using SumTree = BTree<int, SubtreeAggregate<Sum>>;
+using MinTree = BTree<int, SubtreeAggregate<MinMonoid<int>>>;
+using MaxTree = BTree<int, SubtreeAggregate<MaxMonoid<int>>>;
+using TopDownSumTree = BTree<int, SubtreeAggregate<Sum, true>, less<int>, TopDown>;
+
+// el monoide aplicado en orden a las keys de ref en [a, b]
+template <typename Monoid>
+typename Monoid::value_type expected(const set<int>& ref, int a, int b) {
+  typename Monoid::value_type acc = Monoid::identity();
+  for (auto it = ref.lower_bound(a); it != ref.end() && *it <= b; ++it) acc = Monoid::combine(acc, Monoid::lift(*it));
+  return acc;
+}
+
+template <typename Monoid, typename Tree>
+bool consistent(Tree& t, const set<int>& ref, mt19937& rng) {
+  if (!t.check_properties() || t.size() != static_cast<int>(ref.size())) return false;
+  if (t.aggregate(-100000, 100000) != expected<Monoid>(ref, -100000, 100000)) return false;
+  for (int q = 0; q < 8; ++q) {
+    int a = static_cast<int>(rng() % 1600) - 300, b = a + static_cast<int>(rng() % 400);
+    auto value = expected<Monoid>(ref, a, b);
+    if (t.aggregate(a, b) != value || t.aggregate(b, a) != value) return false;
+  }
+  return true;
+}
+
+template <typename Tree, typename Monoid>
+bool run(int M) {
+  mt19937 rng(M * 11 + 3);
+  Tree t(M);
+  set<int> ref;
+  bool ok = true;
+  auto insert = [&](int k) {
+    t.insert(k);
+    ref.insert(k);
+    ok = ok && consistent<Monoid>(t, ref, rng);
+  };
+  auto remove = [&](int k) {
+    t.remove(k);
+    ref.erase(k);
+    ok = ok && consistent<Monoid>(t, ref, rng);
+  };
+
+  for (int round = 0; round < 3 && ok; ++round) {
+    // al azar, primero creciendo y despues achicandose
+    for (int i = 0; i < 1500 && ok; ++i) {
+      int k = static_cast<int>(rng() % 1000);
+      if (rng() % 10 < (i < 900 ? 7 : 3))
+        insert(k);
+      else
+        remove(k);
+    }
+    // rachas en los bordes: mayores que el maximo y menores que el minimo
+    int hi = ref.empty() ? 1000 : *ref.rbegin() + 1;
+    for (int k = hi; k < hi + 150 && ok; ++k) insert(k);
+    int lo = ref.empty() ? -1 : *ref.begin() - 1;
+    for (int k = lo; k > lo - 150 && ok; --k) insert(k);
+    // borrar desde los extremos y desde el medio
+    for (int i = 0; i < 100 && ok && !ref.empty(); ++i) remove(*ref.begin());
+    for (int i = 0; i < 100 && ok && !ref.empty(); ++i) remove(*ref.rbegin());
+    for (int i = 0; i < 150 && ok && !ref.empty(); ++i) remove(*next(ref.begin(), static_cast<long>(rng() % ref.size())));
+  }
+  while (ok && !ref.empty()) remove(*next(ref.begin(), static_cast<long>(rng() % ref.size())));
+  return ok && t.aggregate(0, 100) == expected<Monoid>(ref, 0, 100);
+}
+
+int main() {
+  for (int M : {3, 4, 5}) {
+    bool sum = run<SumTree, Sum>(M), min = run<MinTree, MinMonoid<int>>(M), max = run<MaxTree, MaxMonoid<int>>(M);
+    ASSERT(sum, "aggregate con suma difiere con M = " << M);
+    ASSERT(min, "aggregate con minimo difiere con M = " << M);
+    ASSERT(max, "aggregate con maximo difiere con M = " << M);
+  }
+  for (int M : {4, 6}) {
+    bool sum = run<TopDownSumTree, Sum>(M);
+    ASSERT(sum, "aggregate con TopDown difiere con M = " << M);
+  }
+  return TrueAsserts == TotalAsserts ? 0 : 1;
+}
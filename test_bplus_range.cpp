@@ -0,0 +1,101 @@
+// Prueba de BPlusTree contra std::set centrada en rangeSearch, que baja una
+// sola vez y sigue por la lista de hojas: rangos que cruzan muchas hojas,
+// invertidos, vacios, de una key, con bordes en separadores (incluidos los
+// que quedan en los nodos internos despues de borrar su key) y fuera de los
+// extremos. Con M chico y muchos insert/remove los splits, borrows y merges
+// reenlazan next/prev seguido; se verifican tambien check_properties(),
+// search, toString y minKey/maxKey.
+//   g++ -std=c++17 -O2 test_bplus_range.cpp -o test_bplus_range
+#include <iterator>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+#include "bplus_tree.h"
+#include "tester.h"
+
+using namespace std;
+
+vector<int> expected(const set<int>& ref, int a, int b) {
+  if (b < a) swap(a, b);
+  return vector<int>(ref.lower_bound(a), ref.upper_bound(b));
+}
+
+bool same(BPlusTree<int>& t, const set<int>& ref, const vector<int>& probes, mt19937& rng) {
+  if (!t.check_properties() || t.size() != static_cast<int>(ref.size())) return false;
+  if (ref.empty()) return t.rangeSearch(INT32_MIN, INT32_MAX).empty() && t.toString(",").empty();
+  if (t.minKey() != *ref.begin() || t.maxKey() != *ref.rbegin()) return false;
+  int lo = *ref.begin(), hi = *ref.rbegin();
+  if (t.rangeSearch(lo - 1, hi + 1) != vector<int>(ref.begin(), ref.end())) return false;
+  if (!t.rangeSearch(hi + 1, hi + 100).empty() || !t.rangeSearch(lo - 100, lo - 1).empty()) return false;
+  // bordes en keys borradas (separadores viejos), presentes y al azar
+  for (size_t q = 0; q < 30; ++q) {
+    int a = probes.empty() || q % 2 ? lo + static_cast<int>(rng() % static_cast<unsigned>(hi - lo + 1))
+                                    : probes[rng() % probes.size()];
+    int b = a + static_cast<int>(rng() % static_cast<unsigned>(q < 10 ? 4 : hi - lo + 1));
+    vector<int> want = expected(ref, a, b);
+    if (t.rangeSearch(a, b) != want || t.rangeSearch(b, a) != want) return false;
+    if (t.search(a) != (ref.count(a) == 1)) return false;
+  }
+  return true;
+}
+
+bool run(int M) {
+  mt19937 rng(M * 5 + 55);
+  BPlusTree<int> t(M);
+  set<int> ref;
+  vector<int> removed;
+  bool ok = true;
+  auto check = [&]() { ok = ok && same(t, ref, removed, rng); };
+
+  for (int round = 0; round < 4 && ok; ++round) {
+    // crece al azar
+    for (int i = 0; i < 3000 && ok; ++i) {
+      int k = static_cast<int>(rng() % 20000);
+      t.insert(k);
+      ref.insert(k);
+      if (i % 50 == 0) check();
+    }
+    // rachas en los bordes
+    int hi = *ref.rbegin();
+    for (int k = hi + 1; k < hi + 300 && ok; ++k) {
+      t.insert(k);
+      ref.insert(k);
+    }
+    check();
+    // se achica: merges y borrows reenlazan las hojas
+    for (int i = 0; i < 2500 && ok && !ref.empty(); ++i) {
+      int k = *next(ref.begin(), static_cast<long>(rng() % ref.size()));
+      t.remove(k);
+      ref.erase(k);
+      removed.push_back(k);
+      if (i % 50 == 0) check();
+    }
+    for (int i = 0; i < 200 && !ref.empty(); ++i) {
+      removed.push_back(*ref.begin());
+      t.remove(*ref.begin());
+      ref.erase(ref.begin());
+    }
+    check();
+  }
+  // string de las hojas en orden
+  string joined;
+  for (int k : ref) joined += (joined.empty() ? "" : ",") + to_string(k);
+  ok = ok && t.toString(",") == joined;
+  while (ok && !ref.empty()) {
+    int k = *next(ref.begin(), static_cast<long>(rng() % ref.size()));
+    t.remove(k);
+    ref.erase(k);
+    if (ref.size() % 100 == 0) check();
+  }
+  check();
+  return ok;
+}
+
+int main() {
+  for (int M : {3, 4, 5, 16}) {
+    bool ok = run(M);
+    ASSERT(ok, "BPlusTree::rangeSearch difiere de std::set con M = " << M);
+  }
+  return TrueAsserts == TotalAsserts ? 0 : 1;
+}
@@ -0,0 +1,110 @@
+// Prueba de BTreeMap contra std::map: se escribe a traves del puntero que
+// devuelve cada try_emplace e insert_or_assign (que debe seguir a la key por
+// una cascada de splits, incluso hasta una raiz nueva) y despues se leen
+// todos los valores con find. Tambien erase, incluido el caso en que el
+// valor del sucesor sube a un nodo interno, con M chico para que haya
+// splits, borrows y merges en casi cada operacion.
+//   g++ -std=c++17 -O2 test_btree_map.cpp -o test_btree_map
+#include <algorithm>
+#include <map>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "btree_map.h"
+#include "tester.h"
+
+using namespace std;
+
+// valores distintos por operacion, para notar uno que quedo en otra key
+long long make_value(int key, int op, long long*) { return static_cast<long long>(key) * 100000 + op; }
+string make_value(int key, int op, string*) { return to_string(key) + "/" + to_string(op) + string((op < 0 ? -op : op) % 40, 'x'); }
+
+template <typename TV>
+bool same(BTreeMap<int, TV>& t, const map<int, TV>& ref) {
+  if (!t.check_properties() || t.size() != static_cast<int>(ref.size())) return false;
+  for (auto& kv : ref) {
+    TV* v = t.find(kv.first);
+    if (!v || *v != kv.second) return false;
+  }
+  vector<pair<int, TV>> all = t.rangeSearch(INT32_MIN, INT32_MAX);
+  return all == vector<pair<int, TV>>(ref.begin(), ref.end());
+}
+
+template <typename TV>
+bool run(int M) {
+  mt19937 rng(M * 21 + 1);
+  BTreeMap<int, TV> t(M);
+  map<int, TV> ref;
+  bool ok = true;
+  int op = 0;
+
+  // escribe por el puntero devuelto, que debe apuntar al valor de key
+  auto put = [&](int key) {
+    TV value = make_value(key, ++op, static_cast<TV*>(nullptr));
+    pair<TV*, bool> r;
+    if (op % 2) {
+      r = t.try_emplace(key);
+      ok = ok && r.second == (ref.count(key) == 0);
+    } else {
+      TV first = make_value(key, -op, static_cast<TV*>(nullptr));
+      r = t.insert_or_assign(key, first);
+      ok = ok && r.second == (ref.count(key) == 0) && *r.first == first;
+    }
+    *r.first = value;
+    ref[key] = value;
+    ok = ok && same(t, ref);
+  };
+  auto erase = [&](int key) {
+    ok = ok && t.erase(key) == (ref.erase(key) == 1);
+    ok = ok && same(t, ref);
+  };
+
+  // crecientes: cada split llega hasta la raiz seguido
+  for (int k = 0; k < 300 && ok; ++k) put(k);
+  // decrecientes y al azar, tambien sobre keys ya presentes
+  for (int k = -1; k > -300 && ok; --k) put(k);
+  for (int i = 0; i < 1500 && ok; ++i) put(static_cast<int>(rng() % 1200) - 600);
+  // borrados: keys de nodos internos (sucesor), al azar y por los extremos
+  for (int i = 0; i < 600 && ok; ++i) erase(static_cast<int>(rng() % 1200) - 600);
+  while (ok && !ref.empty()) {
+    erase(rng() % 2 ? ref.begin()->first : ref.rbegin()->first);
+    if (!ref.empty()) erase(next(ref.begin(), static_cast<long>(rng() % ref.size()))->first);
+  }
+  ok = ok && t.size() == 0 && !t.erase(5) && t.find(5) == nullptr;
+
+  // arboles chicos desde vacios en orden al azar: la key insertada queda a
+  // menudo en el medio de cada split hasta la raiz y termina en la raiz nueva
+  for (int tree = 0; tree < 200 && ok; ++tree) {
+    vector<int> keys(2 + tree % 40);
+    for (size_t i = 0; i < keys.size(); ++i) keys[i] = static_cast<int>(i);
+    shuffle(keys.begin(), keys.end(), rng);
+    for (int k : keys) {
+      if (!ok) break;
+      put(k);
+    }
+    while (ok && !ref.empty()) erase(ref.begin()->first);
+  }
+
+  // operator[] y at
+  for (int k = 0; k < 200 && ok; ++k) {
+    t[k] = make_value(k, 1, static_cast<TV*>(nullptr));
+    ref[k] = t.at(k);
+  }
+  bool threw = false;
+  try {
+    t.at(1000);
+  } catch (out_of_range&) {
+    threw = true;
+  }
+  return ok && threw && same(t, ref);
+}
+
+int main() {
+  for (int M : {3, 4, 5, 8}) {
+    bool numbers = run<long long>(M), strings = run<string>(M);
+    ASSERT(numbers, "BTreeMap<int, long long> difiere de std::map con M = " << M);
+    ASSERT(strings, "BTreeMap<int, string> difiere de std::map con M = " << M);
+  }
+  return TrueAsserts == TotalAsserts ? 0 : 1;
+}
@@ -0,0 +1,172 @@
+// Prueba de compact y compact_step contra std::set: compactacion completa
+// con distintos fill_factor, pasadas incrementales hasta terminar (con
+// check_properties() despues de cada paso), pasadas intercaladas con
+// inserciones y borrados, reanudacion cuando la key donde quedo la pasada ya
+// no esta, padres que quedan varias keys por debajo del minimo y colapso de
+// la raiz.
+//   g++ -std=c++17 -O2 test_compact.cpp -o test_compact
+#include <random>
+#include <set>
+#include <stdexcept>
+#include <vector>
+#include "btree.h"
+#include "tester.h"
+
+using namespace std;
+
+template <typename Tree>
+bool same(Tree& t, const set<int>& ref) {
+  return t.check_properties() && t.size() == static_cast<int>(ref.size()) &&
+         vector<int>(t.begin(), t.end()) == vector<int>(ref.begin(), ref.end());
+}
+
+template <typename Tree>
+void churn(Tree& t, set<int>& ref, mt19937& rng, int ops, int space) {
+  for (int i = 0; i < ops; ++i) {
+    int k = static_cast<int>(rng() % space);
+    if (rng() % 3) {
+      t.insert(k);
+      ref.insert(k);
+    } else {
+      t.remove(k);
+      ref.erase(k);
+    }
+  }
+}
+
+// arbol con las hojas a medio llenar: inserciones al azar y un tercio borrado
+template <typename Tree>
+void sparse(Tree& t, set<int>& ref, mt19937& rng, int space) {
+  churn(t, ref, rng, space / 2, space);
+  for (int k = 0; k < space; k += 3) {
+    t.remove(k);
+    ref.erase(k);
+  }
+}
+
+template <typename Tree>
+void run(int M) {
+  const int space = 12000;
+  mt19937 rng(M);
+  for (double fill : {1.0, 0.75, 0.5, 0.1}) {
+    // compactacion completa
+    Tree full(M);
+    set<int> ref;
+    sparse(full, ref, rng, space);
+    double before = full.fill_factor();
+    full.compact(fill);
+    bool ok = same(full, ref) && (fill < 1.0 || full.fill_factor() >= before);
+    churn(full, ref, rng, 5000, space);
+    ASSERT(ok && same(full, ref), "compact(" << fill << ") con M = " << M);
+
+    // pasada incremental hasta terminar, verificando cada paso
+    Tree inc(M);
+    set<int> ref_inc;
+    sparse(inc, ref_inc, rng, space);
+    size_t leaves = inc.leaf_count();
+    int height = inc.height();
+    size_t calls = 1;
+    bool each = true;
+    while (inc.compact_step(3, fill) && calls <= leaves) {
+      each = each && inc.check_properties();
+      calls++;
+    }
+    // cada llamada avanza al menos un padre: la pasada termina sin reiniciar
+    // y con dos o mas niveles internos no entra en una sola llamada
+    ASSERT(each && calls <= leaves && (height < 2 || calls > 1) && same(inc, ref_inc),
+           "compact_step(3, " << fill << ") hasta terminar con M = " << M);
+
+    // pasada intercalada con inserciones y borrados entre pasos
+    Tree mixed(M);
+    set<int> ref_mixed;
+    sparse(mixed, ref_mixed, rng, space);
+    leaves = mixed.leaf_count();
+    size_t steps = 0;
+    each = true;
+    while (mixed.compact_step(5, fill) && steps++ < 4 * leaves) {
+      churn(mixed, ref_mixed, rng, 40, space);
+      each = each && same(mixed, ref_mixed);
+    }
+    ASSERT(each && steps < 4 * leaves && same(mixed, ref_mixed),
+           "compact_step(5, " << fill << ") intercalado con M = " << M);
+  }
+
+  // reanudar cuando las keys alrededor de donde quedo la pasada ya no estan
+  {
+    Tree t(M);
+    set<int> ref;
+    for (int k = 0; k < space; ++k) {
+      t.insert(k);
+      ref.insert(k);
+    }
+    bool each = true;
+    for (int round = 0; round < 3 && t.compact_step(1, 0.5); ++round) {
+      int lo = round * space / 3, hi = lo + space / 4;
+      for (int k = lo; k < hi; ++k) {
+        t.remove(k);
+        ref.erase(k);
+      }
+      for (int k = -1 - round * 100; k > -100 - round * 100; --k) {
+        t.insert(k);
+        ref.insert(k);
+      }
+      each = each && same(t, ref);
+    }
+    while (t.compact_step(2, 0.5)) each = each && t.check_properties();
+    ASSERT(each && same(t, ref), "compact_step no reanuda bien tras borrar su punto de partida con M = " << M);
+  }
+
+  // arbol minimo de altura 3 (todos los nodos al minimo): al juntar las
+  // hojas de cada padre en la mitad, los padres quedan varias keys por
+  // debajo del minimo, los nodos internos se fusionan y la raiz colapsa.
+  // Con M = 3 las hojas ya estan llenas y no hay nada que compactar
+  {
+    int m = (M + 1) / 2 - 1;
+    int keys = 1 + 2 * (m + (m + 1) * (m + (m + 1) * m));
+    Tree t(M);
+    set<int> ref;
+    for (int k = 0; k < keys; ++k) {
+      t.insert(k);
+      ref.insert(k);
+    }
+    t.compact(0.01);
+    bool minimal = t.height() == 3 && same(t, ref);
+    bool each = true;
+    while (t.compact_step(1, 1.0)) each = each && t.check_properties();
+    ASSERT(minimal && each && same(t, ref) && t.height() == (M > 3 ? 2 : 3),
+           "compact_step no arregla padres por debajo del minimo ni colapsa la raiz con M = " << M);
+  }
+}
+
+int main() {
+  for (int M : {3, 4, 5, 8, 16, 64}) {
+    run<BTree<int>>(M);
+    run<BTree<int, SubtreeSize>>(M);
+  }
+  for (int M : {4, 16}) run<BTree<int, NoAugment, less<int>, TopDown>>(M);
+
+  // arboles vacios o de una hoja y fill_factor invalido
+  BTree<int> t(8);
+  t.compact();
+  bool ok = !t.compact_step(5) && t.size() == 0;
+  t.insert(1);
+  t.compact(0.5);
+  ok = ok && !t.compact_step(5) && t.size() == 1 && t.check_properties();
+  ASSERT(ok, "compact y compact_step sobre arboles vacios o de una hoja");
+  int rejected = 0;
+  for (double fill : {0.0, -0.5, 1.5}) {
+    try {
+      t.compact(fill);
+    } catch (invalid_argument&) {
+      rejected++;
+    }
+    try {
+      t.compact_step(1, fill);
+    } catch (invalid_argument&) {
+      rejected++;
+    }
+  }
+  ASSERT(rejected == 6, "compact y compact_step aceptan un fill_factor invalido");
+
+  return TrueAsserts == TotalAsserts ? 0 : 1;
+}
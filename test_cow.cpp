@@ -0,0 +1,99 @@
+// Prueba de aislamiento de los snapshots de CowBTree: se toman snapshots
+// mientras el arbol vivo sigue cambiando con splits, borrows y merges (M
+// chico), cada snapshot debe seguir devolviendo exactamente su contenido
+// original, y al soltar todas las versiones no debe quedar ningun nodo vivo
+// (se cuentan los bloques pedidos al reservador global).
+//   g++ -std=c++17 -O2 test_cow.cpp -o test_cow
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <random>
+#include <set>
+#include <vector>
+#include "cow_btree.h"
+#include "tester.h"
+
+using namespace std;
+
+// bloques vivos del reservador global (los nodos usan ::operator new)
+static atomic<long long> live_blocks{0};
+
+void* operator new(size_t sz) {
+  live_blocks++;
+  if (void* p = std::malloc(sz ? sz : 1)) return p;
+  throw std::bad_alloc();
+}
+__attribute__((noinline)) static void release_block(void* p) noexcept {
+  if (p) live_blocks--;
+  std::free(p);
+}
+void operator delete(void* p) noexcept { release_block(p); }
+void operator delete(void* p, size_t) noexcept { release_block(p); }
+
+struct Version {
+  CowBTree<int>::Snapshot snap;
+  vector<int> keys;
+};
+
+bool intact(const Version& v, mt19937& rng) {
+  bool ok = v.snap.size() == static_cast<int>(v.keys.size()) && v.snap.rangeSearch(-1, 1 << 30) == v.keys;
+  if (!v.keys.empty()) ok = ok && v.snap.minKey() == v.keys.front() && v.snap.maxKey() == v.keys.back();
+  for (int i = 0; i < 50 && ok; ++i) {
+    int k = static_cast<int>(rng() % 4000);
+    ok = v.snap.search(k) == binary_search(v.keys.begin(), v.keys.end(), k);
+  }
+  return ok;
+}
+
+void run(int M) {
+  long long baseline = live_blocks.load();
+  {
+    mt19937 rng(M);
+    CowBTree<int> tree(M);
+    set<int> ref;
+    vector<Version> versions;
+    bool live_ok = true, snaps_ok = true;
+    for (int i = 0; i < 40000; ++i) {
+      int k = static_cast<int>(rng() % 4000);
+      // primero crece (splits), despues mayoria de borrados (borrows y merges)
+      bool insert = i < 15000 ? rng() % 4 != 0 : rng() % 3 == 0;
+      if (insert)
+        live_ok = live_ok && tree.insert(k) == ref.insert(k).second;
+      else
+        live_ok = live_ok && tree.remove(k) == (ref.erase(k) == 1);
+
+      if (i % 1000 == 0) versions.push_back({tree.snapshot(), vector<int>(ref.begin(), ref.end())});
+      if (i % 2500 == 0) {
+        live_ok = live_ok && tree.check_properties() && tree.rangeSearch(-1, 1 << 30) == vector<int>(ref.begin(), ref.end());
+        for (const Version& v : versions) snaps_ok = snaps_ok && intact(v, rng);
+      }
+      // soltar algunas versiones en el medio, en desorden
+      if (i % 3700 == 0 && versions.size() > 3) versions.erase(versions.begin() + rng() % versions.size());
+    }
+    for (const Version& v : versions) snaps_ok = snaps_ok && intact(v, rng);
+    ASSERT(live_ok && tree.check_properties(), "el arbol vivo difiere de std::set con M = " << M);
+    ASSERT(snaps_ok && tree.copied_nodes() > 0, "un snapshot cambio de contenido con M = " << M);
+  }
+  ASSERT(live_blocks.load() == baseline, "quedan nodos sin liberar con M = " << M);
+
+  // snapshots que sobreviven al arbol: se liberan al soltar la ultima copia
+  {
+    CowBTree<int>::Snapshot survivor;
+    vector<int> keys;
+    {
+      CowBTree<int> tree(M);
+      for (int k = 0; k < 3000; ++k) tree.insert(k);
+      survivor = tree.snapshot();
+      for (int k = 0; k < 3000; k += 2) tree.remove(k);
+      for (int k = 0; k < 3000; ++k) keys.push_back(k);
+    }
+    mt19937 rng(M);
+    ASSERT(intact(Version{survivor, keys}, rng), "un snapshot no sobrevive al arbol con M = " << M);
+  }
+  ASSERT(live_blocks.load() == baseline, "un snapshot que sobrevive al arbol deja nodos sin liberar con M = " << M);
+}
+
+int main() {
+  for (int M : {3, 4, 5, 8, 32}) run(M);
+  return TrueAsserts == TotalAsserts ? 0 : 1;
+}
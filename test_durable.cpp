@@ -0,0 +1,159 @@
+// Prueba de DurableBTree contra std::set: reabrir tras inserciones y
+// borrados con cada FsyncPolicy, recuperacion desde un checkpoint mas los
+// segmentos de WAL siguientes, cola del WAL cortada a mano y log fallido
+// despues de un write que no se pudo completar (limite de tamaño de archivo).
+//   g++ -std=c++17 -O2 -pthread test_durable.cpp -o test_durable
+#include <csignal>
+#include <random>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <sys/resource.h>
+#include "durable_btree.h"
+#include "tester.h"
+
+using namespace std;
+
+const int M = 8;
+
+bool same(DurableBTree<int>& t, const set<int>& ref) {
+  return t.size() == static_cast<int>(ref.size()) &&
+         t.rangeSearch(INT32_MIN, INT32_MAX) == vector<int>(ref.begin(), ref.end());
+}
+
+// operaciones al azar; devuelve cuantas cambiaron el arbol (= registros)
+int churn(DurableBTree<int>& t, set<int>& ref, mt19937& rng, int ops) {
+  int logged = 0;
+  for (int i = 0; i < ops; ++i) {
+    int k = static_cast<int>(rng() % 2000);
+    bool changed;
+    if (rng() % 3) {
+      changed = t.insert(k);
+      if (changed != ref.insert(k).second) return -1;
+    } else {
+      changed = t.remove(k);
+      if (changed != (ref.erase(k) == 1)) return -1;
+    }
+    logged += changed;
+  }
+  return logged;
+}
+
+// el segmento de WAL mas nuevo del directorio
+filesystem::path last_segment(const filesystem::path& dir) {
+  filesystem::path last;
+  for (auto& entry : filesystem::directory_iterator(dir)) {
+    string file = entry.path().filename().string();
+    if (file.rfind("wal-", 0) == 0 && (last.empty() || file > last.filename().string())) last = entry.path();
+  }
+  return last;
+}
+
+int main() {
+  filesystem::path dir = filesystem::temp_directory_path() / ("test_durable_" + to_string(getpid()));
+  mt19937 rng(19);
+
+  // reabrir con cada politica de fsync
+  for (FsyncPolicy policy : {FsyncPolicy::Always, FsyncPolicy::Interval, FsyncPolicy::Never}) {
+    filesystem::remove_all(dir);
+    DurabilityOptions opts;
+    opts.fsync = policy;
+    opts.buffer_bytes = 256;
+    set<int> ref;
+    bool ok = true;
+    for (int round = 0; round < 3; ++round) {
+      DurableBTree<int> t(dir.string(), M, opts);
+      ok = ok && same(t, ref) && churn(t, ref, rng, 3000) >= 0;
+    }
+    DurableBTree<int> t(dir.string(), M, opts);
+    ASSERT(ok && same(t, ref), "reabrir no recupera el arbol con la politica " << static_cast<int>(policy));
+  }
+
+  // checkpoint mas segmentos de WAL posteriores
+  {
+    filesystem::remove_all(dir);
+    DurabilityOptions opts;
+    opts.checkpoint_every = 1000;
+    set<int> ref;
+    int logged;
+    {
+      DurableBTree<int> t(dir.string(), M, opts);
+      churn(t, ref, rng, 5000);
+      t.checkpoint();
+      logged = churn(t, ref, rng, 700);
+    }
+    int checkpoints = 0, segments = 0;
+    for (auto& entry : filesystem::directory_iterator(dir)) {
+      string file = entry.path().filename().string();
+      checkpoints += file.rfind("checkpoint-", 0) == 0;
+      segments += file.rfind("wal-", 0) == 0;
+    }
+    DurableBTree<int> t(dir.string(), M, opts);
+    ASSERT(checkpoints == 1 && segments == 1 && same(t, ref) && t.replayed_records() == static_cast<size_t>(logged),
+           "la recuperacion desde checkpoint + WAL no coincide");
+  }
+
+  // cola cortada: el ultimo registro queda incompleto y se descarta
+  {
+    filesystem::remove_all(dir);
+    set<int> ref;
+    uint64_t lsn;
+    {
+      DurableBTree<int> t(dir.string(), M);
+      churn(t, ref, rng, 2000);
+      t.insert(5000);  // ultimo registro: una insercion conocida
+      lsn = t.last_lsn();
+    }
+    filesystem::path wal = last_segment(dir);
+    filesystem::resize_file(wal, filesystem::file_size(wal) - 5);
+    DurableBTree<int> t(dir.string(), M);
+    ASSERT(same(t, ref) && !t.search(5000) && t.last_lsn() == lsn - 1 && t.replayed_records() == lsn - 1,
+           "la cola cortada del WAL no se descarta");
+    ASSERT(t.insert(5000) && t.last_lsn() == lsn, "no se puede seguir escribiendo despues de truncar la cola");
+  }
+
+  // write fallido: con RLIMIT_FSIZE el WAL no puede crecer (EFBIG) y desde
+  // ahi toda escritura, sync o checkpoint lanza kFailedLog
+  {
+    filesystem::remove_all(dir);
+    set<int> ref;
+    signal(SIGXFSZ, SIG_IGN);
+    rlimit old_limit;
+    getrlimit(RLIMIT_FSIZE, &old_limit);
+    int rejected = 0;
+    {
+      DurableBTree<int> t(dir.string(), M);
+      churn(t, ref, rng, 500);
+      rlimit limit = old_limit;
+      limit.rlim_cur = filesystem::file_size(last_segment(dir)) + 3;
+      setrlimit(RLIMIT_FSIZE, &limit);
+      bool first_failed = false;
+      try {
+        t.insert(7000);
+      } catch (runtime_error&) {
+        first_failed = true;
+      }
+      setrlimit(RLIMIT_FSIZE, &old_limit);
+      ASSERT(first_failed, "el write que supera el limite no lanza");
+
+      for (int op = 0; op < 4; ++op) {
+        try {
+          if (op == 0) t.insert(7001);
+          if (op == 1) t.remove(*ref.begin());
+          if (op == 2) t.sync();
+          if (op == 3) t.checkpoint();
+        } catch (runtime_error& e) {
+          rejected += string(e.what()) == DurableBTree<int>::kFailedLog;
+        }
+      }
+      ASSERT(!t.search(7001) && t.search(*ref.begin()), "una operacion rechazada modifico el arbol");
+    }
+    ASSERT(rejected == 4, "despues del write fallido las operaciones no lanzan kFailedLog");
+    DurableBTree<int> t(dir.string(), M);
+    ASSERT(same(t, ref) && !t.search(7000), "reabrir despues del write fallido no recupera lo durable");
+  }
+
+  filesystem::remove_all(dir);
+  return TrueAsserts == TotalAsserts ? 0 : 1;
+}
@@ -0,0 +1,130 @@
+// Prueba del cache de bordes de BTree (insert_at_edge) contra std::set:
+// rachas de inserciones crecientes y decrecientes, que entran directo por la
+// hoja cacheada, intercaladas con lo que puede dejar el cache viejo: remove
+// del maximo y del minimo (merges y nodos del borde liberados), remove al
+// azar, inserciones en el medio, compact y compact_step (hojas liberadas),
+// insertSorted en los bordes y clear. Se verifica despues de cada operacion,
+// con M chico para que los nodos del borde cambien seguido, con tamaños de
+// subarbol y con TopDown.
+//   g++ -std=c++17 -O2 test_edge_cache.cpp -o test_edge_cache
+#include <iterator>
+#include <random>
+#include <set>
+#include <vector>
+#include "btree.h"
+#include "tester.h"
+
+using namespace std;
+
+using CountedTree = BTree<int, SubtreeSize>;
+using TopDownTree = BTree<int, NoAugment, less<int>, TopDown>;
+
+template <typename Aug, typename C, typename U>
+bool same(BTree<int, Aug, C, U>& t, const set<int>& ref) {
+  bool ok = t.check_properties() && t.size() == static_cast<int>(ref.size()) &&
+            vector<int>(t.begin(), t.end()) == vector<int>(ref.begin(), ref.end());
+  if (ok && !ref.empty()) ok = t.minKey() == *ref.begin() && t.maxKey() == *ref.rbegin();
+  if constexpr (Aug::counted) {
+    if (ok && !ref.empty()) ok = t.rank(*ref.rbegin()) == static_cast<long long>(ref.size()) - 1 && t.select(0) == *ref.begin();
+  }
+  return ok;
+}
+
+template <typename Tree>
+bool run(int M) {
+  mt19937 rng(M * 24 + 5);
+  Tree t(M);
+  set<int> ref;
+  bool ok = true;
+  auto insert = [&](int k) {
+    t.insert(k);
+    ref.insert(k);
+    ok = ok && same(t, ref);
+  };
+  auto remove = [&](int k) {
+    t.remove(k);
+    ref.erase(k);
+    ok = ok && same(t, ref);
+  };
+  auto hi = [&] { return ref.empty() ? 0 : *ref.rbegin(); };
+  auto lo = [&] { return ref.empty() ? 0 : *ref.begin(); };
+
+  for (int step = 0; step < 3000 && ok; ++step) {
+    int run = 1 + static_cast<int>(rng() % (3 * M));
+    switch (rng() % 10) {
+      case 0:
+      case 1:  // racha creciente
+        for (int i = 0, k = hi(); i < run && ok; ++i) insert(k += 1 + static_cast<int>(rng() % 3));
+        break;
+      case 2:
+      case 3:  // racha decreciente
+        for (int i = 0, k = lo(); i < run && ok; ++i) insert(k -= 1 + static_cast<int>(rng() % 3));
+        break;
+      case 4:  // borrar desde el maximo: la hoja del borde se vacia y se fusiona
+        for (int i = 0; i < run && ok && !ref.empty(); ++i) remove(hi());
+        break;
+      case 5:  // borrar desde el minimo
+        for (int i = 0; i < run && ok && !ref.empty(); ++i) remove(lo());
+        break;
+      case 6:  // al azar en el medio, insert y remove
+        for (int i = 0; i < run && ok && !ref.empty(); ++i) {
+          int k = lo() + static_cast<int>(rng() % static_cast<unsigned>(hi() - lo() + 1));
+          if (rng() % 2)
+            insert(k);
+          else
+            remove(*next(ref.begin(), static_cast<long>(rng() % ref.size())));
+        }
+        break;
+      case 7:  // compactar: hojas del borde repartidas o liberadas
+        if (rng() % 2) {
+          t.compact(rng() % 2 ? 1.0 : 0.5);
+        } else {
+          while (t.compact_step(1 + rng() % 3)) {
+          }
+        }
+        ok = ok && same(t, ref);
+        break;
+      case 8: {  // lotes en los bordes
+        vector<int> batch;
+        for (int i = 1; i <= run; ++i) batch.push_back(hi() + i * 2);
+        int first = lo() - 4 * run;
+        for (int i = 0; i < run; ++i) batch.insert(batch.begin() + i, first + i * 2);
+        t.insertSorted(batch);
+        ref.insert(batch.begin(), batch.end());
+        ok = ok && same(t, ref);
+        // y enseguida por los bordes que el lote acaba de cambiar
+        for (int i = 0; i < M && ok; ++i) {
+          insert(hi() + 1);
+          insert(lo() - 1);
+        }
+        break;
+      }
+      default:  // achicar mucho de a ratos; a veces vaciar
+        if (rng() % 8 == 0) {
+          t.clear();
+          ref.clear();
+          ok = ok && same(t, ref);
+        } else {
+          for (int i = 0; i < 3 * run && ok && !ref.empty(); ++i)
+            remove(*next(ref.begin(), static_cast<long>(rng() % ref.size())));
+        }
+    }
+  }
+  return ok;
+}
+
+int main() {
+  for (int M : {3, 4, 5, 8}) {
+    bool plain = run<BTree<int>>(M);
+    ASSERT(plain, "el cache de bordes deja el arbol distinto de std::set con M = " << M);
+  }
+  for (int M : {3, 5}) {
+    bool counted = run<CountedTree>(M);
+    ASSERT(counted, "el cache de bordes deja tamaños de subarbol incorrectos con M = " << M);
+  }
+  for (int M : {4, 6}) {
+    bool top_down = run<TopDownTree>(M);
+    ASSERT(top_down, "el cache de bordes con TopDown difiere de std::set con M = " << M);
+  }
+  return TrueAsserts == TotalAsserts ? 0 : 1;
+}
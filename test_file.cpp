@@ -0,0 +1,116 @@
+// Prueba de BTree::save/load y MappedBTree contra std::set: ida y vuelta de
+// arboles vacios, de una key y de varios niveles, busquedas sobre el archivo
+// mapeado y archivos invalidos (truncado, magic incorrecto, otro tamaño de
+// key) que deben rechazarse.
+//   g++ -std=c++17 -O2 test_file.cpp -o test_file
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <unistd.h>
+#include "btree.h"
+#include "tester.h"
+
+using namespace std;
+
+bool same(BTree<int>& t, const set<int>& ref) {
+  return t.check_properties() && t.size() == static_cast<int>(ref.size()) &&
+         vector<int>(t.begin(), t.end()) == vector<int>(ref.begin(), ref.end());
+}
+
+// las mismas respuestas que ref para keys y rangos al azar
+bool same_queries(const MappedBTree<int>& mapped, const set<int>& ref, mt19937& rng) {
+  bool ok = mapped.size() == static_cast<int>(ref.size());
+  if (!ref.empty()) ok = ok && mapped.minKey() == *ref.begin() && mapped.maxKey() == *ref.rbegin();
+  for (int i = 0; i < 300 && ok; ++i) {
+    int a = static_cast<int>(rng() % 50000) - 100, b = a + static_cast<int>(rng() % 3000);
+    auto lo = ref.lower_bound(a), hi = ref.upper_bound(b);
+    ok = mapped.search(a) == (ref.count(a) == 1) && mapped.rangeSearch(a, b) == vector<int>(lo, hi);
+  }
+  return ok;
+}
+
+template <typename Reader>
+bool rejects(const string& path) {
+  try {
+    delete Reader::load(path);
+  } catch (runtime_error&) {
+    return true;
+  }
+  return false;
+}
+
+bool mapped_rejects(const string& path) {
+  try {
+    MappedBTree<int> mapped(path);
+  } catch (runtime_error&) {
+    return true;
+  }
+  return false;
+}
+
+int main() {
+  string path = (filesystem::temp_directory_path() / ("test_file_" + to_string(getpid()) + ".bin")).string();
+  mt19937 rng(17);
+
+  for (int M : {3, 4, 5, 16, 64}) {
+    for (int keys : {0, 1, 50, 20000}) {
+      BTree<int> t(M);
+      set<int> ref;
+      while (static_cast<int>(ref.size()) < keys) {
+        int k = static_cast<int>(rng() % 50000);
+        t.insert(k);
+        ref.insert(k);
+      }
+      // algunos borrados para que no todos los nodos queden iguales
+      for (int i = 0; i < keys / 4; ++i) {
+        int k = static_cast<int>(rng() % 50000);
+        t.remove(k);
+        ref.erase(k);
+      }
+      t.save(path);
+      BTree<int>* loaded = BTree<int>::load(path);
+      bool ok = same(*loaded, ref) && loaded->height() == t.height();
+      // el arbol cargado sigue siendo modificable
+      for (int i = 0; i < 2000 && keys > 0; ++i) {
+        int k = static_cast<int>(rng() % 50000);
+        loaded->insert(k);
+        ref.insert(k);
+      }
+      ok = ok && same(*loaded, ref);
+      delete loaded;
+      ASSERT(ok, "save/load no conserva el arbol con M = " << M << " y " << keys << " keys");
+
+      set<int> saved(t.begin(), t.end());
+      MappedBTree<int> mapped(path);
+      ASSERT(same_queries(mapped, saved, rng),
+             "MappedBTree difiere del arbol guardado con M = " << M << " y " << keys << " keys");
+    }
+  }
+
+  // archivos invalidos
+  BTree<int> t(8);
+  for (int k = 0; k < 5000; ++k) t.insert(k);
+  t.save(path);
+  uintmax_t full = filesystem::file_size(path);
+  ASSERT(rejects<BTree<long long>>(path), "load acepta un archivo con otro tamaño de key");
+
+  filesystem::resize_file(path, full / 2);
+  ASSERT(rejects<BTree<int>>(path) && mapped_rejects(path), "load acepta un archivo truncado");
+  filesystem::resize_file(path, 16);
+  ASSERT(rejects<BTree<int>>(path) && mapped_rejects(path), "load acepta un archivo mas chico que el header");
+
+  t.save(path);
+  {
+    fstream f(path, ios::in | ios::out | ios::binary);
+    f.seekp(0);
+    f.put('X');
+  }
+  ASSERT(rejects<BTree<int>>(path) && mapped_rejects(path), "load acepta un archivo con magic incorrecto");
+
+  filesystem::remove(path);
+  return TrueAsserts == TotalAsserts ? 0 : 1;
+}
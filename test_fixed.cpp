@@ -0,0 +1,99 @@
+// Prueba diferencial de FixedBTree<TK, M> contra BTree<TK> con el mismo M y
+// contra std::set: la misma secuencia de insert (con repetidas) y remove
+// (con keys ausentes), rachas crecientes y decrecientes, y el vaciado
+// completo. Se comparan search, rangeSearch, toString, minKey/maxKey, size
+// y check_properties() de ambos arboles.
+//   g++ -std=c++17 -O2 test_fixed.cpp -o test_fixed
+#include <iterator>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+#include "btree.h"
+#include "fixed_btree.h"
+#include "tester.h"
+
+using namespace std;
+
+template <int M>
+bool same(FixedBTree<int, M>& fixed, BTree<int>& tree, const set<int>& ref, mt19937& rng) {
+  vector<int> want(ref.begin(), ref.end());
+  if (!fixed.check_properties() || !tree.check_properties()) return false;
+  if (fixed.size() != static_cast<int>(ref.size()) || tree.size() != fixed.size()) return false;
+  if (fixed.rangeSearch(INT32_MIN, INT32_MAX) != want || fixed.toString(",") != tree.toString(",")) return false;
+  if (ref.empty()) return fixed.height() == 0;
+  if (fixed.minKey() != tree.minKey() || fixed.maxKey() != tree.maxKey() || fixed.maxKey() != *ref.rbegin())
+    return false;
+  int lo = *ref.begin(), hi = *ref.rbegin();
+  for (int q = 0; q < 10; ++q) {
+    int a = lo - 2 + static_cast<int>(rng() % static_cast<unsigned>(hi - lo + 4));
+    int b = a + static_cast<int>(rng() % 200);
+    vector<int> range = fixed.rangeSearch(b, a);
+    if (range != tree.rangeSearch(a, b) || range != vector<int>(ref.lower_bound(a), ref.upper_bound(b))) return false;
+    if (fixed.search(a) != tree.search(a) || fixed.search(a) != (ref.count(a) == 1)) return false;
+  }
+  return true;
+}
+
+template <int M>
+bool run() {
+  mt19937 rng(M * 3 + 1);
+  FixedBTree<int, M> fixed;
+  BTree<int> tree(M);
+  set<int> ref;
+  bool ok = FixedBTree<int, M>::order() == M;
+  auto insert = [&](int k) {
+    fixed.insert(k);
+    tree.insert(k);
+    ref.insert(k);
+  };
+  auto remove = [&](int k) {
+    fixed.remove(k);
+    tree.remove(k);
+    ref.erase(k);
+  };
+
+  for (int round = 0; round < 3 && ok; ++round) {
+    // al azar con repetidas y borrados de keys ausentes
+    for (int i = 0; i < 6000 && ok; ++i) {
+      int k = static_cast<int>(rng() % 4000);
+      if (rng() % 10 < (i < 4000 ? 7 : 3))
+        insert(k);
+      else
+        remove(k);
+      if (i % 25 == 0) ok = same(fixed, tree, ref, rng);
+    }
+    // rachas por los bordes y borrados desde el medio
+    int hi = ref.empty() ? 0 : *ref.rbegin();
+    for (int k = hi + 1; k < hi + 500; ++k) insert(k);
+    int lo = ref.empty() ? 0 : *ref.begin();
+    for (int k = lo - 1; k > lo - 500; --k) insert(k);
+    ok = ok && same(fixed, tree, ref, rng);
+    for (int i = 0; i < 800 && !ref.empty(); ++i) remove(*next(ref.begin(), static_cast<long>(rng() % ref.size())));
+    ok = ok && same(fixed, tree, ref, rng);
+  }
+  while (ok && !ref.empty()) {
+    remove(*next(ref.begin(), static_cast<long>(rng() % ref.size())));
+    if (ref.size() % 97 == 0) ok = same(fixed, tree, ref, rng);
+  }
+  ok = ok && same(fixed, tree, ref, rng);
+
+  // despues de vaciar y de clear() siguen funcionando
+  for (int k = 0; k < 1000; ++k) insert(k * 7 % 1000);
+  ok = ok && same(fixed, tree, ref, rng);
+  fixed.clear();
+  tree.clear();
+  ref.clear();
+  ok = ok && same(fixed, tree, ref, rng);
+  for (int k = 0; k < 300; ++k) insert(k);
+  return ok && same(fixed, tree, ref, rng);
+}
+
+int main() {
+  ASSERT(run<3>(), "FixedBTree difiere de BTree con M = 3");
+  ASSERT(run<4>(), "FixedBTree difiere de BTree con M = 4");
+  ASSERT(run<5>(), "FixedBTree difiere de BTree con M = 5");
+  ASSERT(run<16>(), "FixedBTree difiere de BTree con M = 16");
+  ASSERT(run<64>(), "FixedBTree difiere de BTree con M = 64");
+  return TrueAsserts == TotalAsserts ? 0 : 1;
+}
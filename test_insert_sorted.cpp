@@ -0,0 +1,140 @@
+// Prueba de insertSorted contra std::set: lotes ordenados antes de todas las
+// keys, despues de todas, intercalados con las existentes, hechos solo de
+// repetidos, con repetidos dentro del lote, y lotes densos mucho mas grandes
+// que los subarboles que cubren (que se reconstruyen en vez de recorrerse).
+// Despues de cada lote se verifican check_properties(), el contenido, la
+// cantidad devuelta y que el arbol siga aceptando insert/remove.
+//   g++ -std=c++17 -O2 test_insert_sorted.cpp -o test_insert_sorted
+#include <algorithm>
+#include <random>
+#include <set>
+#include <stdexcept>
+#include <vector>
+#include "btree.h"
+#include "tester.h"
+
+using namespace std;
+
+template <typename Aug>
+bool same(BTree<int, Aug>& t, const set<int>& ref) {
+  bool ok = t.check_properties() && t.size() == static_cast<int>(ref.size()) &&
+            vector<int>(t.begin(), t.end()) == vector<int>(ref.begin(), ref.end());
+  if constexpr (Aug::counted) {
+    long long i = 0;
+    for (auto it = ref.begin(); ok && it != ref.end(); ++it, ++i) ok = t.select(i) == *it && t.rank(*it) == i;
+  }
+  return ok;
+}
+
+// aplica el lote a ambos y verifica; despues toca los bordes y el medio
+template <typename Tree>
+bool merge(Tree& t, set<int>& ref, const vector<int>& batch, mt19937& rng) {
+  size_t before = ref.size();
+  ref.insert(batch.begin(), batch.end());
+  bool ok = t.insertSorted(batch) == ref.size() - before && same(t, ref);
+  int hi = ref.empty() ? 0 : *ref.rbegin();
+  int lo = ref.empty() ? 0 : *ref.begin();
+  for (int i = 1; i <= 20; ++i) {
+    t.insert(hi + i);
+    t.insert(lo - i);
+    ref.insert(hi + i);
+    ref.insert(lo - i);
+  }
+  for (int i = 0; i < 50 && !ref.empty(); ++i) {
+    int k = *next(ref.begin(), static_cast<long>(rng() % ref.size()));
+    t.remove(k);
+    ref.erase(k);
+  }
+  return ok && same(t, ref);
+}
+
+template <typename Tree>
+bool run(int M) {
+  mt19937 rng(M * 13 + 10);
+  bool ok = true;
+
+  // lote en un arbol vacio
+  {
+    Tree t(M);
+    set<int> ref;
+    vector<int> batch;
+    for (int k = 0; k < 5000; k += 2) batch.push_back(k);
+    ok = ok && merge(t, ref, batch, rng);
+  }
+
+  Tree t(M);
+  set<int> ref;
+  for (int k = 0; k < 20000; k += 10) {
+    t.insert(k);
+    ref.insert(k);
+  }
+  vector<int> batch;
+
+  // antes de todas las keys y despues de todas
+  for (int k = -30000; k < -25000; k += 3) batch.push_back(k);
+  ok = ok && merge(t, ref, batch, rng);
+  batch.clear();
+  for (int k = 50000; k < 60000; k += 7) batch.push_back(k);
+  ok = ok && merge(t, ref, batch, rng);
+
+  // intercalado con las keys existentes, esparcido por todo el arbol
+  batch.clear();
+  for (int k = 5; k < 20000; k += 10) batch.push_back(k);
+  ok = ok && merge(t, ref, batch, rng);
+
+  // solo keys ya presentes: no cambia nada
+  batch.assign(ref.begin(), ref.end());
+  size_t size = ref.size();
+  ok = ok && t.insertSorted(batch) == 0 && t.size() == static_cast<int>(size) && same(t, ref);
+
+  // repetidos dentro del lote, mezclados con keys nuevas y presentes
+  batch.clear();
+  for (int k = 1; k < 20000; k += 97) batch.insert(batch.end(), {k, k, k, k + 1});
+  ok = ok && merge(t, ref, batch, rng);
+
+  // lotes densos: cada hueco de 10 entre keys se llena, asi la parte del lote
+  // de muchos subarboles es mas grande que el subarbol y se reconstruyen
+  for (int slice = 0; slice < 3; ++slice) {
+    batch.clear();
+    int lo = static_cast<int>(rng() % 15000);
+    for (int k = lo; k < lo + 4000 + slice * 3000; ++k) batch.push_back(k);
+    ok = ok && merge(t, ref, batch, rng);
+  }
+  batch.clear();
+  for (int k = -40000; k < 70000; ++k) batch.push_back(k);
+  ok = ok && merge(t, ref, batch, rng);
+
+  // subarboles al minimo que reciben tantas keys como tienen: se
+  // reconstruyen en un solo subarbol y el padre no cambia de forma
+  {
+    Tree sparse(M);
+    set<int> ref_sparse;
+    for (int k = 0; k < 20000; k += 10) {
+      sparse.insert(k);
+      ref_sparse.insert(k);
+    }
+    sparse.compact(0.01);
+    batch.clear();
+    for (int k = 5; k < 20000; k += 10) batch.push_back(k);
+    ok = ok && merge(sparse, ref_sparse, batch, rng);
+  }
+
+  // lote desordenado: se rechaza sin tocar el arbol
+  size = ref.size();
+  bool threw = false;
+  try {
+    t.insertSorted(vector<int>{100001, 100003, 100002});
+  } catch (invalid_argument&) {
+    threw = true;
+  }
+  return ok && threw && t.size() == static_cast<int>(size) && same(t, ref);
+}
+
+int main() {
+  for (int M : {3, 4, 5, 8, 16, 64}) {
+    bool plain = run<BTree<int>>(M), counted = run<BTree<int, SubtreeSize>>(M);
+    ASSERT(plain, "insertSorted difiere de std::set con M = " << M);
+    ASSERT(counted, "insertSorted deja tamaños de subarbol incorrectos con M = " << M);
+  }
+  return TrueAsserts == TotalAsserts ? 0 : 1;
+}
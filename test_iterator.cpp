@@ -0,0 +1,117 @@
+// Prueba de los iteradores de BTree contra std::set: ++ desde begin() hasta
+// end(), -- desde end() hasta begin(), los reverse_iterator, y lower_bound,
+// upper_bound y find para cada key presente y para las que caen en los
+// huecos y fuera de los extremos, caminando hacia ambos lados desde el
+// iterador devuelto. Con M chico, arboles armados por insert, por remove y
+// por build_from_ordered_vector, y tambien con greater<> (transparente).
+//   g++ -std=c++17 -O2 test_iterator.cpp -o test_iterator
+#include <algorithm>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <random>
+#include <set>
+#include <vector>
+#include "btree.h"
+#include "tester.h"
+
+using namespace std;
+
+using Tree = BTree<int>;
+using GreaterTree = BTree<int, NoAugment, greater<>>;
+
+// desde it (del arbol) y ref_it (del set) da steps pasos hacia cada lado
+template <typename It, typename RefIt, typename Set>
+bool walk(It it, It begin, It end, RefIt ref_it, const Set& ref, int steps) {
+  if ((it == end) != (ref_it == ref.end())) return false;
+  if (it != end && *it != *ref_it) return false;
+  It fwd = it;
+  RefIt ref_fwd = ref_it;
+  for (int s = 0; s < steps && ref_fwd != ref.end(); ++s) {
+    ++fwd;
+    ++ref_fwd;
+    if ((fwd == end) != (ref_fwd == ref.end()) || (fwd != end && *fwd != *ref_fwd)) return false;
+  }
+  It back = it;
+  RefIt ref_back = ref_it;
+  for (int s = 0; s < steps && ref_back != ref.begin(); ++s) {
+    --back;
+    --ref_back;
+    if (back == end || *back != *ref_back) return false;
+  }
+  return ref_back != ref.begin() || back == begin;
+}
+
+template <typename T, typename Set>
+bool same(const T& t, const Set& ref, mt19937& rng) {
+  // recorridos completos en ambos sentidos
+  vector<int> expected(ref.begin(), ref.end());
+  if (vector<int>(t.begin(), t.end()) != expected) return false;
+  if (vector<int>(t.rbegin(), t.rend()) != vector<int>(ref.rbegin(), ref.rend())) return false;
+  vector<int> backwards;
+  for (auto it = t.end(); it != t.begin();) backwards.push_back(*--it);
+  if (backwards != vector<int>(ref.rbegin(), ref.rend())) return false;
+  // postfijos: devuelven la posicion anterior
+  if (!ref.empty()) {
+    auto it = t.begin();
+    if (*it++ != *ref.begin() || (ref.size() > 1 && *it != *next(ref.begin()))) return false;
+    auto last = t.end();
+    --last;
+    auto copy = last--;
+    if (*copy != *ref.rbegin() || (ref.size() > 1 && *last != *next(ref.rbegin()))) return false;
+  }
+
+  // busquedas: cada key, los huecos y fuera de los extremos
+  if (ref.empty()) return t.lower_bound(0) == t.end() && t.upper_bound(0) == t.end() && t.find(0) == t.end();
+  int lo = min(*ref.begin(), *ref.rbegin()) - 3, hi = max(*ref.begin(), *ref.rbegin()) + 3;
+  for (int k = lo; k <= hi; ++k) {
+    int steps = static_cast<int>(rng() % 4);
+    auto found = ref.find(k);
+    if (!walk(t.lower_bound(k), t.begin(), t.end(), ref.lower_bound(k), ref, steps)) return false;
+    if (!walk(t.upper_bound(k), t.begin(), t.end(), ref.upper_bound(k), ref, steps)) return false;
+    if (!walk(t.find(k), t.begin(), t.end(), found, ref, steps)) return false;
+  }
+  return true;
+}
+
+template <typename T, typename Set>
+bool run(int M) {
+  mt19937 rng(M * 6 + 1);
+  bool ok = true;
+  for (int size : {0, 1, 2, M, M * M, 700, 3000}) {
+    // por insert, con huecos para las busquedas que no aciertan
+    T t(M);
+    Set ref;
+    while (static_cast<int>(ref.size()) < size) {
+      int k = static_cast<int>(rng() % (size * 4 + 1)) * 2;
+      t.insert(k);
+      ref.insert(k);
+    }
+    ok = ok && same(t, ref, rng);
+
+    // despues de borrar: nodos al minimo, borrows y merges
+    for (int i = 0; i < size * 2 / 3; ++i) {
+      int k = *next(ref.begin(), static_cast<long>(rng() % ref.size()));
+      t.remove(k);
+      ref.erase(k);
+    }
+    ok = ok && same(t, ref, rng);
+
+    // de abajo hacia arriba, con los nodos llenos
+    unique_ptr<T> built(T::build_from_ordered_vector(vector<int>(ref.begin(), ref.end()), M));
+    ok = ok && same(*built, ref, rng);
+  }
+  return ok;
+}
+
+int main() {
+  for (int M : {3, 4, 5, 16}) {
+    bool less_ok = run<Tree, set<int>>(M);
+    ASSERT(less_ok, "los iteradores difieren de std::set con M = " << M);
+  }
+  for (int M : {3, 8}) {
+    bool greater_ok = run<GreaterTree, set<int, greater<>>>(M);
+    ASSERT(greater_ok, "los iteradores con greater<> difieren de std::set con M = " << M);
+  }
+  return TrueAsserts == TotalAsserts ? 0 : 1;
+}
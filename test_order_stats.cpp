@@ -0,0 +1,89 @@
+// Prueba diferencial de rank, select y rangeCount (BTree<TK, SubtreeSize>)
+// contra std::set, verificando despues de cada insert y remove. Con M chico
+// (3 y 4) los tamaños guardados pasan seguido por split, borrow, merge y el
+// reemplazo por el sucesor; las rachas de keys crecientes y decrecientes
+// pasan por la insercion en los bordes, y TopDown por su propio camino.
+//   g++ -std=c++17 -O2 test_order_stats.cpp -o test_order_stats
+#include <iterator>
+#include <random>
+#include <set>
+#include <stdexcept>
+#include <vector>
+#include "btree.h"
+#include "tester.h"
+
+using namespace std;
+
+using CountedTree = BTree<int, SubtreeSize>;
+using TopDownCountedTree = BTree<int, SubtreeSize, less<int>, TopDown>;
+
+// todas las estadisticas contra el conjunto de referencia
+template <typename Tree>
+bool consistent(Tree& t, const set<int>& ref, mt19937& rng) {
+  if (!t.check_properties() || t.size() != static_cast<int>(ref.size())) return false;
+  long long i = 0;
+  for (int k : ref) {
+    if (t.rank(k) != i || t.select(i) != k) return false;
+    i++;
+  }
+  for (int q = 0; q < 8; ++q) {
+    int a = static_cast<int>(rng() % 1600) - 300, b = a + static_cast<int>(rng() % 400);
+    long long expected = distance(ref.lower_bound(a), ref.upper_bound(b));
+    if (t.rank(a) != distance(ref.begin(), ref.lower_bound(a))) return false;
+    if (t.rangeCount(a, b) != expected || t.rangeCount(b, a) != expected) return false;
+  }
+  return true;
+}
+
+template <typename Tree>
+bool run(int M) {
+  mt19937 rng(M * 7 + 1);
+  Tree t(M);
+  set<int> ref;
+  bool ok = true;
+  auto insert = [&](int k) {
+    t.insert(k);
+    ref.insert(k);
+    ok = ok && consistent(t, ref, rng);
+  };
+  auto remove = [&](int k) {
+    t.remove(k);
+    ref.erase(k);
+    ok = ok && consistent(t, ref, rng);
+  };
+
+  for (int round = 0; round < 3 && ok; ++round) {
+    // al azar, primero creciendo y despues achicandose
+    for (int i = 0; i < 1500 && ok; ++i) {
+      int k = static_cast<int>(rng() % 1000);
+      if (rng() % 10 < (i < 900 ? 7 : 3))
+        insert(k);
+      else
+        remove(k);
+    }
+    // rachas en los bordes: mayores que el maximo y menores que el minimo
+    int hi = ref.empty() ? 1000 : *ref.rbegin() + 1;
+    for (int k = hi; k < hi + 150 && ok; ++k) insert(k);
+    int lo = ref.empty() ? -1 : *ref.begin() - 1;
+    for (int k = lo; k > lo - 150 && ok; --k) insert(k);
+    // borrar desde los extremos y desde el medio
+    for (int i = 0; i < 100 && ok && !ref.empty(); ++i) remove(*ref.begin());
+    for (int i = 0; i < 100 && ok && !ref.empty(); ++i) remove(*ref.rbegin());
+    for (int i = 0; i < 150 && ok && !ref.empty(); ++i) remove(*next(ref.begin(), static_cast<long>(rng() % ref.size())));
+  }
+  while (ok && !ref.empty()) remove(*next(ref.begin(), static_cast<long>(rng() % ref.size())));
+
+  bool threw = false;
+  try {
+    t.select(0);
+  } catch (out_of_range&) {
+    threw = true;
+  }
+  return ok && threw && t.rank(5) == 0 && t.rangeCount(0, 100) == 0;
+}
+
+int main() {
+  for (int M : {3, 4, 5}) ASSERT(run<CountedTree>(M), "rank/select/rangeCount difieren con M = " << M);
+  for (int M : {4, 6}) ASSERT(run<TopDownCountedTree>(M), "rank/select/rangeCount difieren con TopDown y M = " << M);
+  return TrueAsserts == TotalAsserts ? 0 : 1;
+}
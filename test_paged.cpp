@@ -0,0 +1,110 @@
+// Prueba de PagedBTree contra std::set con un buffer pool de 16 marcos,
+// mucho mas chico que el arbol, para que cada operacion desaloje y vuelva a
+// leer paginas: insert/remove al azar, check_properties(), flush y reapertura
+// del archivo, y la reutilizacion de las paginas liberadas (vaciar el arbol y
+// volverlo a llenar no agranda el archivo, tampoco despues de reabrir).
+//   g++ -std=c++17 -O2 test_paged.cpp -o test_paged
+#include <algorithm>
+#include <filesystem>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+#include <unistd.h>
+#include "paged_btree.h"
+#include "tester.h"
+
+using namespace std;
+
+const size_t kFrames = 16;
+
+bool same(PagedBTree<int>& t, const set<int>& ref) {
+  if (!t.check_properties() || t.size() != static_cast<int>(ref.size())) return false;
+  if (t.rangeSearch(INT32_MIN, INT32_MAX) != vector<int>(ref.begin(), ref.end())) return false;
+  return ref.empty() || (t.minKey() == *ref.begin() && t.maxKey() == *ref.rbegin());
+}
+
+void run(size_t page_size) {
+  string path = (filesystem::temp_directory_path() /
+                 ("test_paged_" + to_string(getpid()) + "_" + to_string(page_size) + ".db"))
+                    .string();
+  filesystem::remove(path);
+  mt19937 rng(static_cast<unsigned>(page_size));
+  set<int> ref;
+
+  {
+    PagedBTree<int> t(path, kFrames, page_size);
+    bool ok = true;
+    for (int i = 0; i < 60000 && ok; ++i) {
+      int k = static_cast<int>(rng() % 40000);
+      // crece hasta la mitad y despues se achica
+      if (rng() % 10 < (i < 40000 ? 7 : 3))
+        ok = t.insert(k) == ref.insert(k).second;
+      else
+        ok = t.remove(k) == (ref.erase(k) == 1);
+      if (i % 5000 == 0) ok = ok && same(t, ref);
+      if (i % 97 == 0) ok = ok && t.search(k) == (ref.count(k) == 1);
+    }
+    size_t pages = t.page_count();
+    ASSERT(ok && same(t, ref), "PagedBTree difiere de std::set con paginas de " << page_size << " bytes");
+    ASSERT(pages > 8 * kFrames && t.statistics().evictions > 0,
+           "El arbol no es mas grande que el pool con paginas de " << page_size << " bytes");
+    t.flush();
+  }
+
+  // reabrir: el contenido sale del archivo
+  {
+    PagedBTree<int> t(path, kFrames);
+    ASSERT(t.page_bytes() == page_size && same(t, ref),
+           "El arbol reabierto difiere con paginas de " << page_size << " bytes");
+
+    // borrar y volver a insertar la mitad, en otro orden
+    vector<int> keys(ref.begin(), ref.end());
+    bool ok = true;
+    for (int cycle = 0; cycle < 3 && ok; ++cycle) {
+      shuffle(keys.begin(), keys.end(), rng);
+      for (size_t i = 0; i < keys.size() / 2; ++i) ok = ok && t.remove(keys[i]);
+      for (size_t i = 0; i < keys.size() / 2; ++i) ok = ok && t.insert(keys[i]);
+    }
+    ASSERT(ok && same(t, ref), "PagedBTree difiere tras borrar y reinsertar con paginas de " << page_size << " bytes");
+    for (int k : keys) ok = ok && t.remove(k);
+    ASSERT(ok && same(t, set<int>()), "El arbol no queda vacio con paginas de " << page_size << " bytes");
+  }
+  filesystem::remove(path);
+
+  // paginas liberadas: vaciar el arbol y volver a llenarlo con la misma
+  // secuencia arma el mismo arbol, que debe caber en las paginas liberadas
+  // sin agrandar el archivo, tambien con la lista libre leida al reabrir
+  vector<int> keys(ref.begin(), ref.end());
+  shuffle(keys.begin(), keys.end(), rng);
+  size_t pages = 0;
+  {
+    PagedBTree<int> t(path, kFrames, page_size);
+    bool ok = true;
+    for (int k : keys) ok = ok && t.insert(k);
+    pages = t.page_count();
+    for (int round = 0; round < 2 && ok; ++round) {
+      for (int k : keys) ok = ok && t.remove(k);
+      for (int k : keys) ok = ok && t.insert(k);
+    }
+    ASSERT(ok && same(t, ref) && t.page_count() == pages,
+           "page_count crece al vaciar y volver a llenar con paginas de " << page_size << " bytes: " << pages
+                                                                           << " -> " << t.page_count());
+    for (int k : keys) ok = ok && t.remove(k);
+    ASSERT(ok && t.page_count() == pages, "Vaciar el arbol cambia page_count con paginas de " << page_size << " bytes");
+  }
+  {
+    PagedBTree<int> t(path, kFrames);
+    bool ok = same(t, set<int>());
+    for (int k : keys) ok = ok && t.insert(k);
+    ASSERT(ok && same(t, ref) && t.page_count() == pages,
+           "Las paginas liberadas no se reusan tras reabrir con paginas de " << page_size << " bytes: " << pages
+                                                                             << " -> " << t.page_count());
+  }
+  filesystem::remove(path);
+}
+
+int main() {
+  for (size_t page_size : {128, 256, 512}) run(page_size);
+  return TrueAsserts == TotalAsserts ? 0 : 1;
+}
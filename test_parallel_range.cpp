@@ -0,0 +1,99 @@
+// Prueba de rangeSearch(begin, end, threads) y rangeSearchChunks contra
+// std::set: el resultado repartido entre hilos debe salir completo y en
+// orden, con y sin SubtreeSize (que escribe cada tarea en su tramo), para
+// rangos al azar, invertidos, vacios, de una sola key, con bordes ausentes y
+// fuera de los extremos, en arboles armados por insert, despues de muchos
+// remove y por build_from_ordered_vector. Los tramos de rangeSearchChunks,
+// ordenados por su numero, deben concatenar el mismo resultado.
+//   g++ -std=c++17 -O2 test_parallel_range.cpp -o test_parallel_range -pthread
+#include <iterator>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <set>
+#include <vector>
+#include "btree.h"
+#include "tester.h"
+
+using namespace std;
+
+using CountedTree = BTree<int, SubtreeSize>;
+
+vector<int> expected(const set<int>& ref, int a, int b) {
+  if (b < a) swap(a, b);
+  return vector<int>(ref.lower_bound(a), ref.upper_bound(b));
+}
+
+template <typename Tree>
+bool chunks_match(const Tree& t, int a, int b, unsigned threads, const vector<int>& want) {
+  mutex m;
+  map<size_t, vector<int>> chunks;
+  bool ok = true;
+  t.rangeSearchChunks(a, b, threads, [&](size_t chunk, const int* keys, size_t count) {
+    lock_guard<mutex> lock(m);
+    ok = ok && count > 0 && chunks.count(chunk) == 0;
+    chunks[chunk].assign(keys, keys + count);
+  });
+  vector<int> joined;
+  for (auto& c : chunks) joined.insert(joined.end(), c.second.begin(), c.second.end());
+  return ok && joined == want;
+}
+
+template <typename Tree>
+bool same(const Tree& t, const set<int>& ref, mt19937& rng) {
+  int lo = ref.empty() ? 0 : *ref.begin(), hi = ref.empty() ? 0 : *ref.rbegin();
+  int span = hi - lo + 1;
+  vector<pair<int, int>> ranges = {{lo - 10, hi + 10}, {lo, hi}, {hi, lo}, {lo, lo}, {hi, hi},
+                                   {hi + 1, hi + 50}, {lo - 50, lo - 1}, {lo + span / 3, lo + 2 * span / 3}};
+  for (int i = 0; i < 12; ++i) {
+    int a = lo - 5 + static_cast<int>(rng() % (span + 10)), b = lo - 5 + static_cast<int>(rng() % (span + 10));
+    ranges.push_back({a, b});
+    ranges.push_back({a, a + static_cast<int>(rng() % 20)});  // angostos: pocas keys
+  }
+  for (auto& r : ranges) {
+    vector<int> want = expected(ref, r.first, r.second);
+    for (unsigned threads : {1u, 2u, 3u, 4u, 8u, 17u}) {
+      if (t.rangeSearch(r.first, r.second, threads) != want) return false;
+      if (!chunks_match(t, r.first, r.second, threads, want)) return false;
+    }
+  }
+  return true;
+}
+
+template <typename Tree>
+bool run(int M) {
+  mt19937 rng(M * 16 + 7);
+  bool ok = true;
+  for (int size : {0, 1, 2, M, 500, 20000, 120000}) {
+    Tree t(M);
+    set<int> ref;
+    while (static_cast<int>(ref.size()) < size) {
+      int k = static_cast<int>(rng() % (size * 3 + 1));
+      t.insert(k);
+      ref.insert(k);
+    }
+    ok = ok && same(t, ref, rng);
+
+    // arbol ralo: nodos al minimo y huecos grandes
+    for (int i = 0; i < size * 3 / 4; ++i) {
+      int k = static_cast<int>(rng() % (size * 3 + 1));
+      t.remove(k);
+      ref.erase(k);
+    }
+    ok = ok && same(t, ref, rng);
+
+    unique_ptr<Tree> built(Tree::build_from_ordered_vector(vector<int>(ref.begin(), ref.end()), M));
+    ok = ok && same(*built, ref, rng);
+  }
+  return ok;
+}
+
+int main() {
+  for (int M : {3, 4, 16, 64}) {
+    bool plain = run<BTree<int>>(M), counted = run<CountedTree>(M);
+    ASSERT(plain, "rangeSearch en paralelo difiere de std::set con M = " << M);
+    ASSERT(counted, "rangeSearch en paralelo con SubtreeSize difiere de std::set con M = " << M);
+  }
+  return TrueAsserts == TotalAsserts ? 0 : 1;
+}
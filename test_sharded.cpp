@@ -0,0 +1,179 @@
+// Prueba de ShardedBTree contra std::set alrededor de los rebalanceos:
+// keys crecientes (que cargan siempre el ultimo shard), decrecientes, al
+// azar y borrados masivos, con rebalance() explicito y los automaticos de
+// las escrituras. Despues de cada rebalanceo se comparan el contenido (por
+// for_each, el iterador y rangeSearch), size, shard_sizes, minKey/maxKey,
+// search y check_properties(). Tambien escritores concurrentes sobre rangos
+// disjuntos mientras se rebalancea, y un rebalance() cuya construccion
+// falla en los hilos y debe dejar el arbol como estaba.
+//   g++ -std=c++17 -O2 test_sharded.cpp -o test_sharded -pthread
+#include <iterator>
+#include <numeric>
+#include <random>
+#include <set>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#include "sharded_btree.h"
+#include "tester.h"
+
+using namespace std;
+
+bool same(const ShardedBTree<int>& t, const set<int>& ref, unsigned shards, mt19937& rng) {
+  vector<int> want(ref.begin(), ref.end()), visited;
+  t.for_each([&](int k) { visited.push_back(k); });
+  if (!t.check_properties() || t.size() != static_cast<int>(ref.size())) return false;
+  if (visited != want || vector<int>(t.begin(), t.end()) != want) return false;
+  vector<int> sizes = t.shard_sizes();
+  if (accumulate(sizes.begin(), sizes.end(), 0) != t.size() || t.shard_count() > shards) return false;
+  if (ref.empty()) return t.rangeSearch(INT32_MIN, INT32_MAX).empty();
+  if (t.minKey() != *ref.begin() || t.maxKey() != *ref.rbegin()) return false;
+  int lo = *ref.begin(), hi = *ref.rbegin();
+  for (int q = 0; q < 20; ++q) {
+    int a = lo - 10 + static_cast<int>(rng() % static_cast<unsigned>(hi - lo + 20));
+    int b = a + static_cast<int>(rng() % 20000);
+    if (t.rangeSearch(b, a) != vector<int>(ref.lower_bound(a), ref.upper_bound(b))) return false;
+    if (t.search(a) != (ref.count(a) == 1)) return false;
+  }
+  return t.rangeSearch(lo - 1, hi + 1) == want;
+}
+
+bool run(int M, unsigned shards) {
+  mt19937 rng(M * 15 + shards);
+  ShardedBTree<int> t(M, shards);
+  set<int> ref;
+  bool ok = true;
+  int seen = t.rebalance_count();
+  // verifica cada vez que hubo un rebalanceo automatico
+  auto after = [&]() {
+    if (t.rebalance_count() != seen) {
+      seen = t.rebalance_count();
+      ok = ok && same(t, ref, shards, rng);
+    }
+  };
+  auto insert = [&](int k) {
+    ok = ok && t.insert(k) == ref.insert(k).second;
+    after();
+  };
+  auto remove = [&](int k) {
+    ok = ok && t.remove(k) == (ref.erase(k) == 1);
+    after();
+  };
+
+  // crecientes: el ultimo shard se desbalancea una y otra vez (con un solo
+  // shard no hay rebalanceos automaticos)
+  for (int k = 0; k < 120000 && ok; ++k) insert(k * 2);
+  int automatic = t.rebalance_count();
+  // decrecientes, por debajo de todo
+  for (int k = -1; k > -60000 && ok; --k) insert(k * 2);
+  // al azar, tambien en los huecos
+  for (int i = 0; i < 100000 && ok; ++i) {
+    int k = static_cast<int>(rng() % 400000) - 150000;
+    if (rng() % 3)
+      insert(k);
+    else
+      remove(k);
+  }
+  t.rebalance();
+  ok = ok && same(t, ref, shards, rng);
+
+  // borrar casi todo un rango: shards que quedan vacios o casi
+  for (int k = -150000; k < 100000 && ok; ++k)
+    if (ref.count(k)) remove(k);
+  t.rebalance();
+  ok = ok && same(t, ref, shards, rng);
+  while (ok && !ref.empty()) remove(*ref.begin());
+  t.rebalance();
+  ok = ok && same(t, ref, shards, rng);
+  return ok && (shards == 1 || automatic > 0);
+}
+
+// hilos que escriben en rangos disjuntos mientras los rebalanceos cambian
+// los shards; al final el arbol debe tener exactamente lo esperado
+bool concurrent(int M, unsigned shards, unsigned threads) {
+  ShardedBTree<int> t(M, shards);
+  vector<thread> workers;
+  for (unsigned w = 0; w < threads; ++w) {
+    workers.emplace_back([&t, w] {
+      mt19937 rng(w);
+      int base = static_cast<int>(w) * 1000000;
+      for (int k = 0; k < 40000; ++k) t.insert(base + k);
+      for (int i = 0; i < 20000; ++i) t.remove(base + static_cast<int>(rng() % 40000) / 2 * 2 + 1);
+      if (w == 0) t.rebalance();
+    });
+  }
+  for (thread& w : workers) w.join();
+
+  set<int> ref;
+  for (unsigned w = 0; w < threads; ++w) {
+    mt19937 rng(w);
+    int base = static_cast<int>(w) * 1000000;
+    for (int k = 0; k < 40000; ++k) ref.insert(base + k);
+    for (int i = 0; i < 20000; ++i) ref.erase(base + static_cast<int>(rng() % 40000) / 2 * 2 + 1);
+  }
+  mt19937 rng(7);
+  return same(t, ref, shards, rng) && t.rebalance_count() > 0;
+}
+
+// limites dados al construir: la primera mitad de las keys cae en un solo
+// shard hasta que se rebalancea
+bool with_splitters(int M) {
+  ShardedBTree<int> t(M, vector<int>{0, 100000, 200000});
+  set<int> ref;
+  mt19937 rng(M);
+  bool ok = t.shard_count() == 4;
+  for (int i = 0; i < 50000; ++i) {
+    int k = static_cast<int>(rng() % 100000);
+    ok = ok && t.insert(k) == ref.insert(k).second;
+  }
+  ok = ok && same(t, ref, 4, rng);
+  t.rebalance();
+  return ok && same(t, ref, 4, rng);
+}
+
+// key que no se deja copiar fuera del hilo principal: la construccion de
+// los shards en los hilos de rebalance() falla
+struct Fragile {
+  static thread::id home;
+  int k = 0;
+  Fragile() = default;
+  Fragile(int _k) : k(_k) {}
+  Fragile(const Fragile& o) : k(o.k) {
+    if (this_thread::get_id() != home) throw runtime_error("copia en otro hilo");
+  }
+  Fragile& operator=(const Fragile& o) = default;
+  bool operator<(const Fragile& o) const { return k < o.k; }
+};
+thread::id Fragile::home = this_thread::get_id();
+
+bool failed_rebalance() {
+  ShardedBTree<Fragile> t(8, vector<Fragile>{1000});
+  for (int k = 0; k < 5000; ++k) t.insert(Fragile(k * 3));
+  vector<int> before_sizes = t.shard_sizes(), before, after;
+  t.for_each([&](const Fragile& f) { before.push_back(f.k); });
+  bool threw = false;
+  try {
+    t.rebalance();
+  } catch (const runtime_error&) {
+    threw = true;
+  }
+  t.for_each([&](const Fragile& f) { after.push_back(f.k); });
+  return threw && t.shard_count() == 2 && t.shard_sizes() == before_sizes && after == before &&
+         t.rebalance_count() == 0 && t.check_properties() && t.search(Fragile(2997)) && !t.search(Fragile(2998));
+}
+
+int main() {
+  for (int M : {4, 32}) {
+    for (unsigned shards : {1u, 3u, 8u}) {
+      bool ok = run(M, shards);
+      ASSERT(ok, "ShardedBTree difiere de std::set tras rebalancear con M = " << M << " y " << shards << " shards");
+    }
+  }
+  bool given = with_splitters(8);
+  ASSERT(given, "ShardedBTree con splitters iniciales difiere de std::set");
+  bool parallel = concurrent(16, 4, 4);
+  ASSERT(parallel, "ShardedBTree difiere de std::set con escritores concurrentes");
+  bool kept = failed_rebalance();
+  ASSERT(kept, "Un rebalance() fallido en los hilos cambio el ShardedBTree");
+  return TrueAsserts == TotalAsserts ? 0 : 1;
+}
@@ -0,0 +1,166 @@
+// Prueba de los constructores en streaming (build_from_stream,
+// build_from_file, build_from_sorted_range y build_from_generator) contra
+// build_from_ordered_vector y std::set. Con la cantidad conocida el arbol
+// debe salir con la misma forma que build_from_ordered_vector (se compara el
+// archivo de save()); sin la cantidad, el mismo contenido y un arbol valido.
+// Los tamaños rodean los bordes de los bloques de kStreamChunk keys. Tambien
+// se verifican los rechazos: keys desordenadas o repetidas, un stream que
+// termina en medio de una key y una cantidad esperada que no coincide.
+//   g++ -std=c++17 -O2 test_stream_build.cpp -o test_stream_build
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <random>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <unistd.h>
+#include "btree.h"
+#include "tester.h"
+
+using namespace std;
+
+using Tree = BTree<int>;
+
+const string dir = filesystem::temp_directory_path().string();
+const string pid = to_string(getpid());
+const string shape_a = dir + "/test_stream_build_a_" + pid + ".bin";
+const string shape_b = dir + "/test_stream_build_b_" + pid + ".bin";
+const string keys_file = dir + "/test_stream_build_keys_" + pid + ".bin";
+
+string read_all(const string& path) {
+  ifstream in(path, ios::binary);
+  return string(istreambuf_iterator<char>(in), istreambuf_iterator<char>());
+}
+
+string as_bytes(const vector<int>& keys) {
+  return string(reinterpret_cast<const char*>(keys.data()), keys.size() * sizeof(int));
+}
+
+// mismo contenido y arbol valido, que sigue aceptando insert/remove
+bool same(Tree& t, const set<int>& ref) {
+  if (!t.check_properties() || t.size() != static_cast<int>(ref.size())) return false;
+  if (vector<int>(t.begin(), t.end()) != vector<int>(ref.begin(), ref.end())) return false;
+  set<int> more = ref;
+  for (int k = -5; k < 0; ++k) {
+    t.insert(k);
+    more.insert(k);
+  }
+  if (!ref.empty()) {
+    t.remove(*ref.rbegin());
+    more.erase(*ref.rbegin());
+  }
+  return t.check_properties() && vector<int>(t.begin(), t.end()) == vector<int>(more.begin(), more.end());
+}
+
+// misma forma: save() escribe los nodos por niveles con sus keys
+bool same_shape(const Tree& a, const Tree& b) {
+  a.save(shape_a);
+  b.save(shape_b);
+  return read_all(shape_a) == read_all(shape_b);
+}
+
+bool check(const vector<int>& keys, int M) {
+  set<int> ref(keys.begin(), keys.end());
+  long long n = static_cast<long long>(keys.size());
+  unique_ptr<Tree> expected(Tree::build_from_ordered_vector(keys, M));
+  bool ok = expected->height() >= 0;
+
+  {
+    ofstream out(keys_file, ios::binary);
+    out << as_bytes(keys);
+  }
+  istringstream known(as_bytes(keys)), unknown(as_bytes(keys));
+  size_t pos = 0;
+  auto next = [&](int& key) {
+    if (pos == keys.size()) return false;
+    key = keys[pos++];
+    return true;
+  };
+  unique_ptr<Tree> from_stream(Tree::build_from_stream(known, M, n));
+  unique_ptr<Tree> from_file(Tree::build_from_file(keys_file, M));
+  unique_ptr<Tree> from_range(Tree::build_from_sorted_range(keys.begin(), keys.end(), M, n));
+  unique_ptr<Tree> from_generator(Tree::build_from_generator(next, M, n));
+  ok = ok && same_shape(*expected, *from_stream) && same_shape(*expected, *from_file) &&
+       same_shape(*expected, *from_range) && same_shape(*expected, *from_generator);
+  ok = ok && same(*from_stream, ref) && same(*from_file, ref) && same(*from_range, ref) && same(*from_generator, ref);
+
+  // sin la cantidad: otra forma, el mismo contenido
+  pos = 0;
+  unique_ptr<Tree> stream_unknown(Tree::build_from_stream(unknown, M));
+  unique_ptr<Tree> range_unknown(Tree::build_from_sorted_range(keys.begin(), keys.end(), M));
+  unique_ptr<Tree> generator_unknown(Tree::build_from_generator(next, M));
+  ok = ok && same(*stream_unknown, ref) && same(*range_unknown, ref) && same(*generator_unknown, ref);
+  return ok && same(*expected, ref);
+}
+
+// true si build lanza una excepcion del tipo E
+template <typename E, typename F>
+bool throws(F build) {
+  try {
+    delete build();
+  } catch (E&) {
+    return true;
+  }
+  return false;
+}
+
+int main() {
+  const int chunk = static_cast<int>(1 << 16);  // kStreamChunk
+  mt19937 rng(18);
+  for (int M : {3, 4, 5, 16, 64}) {
+    vector<int> sizes = {0, 1, 2, M - 1, M, M + 1, M * M, chunk - 1, chunk, chunk + 1, 3 * chunk + 7};
+    for (int i = 0; i < 4; ++i) sizes.push_back(static_cast<int>(rng() % 5000));
+    bool ok = true;
+    for (int size : sizes) {
+      // keys crecientes con huecos al azar
+      vector<int> keys(size);
+      int k = static_cast<int>(rng() % 100);
+      for (int& key : keys) key = k += 1 + static_cast<int>(rng() % 5);
+      if (!check(keys, M)) {
+        ok = false;
+        cout << "  difiere con " << size << " keys" << endl;
+      }
+    }
+    ASSERT(ok, "los constructores en streaming difieren de build_from_ordered_vector con M = " << M);
+  }
+
+  // rechazos
+  vector<int> unsorted = {1, 2, 5, 4, 7}, repeated = {1, 2, 2, 3};
+  bool order = true;
+  for (long long n : {-1LL, 5LL}) {
+    order = order && throws<invalid_argument>([&] {
+              istringstream in(as_bytes(unsorted));
+              return Tree::build_from_stream(in, 4, n);
+            });
+    order = order && throws<invalid_argument>([&] {
+              return Tree::build_from_sorted_range(repeated.begin(), repeated.end(), 4, n < 0 ? n : 4);
+            });
+  }
+  ASSERT(order, "se aceptan keys desordenadas o repetidas");
+
+  string torn = as_bytes({1, 2, 3});
+  torn.pop_back();
+  {
+    ofstream out(keys_file, ios::binary);
+    out << torn;
+  }
+  bool partial = throws<runtime_error>([&] {
+                   istringstream in(torn);
+                   return Tree::build_from_stream(in, 4);
+                 }) &&
+                 throws<runtime_error>([&] { return Tree::build_from_file(keys_file, 4); });
+  ASSERT(partial, "se acepta un stream que termina en medio de una key");
+
+  vector<int> three = {1, 2, 3};
+  bool count = throws<invalid_argument>([&] { return Tree::build_from_sorted_range(three.begin(), three.end(), 4, 2); }) &&
+               throws<invalid_argument>([&] { return Tree::build_from_sorted_range(three.begin(), three.end(), 4, 4); }) &&
+               throws<invalid_argument>([&] { return Tree::build_from_sorted_range(three.begin(), three.end(), 4, 0); });
+  ASSERT(count, "se acepta una cantidad esperada distinta de la del stream");
+
+  for (const string& path : {shape_a, shape_b, keys_file}) filesystem::remove(path);
+  return TrueAsserts == TotalAsserts ? 0 : 1;
+}
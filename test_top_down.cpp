@@ -0,0 +1,104 @@
+// Prueba diferencial de la politica TopDown contra std::set: inserciones y
+// borrados al azar (tambien sobre un arbol construido en bloque), con
+// check_properties() y el contenido comparados periodicamente, y los M que
+// check_order() debe rechazar.
+//   g++ -std=c++17 -O2 test_top_down.cpp -o test_top_down
+#include <random>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "btree.h"
+#include "tester.h"
+
+using namespace std;
+
+using PlainTree = BTree<int, NoAugment, less<int>, TopDown>;
+using CountedTree = BTree<int, SubtreeSize, less<int>, TopDown>;
+
+template <typename Tree, typename Set>
+bool same(Tree& t, const Set& ref) {
+  using K = typename Set::value_type;
+  return t.check_properties() && t.size() == static_cast<int>(ref.size()) &&
+         vector<K>(t.begin(), t.end()) == vector<K>(ref.begin(), ref.end());
+}
+
+template <typename Tree>
+bool rejects(int M) {
+  try {
+    Tree t(M);
+  } catch (invalid_argument&) {
+    return true;
+  }
+  return false;
+}
+
+int main() {
+  for (int M : {4, 6, 8, 16, 64}) {
+    mt19937 rng(M);
+    PlainTree plain(M);
+    CountedTree counted(M);
+    BTree<string, NoAugment, less<>, TopDown> text(M);
+    set<int> ref;
+    set<string> ref_text;
+
+    bool ok = true;
+    for (int i = 0; i < 100000; ++i) {
+      int k = static_cast<int>(rng() % 6000);
+      if (rng() % 2) {
+        plain.insert(k);
+        counted.insert(k);
+        text.insert(to_string(k));
+        ref.insert(k);
+        ref_text.insert(to_string(k));
+      } else {
+        plain.remove(k);
+        counted.remove(k);
+        text.remove(to_string(k));
+        ref.erase(k);
+        ref_text.erase(to_string(k));
+      }
+      if (i % 5000 == 0) {
+        ok = ok && same(plain, ref) && same(counted, ref) && same(text, ref_text);
+        long long lo = rng() % 6000;
+        ok = ok && counted.rank(static_cast<int>(lo)) == distance(ref.begin(), ref.lower_bound(static_cast<int>(lo)));
+      }
+    }
+    ASSERT(ok && same(plain, ref) && same(counted, ref) && same(text, ref_text),
+           "TopDown difiere de std::set con M = " << M);
+
+    for (int k : vector<int>(ref.begin(), ref.end())) {
+      plain.remove(k);
+      counted.remove(k);
+    }
+    ASSERT(plain.size() == 0 && counted.size() == 0 && plain.height() == 0 && plain.check_properties(),
+           "TopDown no queda vacio al borrar todo con M = " << M);
+
+    // arbol construido en bloque y despues modificado en una sola pasada
+    vector<int> even;
+    for (int i = 0; i < 40000; ++i) even.push_back(2 * i);
+    CountedTree* built = CountedTree::build_from_ordered_vector(even, M);
+    set<int> ref_built(even.begin(), even.end());
+    for (int i = 0; i < 50000; ++i) {
+      int k = static_cast<int>(rng() % 80000);
+      if (rng() % 2) {
+        built->insert(k);
+        ref_built.insert(k);
+      } else {
+        built->remove(k);
+        ref_built.erase(k);
+      }
+    }
+    ASSERT(same(*built, ref_built), "TopDown sobre build_from_ordered_vector difiere con M = " << M);
+    delete built;
+  }
+
+  // check_order: TopDown necesita M par y al menos 4
+  bool all_rejected = true;
+  for (int M : {1, 2, 3, 5, 7, 9, 63}) all_rejected = all_rejected && rejects<PlainTree>(M);
+  ASSERT(all_rejected, "check_order acepta un M impar o menor que 4");
+  bool valid_accepted = !rejects<PlainTree>(4) && !rejects<PlainTree>(10) && !rejects<BTree<int>>(3);
+  ASSERT(valid_accepted, "check_order rechaza un M valido");
+
+  return TrueAsserts == TotalAsserts ? 0 : 1;
+}